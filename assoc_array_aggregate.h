@@ -0,0 +1,34 @@
+#ifndef ASSOC_ARRAY_AGGREGATE_H
+#define ASSOC_ARRAY_AGGREGATE_H
+
+/* Range aggregates of avl_tree.c, available when it is compiled with LSQ_AVL_AUGMENTED. Every node then also keeps  *
+ * the count, sum, minimum and maximum of the values in its subtree, which makes a query over any key range cost     *
+ * O(log n) at the price of larger nodes and an O(log n) update on every modification. Values are best changed in    *
+ * place with LSQ_SetIteratorValue. A value written through the pointer LSQ_DereferenceIterator returns is picked    *
+ * up in O(log n) by the next dereference of another element, query or modification, and a pointer written again     *
+ * after that must be fetched again. Every dereference counts as a write, so reads should use LSQ_PeekIterator of    *
+ * linear_sequence_clone.h. LSQ_AGGREGATE_SUM_TYPE selects the type of the sum. The header expects                   *
+ * linear_sequence_assoc.h to be included first.                                                                     */
+
+#ifndef LSQ_AGGREGATE_SUM_TYPE
+#define LSQ_AGGREGATE_SUM_TYPE long long
+#endif
+
+typedef struct
+{
+	LSQ_IntegerIndexT count;
+	LSQ_AGGREGATE_SUM_TYPE sum;
+	/* Smallest and largest value, meaningful only when count is positive */
+	LSQ_BaseTypeT min;
+	LSQ_BaseTypeT max;
+} LSQ_AggregateT;
+
+/* Function that fills aggregate with the count, sum, minimum and maximum of the values whose keys lie in *
+ * [low_key, high_key)                                                                                     */
+extern void LSQ_GetRangeAggregate(LSQ_HandleT handle, LSQ_IntegerIndexT low_key, LSQ_IntegerIndexT high_key,
+								  LSQ_AggregateT * aggregate);
+
+/* Function that sets the value of the element of a dereferencable iterator and updates the aggregates in O(log n) */
+extern void LSQ_SetIteratorValue(LSQ_IteratorT iterator, LSQ_BaseTypeT value);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef ASSOC_ARRAY_BATCH_H
+#define ASSOC_ARRAY_BATCH_H
+
+/* Batch operations of avl_tree.c. The header expects linear_sequence_assoc.h to be included first */
+
+/* Function that inserts count key-value pairs at once. Existing keys get the new value, and when a key repeats *
+ * within the batch the last occurrence wins. The batch does not need to be sorted                              */
+extern void LSQ_InsertElements(LSQ_HandleT handle, const LSQ_IntegerIndexT * keys, const LSQ_BaseTypeT * values,
+							   LSQ_IntegerIndexT count);
+/* Function that looks up count keys at once and stores a pointer to the value of each key in values, or NULL for *
+ * a missing key. The descents of several keys are interleaved so that their cache misses overlap, which pays off  *
+ * on large trees that do not fit in the cache. Returns the number of keys found. The pointers stay valid until the *
+ * tree is modified                                                                                                */
+extern LSQ_IntegerIndexT LSQ_GetElements(LSQ_HandleT handle, const LSQ_IntegerIndexT * keys,
+										 const LSQ_BaseTypeT ** values, LSQ_IntegerIndexT count);
+
+#endif
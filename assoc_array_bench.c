@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include "linear_sequence_assoc.h"
+#ifdef LSQ_BENCH_TREE_STATS
+#include "assoc_array_stats.h"
+#endif
+
+/* Multi-threaded throughput benchmark for the associative backends. Build it once per backend:          *
+ *     cc -O2 -pthread assoc_array_bench.c skip_list.c -o bench_skip_list                                 *
+ *     cc -O2 -pthread -DLSQ_BENCH_GLOBAL_LOCK assoc_array_bench.c avl_tree.c -o bench_avl_tree           *
+ * LSQ_BENCH_GLOBAL_LOCK serialises every call through one mutex, as required by single-threaded backends. *
+ * LSQ_BENCH_TREE_STATS also prints rotations and rebalancing steps per insertion or deletion and the final  *
+ * lookup depth, for the backends of assoc_array_stats.h. To compare the balancing schemes, build           *
+ *     cc -O2 -pthread -DLSQ_BENCH_GLOBAL_LOCK -DLSQ_BENCH_TREE_STATS assoc_array_bench.c rb_tree.c         *
+ * the same way for avl_tree.c and wavl_tree.c and run each with one thread on the same workloads, e.g.     *
+ *     bench 1 2000000 1000000 80 10 0     (insert-heavy)                                                 *
+ *     bench 1 2000000 1000000 10 80 0     (delete-heavy)                                                 *
+ *     bench 1 2000000 1000000 25 25 10    (mixed)                                                        *
+ * To compare point lookups, e.g. of hash_map.c and avl_tree.c, run one thread without updates or scans on  *
+ * a million keys:                                                                                          *
+ *     bench 1 2000000 2000000 0 0 0                                                                        *
+ * Usage: bench [threads] [operations per thread] [key range] [insert %] [delete %] [scan %] [scan length]  *
+ * The remaining share of operations are point lookups. The map is prefilled with every other key.         */
+
+typedef struct
+{
+	int thread_id;
+	int operations;
+	int key_range;
+	int insert_percent;
+	int delete_percent;
+	int scan_percent;
+	int scan_length;
+	long long checksum;
+	long long updates;
+} WorkerArgsT;
+
+static LSQ_HandleT map_handle = LSQ_HandleInvalid;
+
+#ifdef LSQ_BENCH_GLOBAL_LOCK
+static pthread_mutex_t map_lock = PTHREAD_MUTEX_INITIALIZER;
+#define BENCH_LOCK()   pthread_mutex_lock(&map_lock)
+#define BENCH_UNLOCK() pthread_mutex_unlock(&map_lock)
+#else
+#define BENCH_LOCK()
+#define BENCH_UNLOCK()
+#endif
+
+static unsigned int nextRandom(unsigned int * state)
+{
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static double elapsedSeconds(const struct timespec * start, const struct timespec * finish)
+{
+	return (finish->tv_sec - start->tv_sec) + (finish->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void * runWorker(void * arg)
+{
+	WorkerArgsT * args = (WorkerArgsT *)arg;
+	unsigned int seed = 2463534242u + 7919u * (unsigned int)args->thread_id;
+	LSQ_IteratorT iterator = NULL;
+	int i, j, op, key;
+	for (i = 0; i < args->operations; i++)
+	{
+		op = (int)(nextRandom(&seed) % 100);
+		key = (int)(nextRandom(&seed) % (unsigned int)args->key_range);
+		BENCH_LOCK();
+		if (op < args->insert_percent)
+		{
+			LSQ_InsertElement(map_handle, key, key);
+			args->updates++;
+		}
+		else if (op < args->insert_percent + args->delete_percent)
+		{
+			LSQ_DeleteElement(map_handle, key);
+			args->updates++;
+		}
+		else if (op < args->insert_percent + args->delete_percent + args->scan_percent)
+		{
+			iterator = LSQ_GetElementByIndex(map_handle, key & ~1);
+			for (j = 0; j < args->scan_length && LSQ_IsIteratorDereferencable(iterator); j++)
+			{
+				args->checksum += *LSQ_DereferenceIterator(iterator);
+				LSQ_AdvanceOneElement(iterator);
+			}
+			LSQ_DestroyIterator(iterator);
+		}
+		else
+		{
+			iterator = LSQ_GetElementByIndex(map_handle, key);
+			if (LSQ_IsIteratorDereferencable(iterator))
+				args->checksum += *LSQ_DereferenceIterator(iterator);
+			LSQ_DestroyIterator(iterator);
+		}
+		BENCH_UNLOCK();
+	}
+	return NULL;
+}
+
+int main(int argc, char ** argv)
+{
+	int threads = (argc > 1) ? atoi(argv[1]) : 4;
+	int operations = (argc > 2) ? atoi(argv[2]) : 1000000;
+	int key_range = (argc > 3) ? atoi(argv[3]) : 1000000;
+	int insert_percent = (argc > 4) ? atoi(argv[4]) : 20;
+	int delete_percent = (argc > 5) ? atoi(argv[5]) : 10;
+	int scan_percent = (argc > 6) ? atoi(argv[6]) : 10;
+	int scan_length = (argc > 7) ? atoi(argv[7]) : 100;
+	pthread_t * thread_ids = NULL;
+	WorkerArgsT * args = NULL;
+	struct timespec start, finish;
+	long long checksum = 0, updates = 0;
+	double seconds;
+#ifdef LSQ_BENCH_TREE_STATS
+	LSQ_TreeStatsT stats;
+#endif
+	int i;
+
+	if (threads < 1 || operations < 1 || key_range < 2)
+	{
+		fprintf(stderr, "usage: %s [threads] [operations] [key range] [insert %%] [delete %%] [scan %%] [scan length]\n", argv[0]);
+		return 1;
+	}
+	map_handle = LSQ_CreateSequence();
+	for (i = 0; i < key_range; i += 2)
+		LSQ_InsertElement(map_handle, i, i);
+#ifdef LSQ_BENCH_TREE_STATS
+	LSQ_ResetTreeStats(map_handle);
+#endif
+	thread_ids = (pthread_t *)malloc(threads * sizeof(pthread_t));
+	args = (WorkerArgsT *)malloc(threads * sizeof(WorkerArgsT));
+	if (thread_ids == NULL || args == NULL)
+		return 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < threads; i++)
+	{
+		args[i].thread_id = i;
+		args[i].operations = operations;
+		args[i].key_range = key_range;
+		args[i].insert_percent = insert_percent;
+		args[i].delete_percent = delete_percent;
+		args[i].scan_percent = scan_percent;
+		args[i].scan_length = scan_length;
+		args[i].checksum = 0;
+		args[i].updates = 0;
+		pthread_create(&thread_ids[i], NULL, runWorker, &args[i]);
+	}
+	for (i = 0; i < threads; i++)
+	{
+		pthread_join(thread_ids[i], NULL);
+		checksum += args[i].checksum;
+		updates += args[i].updates;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	seconds = elapsedSeconds(&start, &finish);
+	printf("threads %d, operations %lld, %.3f s, %.0f ops/s, final size %d, checksum %lld\n",
+		threads, (long long)threads * operations, seconds, threads * (double)operations / seconds,
+		LSQ_GetSize(map_handle), checksum);
+#ifdef LSQ_BENCH_TREE_STATS
+	LSQ_GetTreeStats(map_handle, &stats);
+	printf("rotations %.3f and rebalancing steps %.3f per update, height %d, average depth %.2f\n",
+		updates > 0 ? stats.rotations / (double)updates : 0.0, updates > 0 ? stats.rebalance_steps / (double)updates : 0.0,
+		stats.height, stats.average_depth);
+#endif
+	LSQ_DestroySequence(map_handle);
+	free(thread_ids);
+	free(args);
+	return 0;
+}
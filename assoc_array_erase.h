@@ -0,0 +1,15 @@
+#ifndef ASSOC_ARRAY_ERASE_H
+#define ASSOC_ARRAY_ERASE_H
+
+/* Predicate-based bulk removal of avl_tree.c. The header expects linear_sequence_assoc.h to be included first */
+
+/* Predicate of LSQ_EraseIf: returns non-zero if the element must be removed */
+typedef int (*LSQ_ErasePredicateT)(void * context, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+
+/* Function that removes every element for which predicate returns non-zero and returns the number removed. The     *
+ * predicate is called once per element in key order and must not modify the container. Large removals rebuild the *
+ * tree in one linear pass, small ones unlink the nodes in place. Returns -1 and removes nothing if memory for the  *
+ * list of removed keys cannot be allocated                                                                         */
+extern LSQ_IntegerIndexT LSQ_EraseIf(LSQ_HandleT handle, LSQ_ErasePredicateT predicate, void * context);
+
+#endif
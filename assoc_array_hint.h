@@ -0,0 +1,16 @@
+#ifndef ASSOC_ARRAY_HINT_H
+#define ASSOC_ARRAY_HINT_H
+
+/* Hinted insertion of avl_tree.c for keys that arrive nearly in order. A key greater than every key in the map is  *
+ * appended below the cached maximum in O(1) amortised, by LSQ_InsertElement as well. The header expects            *
+ * linear_sequence_assoc.h to be included first                                                                     */
+
+/* Function that inserts or updates key like LSQ_InsertElement, but climbs from the element of hint only as far as *
+ * needed to cover key before descending, which costs O(log d) for a key d positions away from the hint instead of  *
+ * O(log n). A past-rear hint starts from the largest key. The hint is then moved to the element of key, so passing *
+ * the same iterator with every key of a nearly sorted stream makes the insertions amortised O(1). A hint of another *
+ * map or LSQ_HandleInvalid makes it a plain LSQ_InsertElement                                                       */
+extern void LSQ_InsertElementWithHint(LSQ_HandleT handle, LSQ_IteratorT hint, LSQ_IntegerIndexT key,
+									  LSQ_BaseTypeT value);
+
+#endif
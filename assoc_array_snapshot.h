@@ -0,0 +1,11 @@
+#ifndef ASSOC_ARRAY_SNAPSHOT_H
+#define ASSOC_ARRAY_SNAPSHOT_H
+
+/* Point-in-time views of persistent_avl_tree.c. The header expects linear_sequence_assoc.h to be included first */
+
+/* Function that returns a snapshot of the container in O(1). The snapshot is an ordinary handle that shares all    *
+ * nodes with the original; both may be modified afterwards, and every update copies only the O(log n) nodes on its *
+ * path. A snapshot is released with LSQ_DestroySequence, and nodes are freed once no version references them.      */
+extern LSQ_HandleT LSQ_CreateSnapshot(LSQ_HandleT handle);
+
+#endif
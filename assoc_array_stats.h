@@ -0,0 +1,25 @@
+#ifndef ASSOC_ARRAY_STATS_H
+#define ASSOC_ARRAY_STATS_H
+
+/* Shape and rebalancing counters of the balanced search tree backends (avl_tree.c, rb_tree.c, wavl_tree.c), *
+ * used to compare the balancing schemes. The header expects linear_sequence_assoc.h to be included first.    */
+
+typedef struct
+{
+	/* Single rotations since creation or the last reset, a double rotation counts as two */
+	unsigned long long rotations;
+	/* Rebalancing steps since creation or the last reset: height updates for AVL, recolourings for red-black, *
+	 * promotions and demotions for weak AVL                                                                    */
+	unsigned long long rebalance_steps;
+	/* Number of nodes on the longest root-to-leaf path */
+	int height;
+	/* Average number of nodes visited by a successful lookup */
+	double average_depth;
+} LSQ_TreeStatsT;
+
+/* Function that fills stats. The shape fields are computed by walking the whole tree */
+extern void LSQ_GetTreeStats(LSQ_HandleT handle, LSQ_TreeStatsT * stats);
+/* Function that resets the rotation and rebalancing counters */
+extern void LSQ_ResetTreeStats(LSQ_HandleT handle);
+
+#endif
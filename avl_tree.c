@@ -1,8 +1,34 @@
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 #include "linear_sequence_assoc.h"
+#include "linear_sequence_allocator.h"
+#include "assoc_array_batch.h"
+#include "linear_sequence_clone.h"
+#include "assoc_array_stats.h"
+#include "assoc_array_erase.h"
+#include "assoc_array_hint.h"
+#ifdef LSQ_AVL_AUGMENTED
+#include "assoc_array_aggregate.h"
+#endif
 
 #define IS_HANDLE_INVALID(handle)        ((handle) == LSQ_HandleInvalid)
+/* A batch at least this many times smaller than the tree is merged by finger insertion, larger ones rebuild the tree */
+#define BATCH_REBUILD_RATIO 8
+/* Number of descents LSQ_GetElements keeps in flight, enough to cover the memory latency with prefetches */
+#define LOOKUP_LANES 16
+/* Maps of up to this many keys keep them in a sorted array inside the handle instead of allocating nodes. A tree *
+ * that deletions shrink to SMALL_MAP_RETURN_SIZE keys moves back into the array. Iterators find their key again  *
+ * after either move, and after a modification that shifts the array                                               */
+#define SMALL_MAP_CAPACITY 16
+#define SMALL_MAP_RETURN_SIZE (SMALL_MAP_CAPACITY / 2)
+/* LSQ_EraseIf rebuilds the tree once at least one node in this many is removed, fewer are unlinked one by one. *
+ * avl_tree_bench.c sets it to 0 or to a huge ratio to time either path alone                                   */
+#ifndef ERASE_REBUILD_RATIO
+#define ERASE_REBUILD_RATIO 4
+#endif
+/* Bound on the height of an AVL tree with fewer than 2^31 nodes, which is at most about 1.44 log2 n */
+#define MAX_TREE_HEIGHT 64
 
 typedef enum {
 	BT_AFTER_INSERT = 0,
@@ -24,27 +50,77 @@ typedef struct TreeNodeStruct
 	int height;
 	LSQ_IntegerIndexT key;
 	LSQ_BaseTypeT value;
+#ifdef LSQ_AVL_AUGMENTED
+	LSQ_AggregateT aggregate;
+#endif
 } TreeNodeT;
 
 typedef struct 
 {
 	TreeNodeT * root;
+	/* Node with the largest key, NULL until the next insertion looks it up again */
+	TreeNodeT * maximum;
 	int size;
+	const LSQ_AllocatorT * allocator;
+	/* Number of clones sharing the nodes, NULL while the tree is not shared */
+	int * share_count;
+	/* Changed whenever nodes that iterators may point to are replaced, after which they find their key again */
+	unsigned int version;
+	unsigned long long rotations;
+	unsigned long long rebalance_steps;
+#ifdef LSQ_AVL_AUGMENTED
+	/* Node whose value may have been changed through a pointer since the last dereference, modification or query */
+	TreeNodeT * written_node;
+#endif
+	/* Small map: while root is NULL the size entries are kept here sorted by key */
+	LSQ_IntegerIndexT small_keys[SMALL_MAP_CAPACITY];
+	LSQ_BaseTypeT small_values[SMALL_MAP_CAPACITY];
 } AVLTreeT;
 
 typedef struct
 {
 	AVLTreeT * tree;
 	TreeNodeT * node;
+	/* Position of the element in a small map, which has no nodes */
+	int slot;
+	/* Key of the element and the version of the tree it was found in */
+	LSQ_IntegerIndexT key;
+	unsigned int version;
 	IteratorStateT state;
+	const LSQ_AllocatorT * allocator;
 } IteratorT;
 
-static void treeWalkWithDestruction(TreeNodeT * root);
+typedef struct
+{
+	LSQ_IntegerIndexT key;
+	LSQ_BaseTypeT value;
+	LSQ_IntegerIndexT order;
+} BatchEntryT;
+
+/* In-order walk of LSQ_EraseIf that takes the tree apart. It keeps its path on a stack instead of following parent *
+ * pointers, so the nodes it has passed may be freed or relinked                                                    */
+typedef struct
+{
+	AVLTreeT * tree;
+	TreeNodeT * stack[MAX_TREE_HEIGHT];
+	TreeNodeT * node;
+	int depth;
+	/* Sorted keys of the nodes to free and the position of the next one */
+	const LSQ_IntegerIndexT * erased;
+	LSQ_IntegerIndexT erased_count;
+	LSQ_IntegerIndexT erased_next;
+} EraseWalkT;
+
+static void treeWalkWithDestruction(AVLTreeT * tree, TreeNodeT * root);
 static TreeNodeT * successor(TreeNodeT * node);
 static TreeNodeT * predecessor(TreeNodeT * node);
 static TreeNodeT * treeMaximum(TreeNodeT * root);
 static TreeNodeT * treeMinimum(TreeNodeT * root);
 static IteratorT * createIterator(LSQ_HandleT handle, TreeNodeT * node);
+static IteratorT * createSmallIterator(LSQ_HandleT handle, int slot);
+static __inline void rememberKey(IteratorT * iter);
+static __inline void syncIterator(IteratorT * iter);
+static void relocateIterator(IteratorT * iter);
 static void smallLeftRotate(AVLTreeT *tree, TreeNodeT *root);
 static void smallRightRotate(AVLTreeT *tree, TreeNodeT *root);
 static void restoreBalance(AVLTreeT *tree, TreeNodeT *node, BalancingTypeT balance);
@@ -54,6 +130,40 @@ static __inline int nodeBalanceFlag(const TreeNodeT* node);
 static __inline int maximum(int a, int b);
 static __inline void fixTreeHeight(TreeNodeT * root);
 static __inline int stopCriterion(BalancingTypeT balance);
+static TreeNodeT * createNode(AVLTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+static TreeNodeT * insertFromNode(AVLTreeT * tree, TreeNodeT * start, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+static void insertElement(AVLTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+static void deleteNode(AVLTreeT * tree, TreeNodeT * node);
+static TreeNodeT * climbToCover(TreeNodeT * node, LSQ_IntegerIndexT key);
+static TreeNodeT * cachedMaximum(AVLTreeT * tree);
+static TreeNodeT * buildBalancedTree(TreeNodeT ** nodes, int count, TreeNodeT * parent);
+static TreeNodeT * nextKeptNode(EraseWalkT * walk);
+static TreeNodeT * buildTreeFromWalk(EraseWalkT * walk, int count, TreeNodeT * parent);
+static int compareBatchEntries(const void * a, const void * b);
+static int sortBatch(BatchEntryT * entries, int count);
+static void mergeBatchByRebuild(AVLTreeT * tree, const BatchEntryT * entries, int count);
+static TreeNodeT * findNode(TreeNodeT * root, LSQ_IntegerIndexT key);
+static TreeNodeT * findNodeNotBelow(TreeNodeT * root, LSQ_IntegerIndexT key);
+static LSQ_IntegerIndexT findNodes(TreeNodeT * root, const LSQ_IntegerIndexT * keys, const LSQ_BaseTypeT ** values,
+								   LSQ_IntegerIndexT count);
+static TreeNodeT * copySubtree(AVLTreeT * tree, const TreeNodeT * node, TreeNodeT * parent);
+static void releaseNodes(AVLTreeT * tree);
+static int unshareTree(AVLTreeT * tree);
+static int sumDepths(const TreeNodeT * root, int depth, long long * total);
+static __inline int isSmallMap(const AVLTreeT * tree);
+static int smallMapSlot(const AVLTreeT * tree, LSQ_IntegerIndexT key);
+static int smallMapFind(const AVLTreeT * tree, LSQ_IntegerIndexT key);
+static int convertToTree(AVLTreeT * tree);
+static void convertToSmallMap(AVLTreeT * tree);
+static __inline void fixAggregate(TreeNodeT * node);
+static void refreshAggregates(TreeNodeT * node);
+static void addToAggregates(TreeNodeT * node, LSQ_BaseTypeT value);
+static void noteWrittenNode(AVLTreeT * tree, TreeNodeT * node);
+static void refreshWrittenNode(AVLTreeT * tree);
+#ifdef LSQ_AVL_AUGMENTED
+static void addToAggregate(LSQ_AggregateT * aggregate, const LSQ_AggregateT * part);
+static void addValueToAggregate(LSQ_AggregateT * aggregate, LSQ_BaseTypeT value);
+#endif
 
 static __inline int stopCriterion(BalancingTypeT balance){
 	return (int)balance;
@@ -76,6 +186,72 @@ static __inline void fixTreeHeight(TreeNodeT * root) {
 	root->height = 1 + maximum(treeHeight(root->l_child), treeHeight(root->r_child));
 }
 
+static __inline void fixAggregate(TreeNodeT * node) {
+#ifdef LSQ_AVL_AUGMENTED
+	node->aggregate.count = 0;
+	addValueToAggregate(&node->aggregate, node->value);
+	if (node->l_child != NULL)
+		addToAggregate(&node->aggregate, &node->l_child->aggregate);
+	if (node->r_child != NULL)
+		addToAggregate(&node->aggregate, &node->r_child->aggregate);
+#else
+	(void)node;
+#endif
+}
+
+/* Updates the aggregates from node up to the root after a change below node */
+static void refreshAggregates(TreeNodeT * node)
+{
+#ifdef LSQ_AVL_AUGMENTED
+	for (; node != NULL; node = node->parent)
+		fixAggregate(node);
+#else
+	(void)node;
+#endif
+}
+
+/* Adds a value about to be inserted below node to the aggregates up to the root. Unlike refreshAggregates it *
+ * does not read the siblings on the path, and the rotations that follow rebuild their nodes from children    *
+ * that are already up to date                                                                                */
+static void addToAggregates(TreeNodeT * node, LSQ_BaseTypeT value)
+{
+#ifdef LSQ_AVL_AUGMENTED
+	for (; node != NULL; node = node->parent)
+		addValueToAggregate(&node->aggregate, value);
+#else
+	(void)node;
+	(void)value;
+#endif
+}
+
+/* Makes node the one pending aggregate update, first bringing the path of the previous one up to date */
+static void noteWrittenNode(AVLTreeT * tree, TreeNodeT * node)
+{
+#ifdef LSQ_AVL_AUGMENTED
+	if (tree->written_node == node)
+		return;
+	refreshWrittenNode(tree);
+	tree->written_node = node;
+#else
+	(void)tree;
+	(void)node;
+#endif
+}
+
+/* Brings the aggregates up to date with the value written through a pointer in O(log n) and forgets the node, so *
+ * a pointer that is written again after a dereference, query or modification has to be fetched again            */
+static void refreshWrittenNode(AVLTreeT * tree)
+{
+#ifdef LSQ_AVL_AUGMENTED
+	if (tree->written_node == NULL)
+		return;
+	refreshAggregates(tree->written_node);
+	tree->written_node = NULL;
+#else
+	(void)tree;
+#endif
+}
+
 void replaceNode(AVLTreeT *tree, TreeNodeT *node, TreeNodeT *substitute)
 {
     if (substitute != NULL)
@@ -90,13 +266,13 @@ void replaceNode(AVLTreeT *tree, TreeNodeT *node, TreeNodeT *substitute)
             node->parent->r_child = substitute;
 }
 
-static void treeWalkWithDestruction(TreeNodeT * root) 
+static void treeWalkWithDestruction(AVLTreeT * tree, TreeNodeT * root) 
 {
 	if (root == NULL)
 		return;
-	treeWalkWithDestruction(root->r_child);
-	treeWalkWithDestruction(root->l_child);
-	free(root);
+	treeWalkWithDestruction(tree, root->r_child);
+	treeWalkWithDestruction(tree, root->l_child);
+	lsqDeallocate(tree->allocator, root, sizeof(TreeNodeT));
 }
 
 static TreeNodeT * successor(TreeNodeT * node)
@@ -174,6 +350,9 @@ static void smallLeftRotate(AVLTreeT *tree, TreeNodeT *root) {
 	root->parent = node;
 	fixTreeHeight(root);
 	fixTreeHeight(node);
+	fixAggregate(root);
+	fixAggregate(node);
+	tree->rotations++;
 }
 
 static void smallRightRotate(AVLTreeT *tree, TreeNodeT *root) {
@@ -197,6 +376,9 @@ static void smallRightRotate(AVLTreeT *tree, TreeNodeT *root) {
 	root->parent = node;
 	fixTreeHeight(root);
 	fixTreeHeight(node);
+	fixAggregate(root);
+	fixAggregate(node);
+	tree->rotations++;
 }
 
 static void bigLeftRotate(AVLTreeT *tree, TreeNodeT *root) {
@@ -221,11 +403,18 @@ static void restoreBalance(AVLTreeT *tree, TreeNodeT *node, BalancingTypeT balan
     while (node != NULL)
     {
 		fixTreeHeight(node);
+		if (balance == BT_AFTER_DELETE)
+			fixAggregate(node);
+		tree->rebalance_steps++;
         node_balance = nodeBalanceFlag(node);
         parent = node->parent;
 
         if (abs(node_balance) == stop_criterion)
+        {
+			if (balance == BT_AFTER_DELETE)
+				refreshAggregates(parent);
             return;
+        }
         else if (node_balance == -2)
         {
             if (nodeBalanceFlag(node->r_child) > 0)
@@ -242,36 +431,570 @@ static void restoreBalance(AVLTreeT *tree, TreeNodeT *node, BalancingTypeT balan
     }
 }
 
+static TreeNodeT * createNode(AVLTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	TreeNodeT * node = (TreeNodeT *)lsqAllocate(tree->allocator, sizeof(TreeNodeT));
+	if (node == NULL)
+		return NULL;
+	node->key = key;
+	node->value = value;
+	node->r_child = NULL;
+	node->l_child = NULL;
+	node->parent = NULL;
+	node->height = 0;
+	fixAggregate(node);
+	return node;
+}
+
+/* Descends from start, which must be an ancestor of the key position, and inserts or updates the key. *
+ * Returns the node holding the key, or NULL if allocation failed.                                    */
+static TreeNodeT * insertFromNode(AVLTreeT * tree, TreeNodeT * start, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	TreeNodeT *insert_node = NULL, 
+			  *node = start, 
+			  *parent = NULL;
+	while (node != NULL) 
+	{
+		parent = node;
+		if (key > node->key)
+			node = node->r_child; 
+		else if (key < node->key)
+			node = node->l_child;
+		else {
+			node->value = value;
+			refreshAggregates(node);
+			return node;
+		}
+	}
+	insert_node = createNode(tree, key, value);
+	if (insert_node == NULL)
+		return NULL;
+	addToAggregates(parent, value);
+	tree->size++;
+	if (tree->maximum != NULL && key > tree->maximum->key)
+		tree->maximum = insert_node;
+	insert_node->parent = parent; 
+	if (parent == NULL) 
+	{
+		tree->root = insert_node;
+		return insert_node;
+	}
+	if (key > parent->key)
+		parent->r_child = insert_node;
+	else
+		parent->l_child = insert_node;
+	restoreBalance(tree, parent, BT_AFTER_INSERT);
+	return insert_node;
+}
+
+/* Inserts or updates the key in either representation, moving a full small map into a tree first */
+static void insertElement(AVLTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	TreeNodeT * maximum = NULL;
+	int slot;
+	if (!isSmallMap(tree))
+	{
+		/* A key past the largest one is appended below the maximum without descending from the root */
+		maximum = cachedMaximum(tree);
+		insertFromNode(tree, (key > maximum->key) ? maximum : tree->root, key, value);
+		return;
+	}
+	slot = smallMapSlot(tree, key);
+	if (slot < tree->size && tree->small_keys[slot] == key)
+	{
+		tree->small_values[slot] = value;
+		return;
+	}
+	if (tree->size == SMALL_MAP_CAPACITY)
+	{
+		if (convertToTree(tree))
+			insertFromNode(tree, tree->root, key, value);
+		return;
+	}
+	memmove(tree->small_keys + slot + 1, tree->small_keys + slot, (tree->size - slot) * sizeof(LSQ_IntegerIndexT));
+	memmove(tree->small_values + slot + 1, tree->small_values + slot, (tree->size - slot) * sizeof(LSQ_BaseTypeT));
+	tree->small_keys[slot] = key;
+	tree->small_values[slot] = value;
+	tree->size++;
+	tree->version++;
+}
+
+/* Unlinks and frees the node. A node with two children takes over the key and value of its successor, whose *
+ * node is removed instead, so iterators on either key have to find it again                                 */
+static void deleteNode(AVLTreeT * tree, TreeNodeT * node)
+{
+	TreeNodeT * parent = NULL, * next = NULL;
+	tree->version++;
+	if (node->l_child != NULL && node->r_child != NULL)
+	{
+		next = treeMinimum(node->r_child);
+		if (next == tree->maximum)
+			tree->maximum = node;
+		node->key = next->key;
+		node->value = next->value;
+		node = next;
+	}
+	parent = node->parent;
+	/* The maximum has no right child, so its predecessor is its left child, which is then a leaf, or its parent */
+	if (node == tree->maximum)
+		tree->maximum = (node->l_child != NULL) ? node->l_child : parent;
+	replaceNode(tree, node, (node->l_child != NULL) ? node->l_child : node->r_child);
+	lsqDeallocate(tree->allocator, node, sizeof(TreeNodeT));
+	tree->size--;
+	restoreBalance(tree, parent, BT_AFTER_DELETE);
+}
+
+/* Finger search step: returns the lowest node on the way up from node whose subtree range covers key, or the node *
+ * holding key. Climbing out of a subtree on the side of key does not widen its range towards key, so such steps    *
+ * keep the lower node; past the largest key this is node itself. Costs O(log d) for a key d positions away.        */
+static TreeNodeT * climbToCover(TreeNodeT * node, LSQ_IntegerIndexT key)
+{
+	TreeNodeT * cover = node;
+	int ascending = key > node->key;
+	while (node->parent != NULL && node->key != key)
+	{
+		if (ascending ? node == node->parent->l_child : node == node->parent->r_child)
+		{
+			if (ascending ? key < node->parent->key : key > node->parent->key)
+				break;
+			cover = node->parent;
+		}
+		node = node->parent;
+	}
+	return cover;
+}
+
+/* Returns the node with the largest key of a non-empty tree, looking it up only after the cached one was dropped */
+static TreeNodeT * cachedMaximum(AVLTreeT * tree)
+{
+	if (tree->maximum == NULL)
+		tree->maximum = treeMaximum(tree->root);
+	return tree->maximum;
+}
+
+static TreeNodeT * buildBalancedTree(TreeNodeT ** nodes, int count, TreeNodeT * parent)
+{
+	int middle = count / 2;
+	TreeNodeT * root = NULL;
+	if (count == 0)
+		return NULL;
+	root = nodes[middle];
+	root->parent = parent;
+	root->l_child = buildBalancedTree(nodes, middle, root);
+	root->r_child = buildBalancedTree(nodes + middle + 1, count - middle - 1, root);
+	fixTreeHeight(root);
+	fixAggregate(root);
+	return root;
+}
+
+/* Returns the next node of the walk that is not erased, or NULL at the end, and frees the erased nodes it passes */
+static TreeNodeT * nextKeptNode(EraseWalkT * walk)
+{
+	TreeNodeT * node = NULL;
+	while (walk->node != NULL || walk->depth > 0)
+	{
+		for (; walk->node != NULL; walk->node = walk->node->l_child)
+			walk->stack[walk->depth++] = walk->node;
+		node = walk->stack[--walk->depth];
+		walk->node = node->r_child;
+		if (walk->erased_next == walk->erased_count || walk->erased[walk->erased_next] != node->key)
+			return node;
+		lsqDeallocate(walk->tree->allocator, node, sizeof(TreeNodeT));
+		walk->erased_next++;
+	}
+	return NULL;
+}
+
+/* Builds a balanced tree of the next count kept nodes of the walk. The walk is done with the child pointers of a *
+ * node once it returns it, so the nodes are relinked as they come                                              */
+static TreeNodeT * buildTreeFromWalk(EraseWalkT * walk, int count, TreeNodeT * parent)
+{
+	TreeNodeT * left = NULL, * root = NULL;
+	if (count == 0)
+		return NULL;
+	left = buildTreeFromWalk(walk, count / 2, NULL);
+	root = nextKeptNode(walk);
+	root->parent = parent;
+	root->l_child = left;
+	if (left != NULL)
+		left->parent = root;
+	root->r_child = buildTreeFromWalk(walk, count - count / 2 - 1, root);
+	fixTreeHeight(root);
+	fixAggregate(root);
+	return root;
+}
+
+static int compareBatchEntries(const void * a, const void * b)
+{
+	const BatchEntryT * first = (const BatchEntryT *)a, * second = (const BatchEntryT *)b;
+	if (first->key != second->key)
+		return (first->key < second->key) ? -1 : 1;
+	return (first->order < second->order) ? -1 : (first->order > second->order);
+}
+
+/* Sorts the batch by key and keeps only the last occurrence of every key. Returns the new count */
+static int sortBatch(BatchEntryT * entries, int count)
+{
+	int i, unique = 0;
+	qsort(entries, count, sizeof(BatchEntryT), compareBatchEntries);
+	for (i = 0; i < count; i++)
+	{
+		if (unique > 0 && entries[unique - 1].key == entries[i].key)
+			unique--;
+		entries[unique++] = entries[i];
+	}
+	return unique;
+}
+
+/* Merges the sorted batch with the in-order node sequence and rebuilds a perfectly balanced tree in O(n + m) */
+static void mergeBatchByRebuild(AVLTreeT * tree, const BatchEntryT * entries, int count)
+{
+	size_t nodes_size = (tree->size + count) * sizeof(TreeNodeT *);
+	TreeNodeT ** nodes = (TreeNodeT **)lsqAllocate(tree->allocator, nodes_size);
+	TreeNodeT * node = NULL, * new_node = NULL;
+	int i = 0, merged = 0;
+	if (nodes == NULL)
+	{
+		for (i = 0; i < count; i++)
+			insertFromNode(tree, tree->root, entries[i].key, entries[i].value);
+		return;
+	}
+	node = treeMinimum(tree->root);
+	while (node != NULL || i < count)
+	{
+		if (i < count && (node == NULL || entries[i].key < node->key))
+		{
+			new_node = createNode(tree, entries[i].key, entries[i].value);
+			i++;
+			if (new_node == NULL)
+				continue;
+			nodes[merged++] = new_node;
+			continue;
+		}
+		if (i < count && entries[i].key == node->key)
+			node->value = entries[i++].value;
+		nodes[merged++] = node;
+		node = successor(node);
+	}
+	tree->size = merged;
+	tree->root = buildBalancedTree(nodes, merged, NULL);
+	tree->maximum = NULL;
+	lsqDeallocate(tree->allocator, nodes, nodes_size);
+}
+
+static TreeNodeT * findNode(TreeNodeT * root, LSQ_IntegerIndexT key)
+{
+	while ((root != NULL) && (root->key != key))
+		root = (key > root->key) ? root->r_child : root->l_child;
+	return root;
+}
+
+/* Returns the node with the smallest key not less than key, or NULL */
+static TreeNodeT * findNodeNotBelow(TreeNodeT * root, LSQ_IntegerIndexT key)
+{
+	TreeNodeT * found = NULL;
+	while (root != NULL)
+	{
+		if (root->key < key)
+			root = root->r_child;
+		else
+		{
+			found = root;
+			root = root->l_child;
+		}
+	}
+	return found;
+}
+
+/* Looks the keys up in lanes that each descend one level per round. A lane whose descent ends takes the next key, *
+ * and the node every lane visits next is prefetched, so a round waits for one cache miss instead of LOOKUP_LANES  */
+static LSQ_IntegerIndexT findNodes(TreeNodeT * root, const LSQ_IntegerIndexT * keys, const LSQ_BaseTypeT ** values,
+								   LSQ_IntegerIndexT count)
+{
+	TreeNodeT * lane_nodes[LOOKUP_LANES];
+	LSQ_IntegerIndexT lane_keys[LOOKUP_LANES], next = 0, found = 0;
+	int lanes = 0, i;
+	while (lanes < LOOKUP_LANES && next < count)
+	{
+		lane_keys[lanes] = next++;
+		lane_nodes[lanes++] = root;
+	}
+	while (lanes > 0)
+	{
+		for (i = 0; i < lanes; i++)
+		{
+			TreeNodeT * node = lane_nodes[i];
+			LSQ_IntegerIndexT key = keys[lane_keys[i]];
+			if (node != NULL && node->key != key)
+			{
+				node = (key > node->key) ? node->r_child : node->l_child;
+				lane_nodes[i] = node;
+				__builtin_prefetch(node);
+				continue;
+			}
+			values[lane_keys[i]] = (node != NULL) ? &node->value : NULL;
+			found += (node != NULL);
+			if (next < count)
+			{
+				lane_keys[i] = next++;
+				lane_nodes[i] = root;
+				continue;
+			}
+			lanes--;
+			lane_keys[i] = lane_keys[lanes];
+			lane_nodes[i] = lane_nodes[lanes];
+			i--;
+		}
+	}
+	return found;
+}
+
+/* Returns a copy of the subtree with the same shape, or NULL after freeing the partial copy */
+static TreeNodeT * copySubtree(AVLTreeT * tree, const TreeNodeT * node, TreeNodeT * parent)
+{
+	TreeNodeT * copy = NULL;
+	if (node == NULL)
+		return NULL;
+	copy = (TreeNodeT *)lsqAllocate(tree->allocator, sizeof(TreeNodeT));
+	if (copy == NULL)
+		return NULL;
+	*copy = *node;
+	copy->parent = parent;
+	copy->l_child = copySubtree(tree, node->l_child, copy);
+	copy->r_child = copySubtree(tree, node->r_child, copy);
+	if ((node->l_child != NULL && copy->l_child == NULL) || (node->r_child != NULL && copy->r_child == NULL))
+	{
+		treeWalkWithDestruction(tree, copy);
+		return NULL;
+	}
+	return copy;
+}
+
+/* Drops the handle's reference to its nodes, which are freed unless other clones still share them */
+static void releaseNodes(AVLTreeT * tree)
+{
+	if (tree->share_count == NULL || __atomic_sub_fetch(tree->share_count, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		if (tree->share_count != NULL)
+			lsqDeallocate(tree->allocator, tree->share_count, sizeof(int));
+		treeWalkWithDestruction(tree, tree->root);
+	}
+	tree->share_count = NULL;
+	tree->root = NULL;
+	tree->maximum = NULL;
+	tree->version++;
+}
+
+/* Gives the handle nodes of its own before the tree is modified. Iterators of the handle keep pointing *
+ * into the shared nodes                                                                                */
+static int unshareTree(AVLTreeT * tree)
+{
+	TreeNodeT * root = NULL;
+	if (tree->share_count == NULL)
+		return 1;
+	if (__atomic_load_n(tree->share_count, __ATOMIC_ACQUIRE) == 1)
+	{
+		lsqDeallocate(tree->allocator, tree->share_count, sizeof(int));
+		tree->share_count = NULL;
+		return 1;
+	}
+	root = copySubtree(tree, tree->root, NULL);
+	if (root == NULL && tree->root != NULL)
+		return 0;
+	releaseNodes(tree);
+	tree->root = root;
+	return 1;
+}
+
+/* Returns the height of the subtree and adds the depths of its nodes to total */
+static int sumDepths(const TreeNodeT * root, int depth, long long * total)
+{
+	if (root == NULL)
+		return 0;
+	*total += depth;
+	return 1 + maximum(sumDepths(root->l_child, depth + 1, total), sumDepths(root->r_child, depth + 1, total));
+}
+
+static __inline int isSmallMap(const AVLTreeT * tree)
+{
+	return tree->root == NULL;
+}
+
+/* Returns the position of the first key of the small map that is not less than key */
+static int smallMapSlot(const AVLTreeT * tree, LSQ_IntegerIndexT key)
+{
+	int slot = 0, i;
+	for (i = 0; i < tree->size; i++)
+		slot += tree->small_keys[i] < key;
+	return slot;
+}
+
+/* Returns the position of key in the small map, or size if it is absent */
+static int smallMapFind(const AVLTreeT * tree, LSQ_IntegerIndexT key)
+{
+	int slot = smallMapSlot(tree, key);
+	return (slot < tree->size && tree->small_keys[slot] == key) ? slot : tree->size;
+}
+
+/* Moves the entries of a small map into a balanced tree, a tree is left as it is. Returns 0 if allocation failed */
+static int convertToTree(AVLTreeT * tree)
+{
+	TreeNodeT * nodes[SMALL_MAP_CAPACITY];
+	int i;
+	if (!isSmallMap(tree))
+		return 1;
+	for (i = 0; i < tree->size; i++)
+	{
+		nodes[i] = createNode(tree, tree->small_keys[i], tree->small_values[i]);
+		if (nodes[i] != NULL)
+			continue;
+		while (i-- > 0)
+			lsqDeallocate(tree->allocator, nodes[i], sizeof(TreeNodeT));
+		return 0;
+	}
+	tree->root = buildBalancedTree(nodes, tree->size, NULL);
+	tree->version++;
+	return 1;
+}
+
+/* Moves the entries of an unshared tree of at most SMALL_MAP_CAPACITY keys into the small map */
+static void convertToSmallMap(AVLTreeT * tree)
+{
+	TreeNodeT * node = NULL;
+	int slot = 0;
+	for (node = treeMinimum(tree->root); node != NULL; node = successor(node), slot++)
+	{
+		tree->small_keys[slot] = node->key;
+		tree->small_values[slot] = node->value;
+	}
+	releaseNodes(tree);
+}
+
+#ifdef LSQ_AVL_AUGMENTED
+static void addToAggregate(LSQ_AggregateT * aggregate, const LSQ_AggregateT * part)
+{
+	if (part->count == 0)
+		return;
+	if (aggregate->count == 0)
+	{
+		*aggregate = *part;
+		return;
+	}
+	aggregate->count += part->count;
+	aggregate->sum += part->sum;
+	if (part->min < aggregate->min)
+		aggregate->min = part->min;
+	if (part->max > aggregate->max)
+		aggregate->max = part->max;
+}
+
+static void addValueToAggregate(LSQ_AggregateT * aggregate, LSQ_BaseTypeT value)
+{
+	LSQ_AggregateT single;
+	single.count = 1;
+	single.sum = value;
+	single.min = value;
+	single.max = value;
+	addToAggregate(aggregate, &single);
+}
+#endif
+
 static IteratorT * createIterator(LSQ_HandleT handle, TreeNodeT * node)
 {
-	IteratorT * iterator = (IteratorT *)malloc(sizeof(IteratorT));
+	IteratorT * iterator = NULL;
 	if(IS_HANDLE_INVALID(handle)) 
 		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(((AVLTreeT *)handle)->allocator, sizeof(IteratorT));
 	if (iterator == NULL) 
 		return LSQ_HandleInvalid;
+	iterator->allocator = ((AVLTreeT *)handle)->allocator;
 	iterator->tree = (AVLTreeT *)handle;
 	iterator->node = node;
+	iterator->slot = 0;
+	iterator->key = 0;
+	iterator->version = iterator->tree->version;
 	iterator->state = node != NULL ? IST_DEREFERENCABLE : IST_PAST_REAR;
+	rememberKey(iterator);
 	return iterator;
 }
 
+static IteratorT * createSmallIterator(LSQ_HandleT handle, int slot)
+{
+	IteratorT * iterator = createIterator(handle, NULL);
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->slot = slot;
+	if (slot < iterator->tree->size)
+		iterator->state = IST_DEREFERENCABLE;
+	rememberKey(iterator);
+	return iterator;
+}
+
+static __inline void rememberKey(IteratorT * iter)
+{
+	if (iter->state == IST_DEREFERENCABLE)
+		iter->key = (iter->node != NULL) ? iter->node->key : iter->tree->small_keys[iter->slot];
+}
+
+static __inline void syncIterator(IteratorT * iter)
+{
+	if (iter->version != iter->tree->version)
+		relocateIterator(iter);
+}
+
+/* Finds the element of an iterator again by its key after the tree replaced the nodes or slots. An iterator whose *
+ * key has been removed moves to the next larger key                                                              */
+static void relocateIterator(IteratorT * iter)
+{
+	AVLTreeT * tree = iter->tree;
+	iter->version = tree->version;
+	iter->node = NULL;
+	if (iter->state != IST_DEREFERENCABLE)
+		return;
+	if (isSmallMap(tree))
+	{
+		iter->slot = smallMapSlot(tree, iter->key);
+		iter->state = (iter->slot < tree->size) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+	}
+	else
+	{
+		iter->node = findNodeNotBelow(tree->root, iter->key);
+		iter->state = (iter->node != NULL) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+	}
+	rememberKey(iter);
+}
+
 extern LSQ_HandleT LSQ_CreateSequence(void) 
 {
-	AVLTreeT * tree = (AVLTreeT *)malloc(sizeof(AVLTreeT));
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	AVLTreeT * tree = (AVLTreeT *)lsqAllocate(allocator, sizeof(AVLTreeT));
 	if (tree == NULL)
 		return LSQ_HandleInvalid;
+	tree->allocator = allocator;
 	tree->size = 0;
 	tree->root = NULL;
+	tree->maximum = NULL;
+	tree->share_count = NULL;
+	tree->version = 0;
+	tree->rotations = 0;
+	tree->rebalance_steps = 0;
+#ifdef LSQ_AVL_AUGMENTED
+	tree->written_node = NULL;
+#endif
 	return tree;
 }
 
 extern void LSQ_DestroySequence(LSQ_HandleT handle) 
 {
 	AVLTreeT * tree = (AVLTreeT *)handle;
-	if IS_HANDLE_INVALID(handle)
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(tree->allocator))
 		return;
-	treeWalkWithDestruction(tree->root);
-	free(tree);
+	releaseNodes(tree);
+	lsqDeallocate(tree->allocator, tree, sizeof(AVLTreeT));
 }
 
 extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
@@ -282,13 +1005,19 @@ extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
 extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
 {
 	IteratorT * iter = (IteratorT *)iterator;
-	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_DEREFERENCABLE;
+	if (IS_HANDLE_INVALID(iterator))
+		return 0;
+	syncIterator(iter);
+	return iter->state == IST_DEREFERENCABLE;
 }
 
 extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
 {	
 	IteratorT * iter = (IteratorT *)iterator;
-	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_PAST_REAR;
+	if (IS_HANDLE_INVALID(iterator))
+		return 0;
+	syncIterator(iter);
+	return iter->state == IST_PAST_REAR;
 }
 
 extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
@@ -300,25 +1029,34 @@ extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
 extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
 {
 	IteratorT * iter = (IteratorT *)iterator;
-	return !LSQ_IsIteratorDereferencable(iterator) ? NULL :
-		&iter->node->value;
+	if (!LSQ_IsIteratorDereferencable(iterator))
+		return NULL;
+	if (isSmallMap(iter->tree))
+		return &iter->tree->small_values[iter->slot];
+	if (iter->tree->share_count != NULL)
+	{
+		if (!unshareTree(iter->tree))
+			return NULL;
+		syncIterator(iter);
+	}
+	noteWrittenNode(iter->tree, iter->node);
+	return &iter->node->value;
 }
 
 extern LSQ_IntegerIndexT LSQ_GetIteratorKey(LSQ_IteratorT iterator) {
 	IteratorT * iter = (IteratorT *)iterator;
 	assert(LSQ_IsIteratorDereferencable(iterator));
-	return iter->node->key;
+	return iter->key;
 }
 
 extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
 {
 	AVLTreeT * tree = (AVLTreeT *)handle;
-	TreeNodeT * node = tree->root;
 	if IS_HANDLE_INVALID(handle)  
 		return LSQ_HandleInvalid;
-	while ((node != NULL) && (node->key != index)) 
-		node = (index > node->key) ? node->r_child : node->l_child;
-	return createIterator(handle, node);
+	if (isSmallMap(tree))
+		return createSmallIterator(handle, smallMapFind(tree, index));
+	return createIterator(handle, findNode(tree->root, index));
 }
 
 extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
@@ -326,6 +1064,8 @@ extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
 	AVLTreeT * tree = (AVLTreeT *)handle;
 	if IS_HANDLE_INVALID(handle)
 		return LSQ_HandleInvalid;
+	if (isSmallMap(tree))
+		return createSmallIterator(handle, 0);
 	return createIterator(handle, treeMinimum(tree->root));
 }
 
@@ -340,7 +1080,7 @@ extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
 {
 	if (IS_HANDLE_INVALID(iterator))  
 		return;
-	free(iterator);
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
 }
 
 extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
@@ -348,14 +1088,31 @@ extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
 	IteratorT * iter = (IteratorT *)iterator;
 	if (IS_HANDLE_INVALID(iterator) || (iter->tree->size == 0))
 		return;
+	syncIterator(iter);
+	if (isSmallMap(iter->tree))
+	{
+		if (LSQ_IsIteratorPastRear(iterator))
+			return;
+		iter->slot = LSQ_IsIteratorBeforeFirst(iterator) ? 0 : iter->slot + 1;
+		iter->state = (iter->slot < iter->tree->size) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+		rememberKey(iter);
+		return;
+	}
 	if (LSQ_IsIteratorBeforeFirst(iterator)){
 		iter->node = treeMinimum(iter->tree->root);	
 		iter->state = IST_DEREFERENCABLE;
+		rememberKey(iter);
 		return;
 	}
 	iter->node = successor(iter->node);
 	if (iter->node == NULL)
+	{
 		iter->state = IST_PAST_REAR;
+		return;
+	}
+	iter->key = iter->node->key;
+	/* The next successor is below the right child or above the node, start loading it while the caller works */
+	__builtin_prefetch((iter->node->r_child != NULL) ? iter->node->r_child : iter->node->parent);
 }
 
 extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
@@ -363,14 +1120,27 @@ extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
 	IteratorT * iter = (IteratorT *)iterator;
 	if (IS_HANDLE_INVALID(iterator) || (iter->tree->size == 0))
 		return;
+	syncIterator(iter);
+	if (isSmallMap(iter->tree))
+	{
+		if (LSQ_IsIteratorBeforeFirst(iterator))
+			return;
+		iter->slot = LSQ_IsIteratorPastRear(iterator) ? iter->tree->size - 1 : iter->slot - 1;
+		iter->state = (iter->slot >= 0) ? IST_DEREFERENCABLE : IST_BEFORE_FIRST;
+		rememberKey(iter);
+		return;
+	}
 	if (LSQ_IsIteratorPastRear(iterator)){
 		iter->node = treeMaximum(iter->tree->root);	
 		iter->state = IST_DEREFERENCABLE;
+		rememberKey(iter);
 		return;
 	}
 	iter->node = predecessor(iter->node);
 	if (iter->node == NULL)
 		iter->state = IST_BEFORE_FIRST;
+	else
+		iter->key = iter->node->key;
 }
 
 extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
@@ -396,49 +1166,126 @@ extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
 extern void LSQ_InsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
 {
 	AVLTreeT *tree = (AVLTreeT *)handle;
-	TreeNodeT *insert_node = NULL, 
-			  *node = NULL, 
-			  *parent = NULL;
-	if (IS_HANDLE_INVALID(handle))
+	if (IS_HANDLE_INVALID(handle) || !unshareTree(tree))
         return;
-	node = tree->root;
-	while (node != NULL) 
+	refreshWrittenNode(tree);
+	insertElement(tree, key, value);
+}
+
+extern void LSQ_InsertElementWithHint(LSQ_HandleT handle, LSQ_IteratorT hint, LSQ_IntegerIndexT key,
+									  LSQ_BaseTypeT value)
+{
+	AVLTreeT * tree = (AVLTreeT *)handle;
+	IteratorT * iter = (IteratorT *)hint;
+	TreeNodeT * start = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	if (IS_HANDLE_INVALID(hint) || iter->tree != tree)
 	{
-		parent = node;
-		if (key > node->key)
-			node = node->r_child; 
-		else if (key < node->key)
-			node = node->l_child;
-		else {
-			node->value = value;
-			return;
-		}
+		LSQ_InsertElement(handle, key, value);
+		return;
 	}
-	insert_node = (TreeNodeT *)malloc(sizeof(TreeNodeT));
-	if (insert_node == NULL)
+	/* Unsharing copies the nodes, and deletions free them; a hint from an older version finds its key again first */
+	if (!unshareTree(tree))
 		return;
-	insert_node->key = key;
-	insert_node->value = value;
-	insert_node->r_child = NULL;
-	insert_node->l_child = NULL;
-	tree->size++;
-	insert_node->parent = parent; 
-	if (parent == NULL) 
+	syncIterator(iter);
+	refreshWrittenNode(tree);
+	if (isSmallMap(tree))
 	{
-		tree->root = insert_node;
+		insertElement(tree, key, value);
+		iter->slot = isSmallMap(tree) ? smallMapFind(tree, key) : 0;
+		iter->node = isSmallMap(tree) ? NULL : findNode(tree->root, key);
+		iter->state = (iter->node != NULL || iter->slot < tree->size) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+		iter->version = tree->version;
+		rememberKey(iter);
 		return;
 	}
-	if (key > parent->key)
-		parent->r_child = insert_node;
+	/* A key past the largest one is appended at once, since the climb from anywhere would reach the root. A past-rear *
+	 * hint climbs from the maximum                                                                                     */
+	if (key > cachedMaximum(tree)->key)
+		start = tree->maximum;
+	else if (iter->state == IST_PAST_REAR)
+		start = climbToCover(tree->maximum, key);
+	else if (iter->state == IST_DEREFERENCABLE && iter->node != NULL)
+		start = climbToCover(iter->node, key);
 	else
-		parent->l_child = insert_node;
-	restoreBalance(tree, parent, BT_AFTER_INSERT);
+		start = tree->root;
+	iter->node = insertFromNode(tree, start, key, value);
+	iter->slot = 0;
+	iter->state = (iter->node != NULL) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+	iter->version = tree->version;
+	rememberKey(iter);
+}
+
+extern void LSQ_InsertElements(LSQ_HandleT handle, const LSQ_IntegerIndexT * keys, const LSQ_BaseTypeT * values,
+							   LSQ_IntegerIndexT count)
+{
+	AVLTreeT *tree = (AVLTreeT *)handle;
+	BatchEntryT * entries = NULL;
+	TreeNodeT * finger = NULL;
+	int i, unique;
+	if (IS_HANDLE_INVALID(handle) || count <= 0 || !unshareTree(tree))
+		return;
+	refreshWrittenNode(tree);
+	entries = (BatchEntryT *)lsqAllocate(tree->allocator, count * sizeof(BatchEntryT));
+	if (entries == NULL)
+	{
+		for (i = 0; i < count; i++)
+			insertElement(tree, keys[i], values[i]);
+		return;
+	}
+	for (i = 0; i < count; i++)
+	{
+		entries[i].key = keys[i];
+		entries[i].value = values[i];
+		entries[i].order = i;
+	}
+	unique = sortBatch(entries, count);
+	/* A batch that overflows the small map turns it into a tree first, and is dropped if that fails */
+	if (isSmallMap(tree) && tree->size + unique > SMALL_MAP_CAPACITY && !convertToTree(tree))
+		unique = 0;
+	if (isSmallMap(tree) && tree->size + unique <= SMALL_MAP_CAPACITY)
+	{
+		for (i = 0; i < unique; i++)
+			insertElement(tree, entries[i].key, entries[i].value);
+	}
+	else if ((long long)unique * BATCH_REBUILD_RATIO >= tree->size)
+		mergeBatchByRebuild(tree, entries, unique);
+	else
+	{
+		for (i = 0; i < unique; i++)
+		{
+			finger = insertFromNode(tree, (finger == NULL) ? tree->root : climbToCover(finger, entries[i].key),
+									entries[i].key, entries[i].value);
+		}
+	}
+	lsqDeallocate(tree->allocator, entries, count * sizeof(BatchEntryT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetElements(LSQ_HandleT handle, const LSQ_IntegerIndexT * keys,
+										 const LSQ_BaseTypeT ** values, LSQ_IntegerIndexT count)
+{
+	AVLTreeT * tree = (AVLTreeT *)handle;
+	LSQ_IntegerIndexT i, found = 0;
+	int slot;
+	if (IS_HANDLE_INVALID(handle) || count <= 0)
+		return 0;
+	if (!isSmallMap(tree))
+		return findNodes(tree->root, keys, values, count);
+	for (i = 0; i < count; i++)
+	{
+		slot = smallMapFind(tree, keys[i]);
+		values[i] = (slot < tree->size) ? &tree->small_values[slot] : NULL;
+		found += (slot < tree->size);
+	}
+	return found;
 }
 
 extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
 {
 	IteratorT *iterator = (IteratorT *)LSQ_GetFrontElement(handle);
-	LSQ_DeleteElement(handle, iterator->node->key);
+	if (LSQ_IsIteratorDereferencable(iterator))
+		LSQ_DeleteElement(handle, LSQ_GetIteratorKey(iterator));
 	LSQ_DestroyIterator(iterator);
 }
 
@@ -446,36 +1293,232 @@ extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
 {
 	IteratorT *iterator = (IteratorT *)LSQ_GetPastRearElement(handle);
 	LSQ_RewindOneElement(iterator);
-	LSQ_DeleteElement(handle, iterator->node->key);
+	if (LSQ_IsIteratorDereferencable(iterator))
+		LSQ_DeleteElement(handle, LSQ_GetIteratorKey(iterator));
 	LSQ_DestroyIterator(iterator);
 }
 
 extern void LSQ_DeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key) 
 {
 	AVLTreeT *tree = (AVLTreeT *)handle;
-	TreeNodeT *node = NULL, *parent = NULL;
-	IteratorT * iter = (IteratorT *)LSQ_GetElementByIndex(handle, key);
-    int new_key;
-    if (!LSQ_IsIteratorDereferencable(iter))
-        return;
+	int slot;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	if (isSmallMap(tree))
+	{
+		slot = smallMapFind(tree, key);
+		if (slot == tree->size)
+			return;
+		tree->size--;
+		memmove(tree->small_keys + slot, tree->small_keys + slot + 1, (tree->size - slot) * sizeof(LSQ_IntegerIndexT));
+		memmove(tree->small_values + slot, tree->small_values + slot + 1, (tree->size - slot) * sizeof(LSQ_BaseTypeT));
+		tree->version++;
+		return;
+	}
+	if (findNode(tree->root, key) == NULL || !unshareTree(tree))
+		return;
+	refreshWrittenNode(tree);
+	deleteNode(tree, findNode(tree->root, key));
+	if (tree->size <= SMALL_MAP_RETURN_SIZE)
+		convertToSmallMap(tree);
+}
 
-    parent = iter->node->parent;
-    if (iter->node->l_child == NULL && iter->node->r_child == NULL)
-        replaceNode(tree, iter->node, NULL);
-    else if (iter->node->l_child != NULL && iter->node->r_child != NULL)
-    {
-        node = successor(iter->node);
-        new_key = node->key;
-        iter->node->value = node->value;
-        LSQ_DeleteElement(handle, node->key);
-        iter->node->key = new_key;
-        return;
-    }
-    else if (iter->node->l_child != NULL)
-        replaceNode(tree, iter->node, iter->node->l_child);
-    else if (iter->node->r_child != NULL)
-        replaceNode(tree, iter->node, iter->node->r_child);
-    free(iter->node);
-    tree->size--;
-	restoreBalance(tree, parent, BT_AFTER_DELETE);
-}
\ No newline at end of file
+extern LSQ_IntegerIndexT LSQ_EraseIf(LSQ_HandleT handle, LSQ_ErasePredicateT predicate, void * context)
+{
+	AVLTreeT * tree = (AVLTreeT *)handle;
+	LSQ_IntegerIndexT * erased = NULL, * grown = NULL, count = 0, capacity = 0, new_capacity, i;
+	TreeNodeT * node = NULL;
+	EraseWalkT walk;
+	int slot, kept = 0;
+	if (IS_HANDLE_INVALID(handle) || predicate == NULL)
+		return -1;
+	if (isSmallMap(tree))
+	{
+		for (slot = 0; slot < tree->size; slot++)
+		{
+			if (predicate(context, tree->small_keys[slot], tree->small_values[slot]))
+				continue;
+			tree->small_keys[kept] = tree->small_keys[slot];
+			tree->small_values[kept++] = tree->small_values[slot];
+		}
+		count = tree->size - kept;
+		tree->size = kept;
+		tree->version += (count > 0);
+		return count;
+	}
+	/* The predicate sees the whole tree before it changes, the removed keys come out sorted */
+	for (node = treeMinimum(tree->root); node != NULL; node = successor(node))
+	{
+		if (!predicate(context, node->key, node->value))
+			continue;
+		if (count == capacity)
+		{
+			new_capacity = (capacity == 0) ? 64 : capacity * 2;
+			grown = (LSQ_IntegerIndexT *)lsqReallocate(tree->allocator, erased, capacity * sizeof(LSQ_IntegerIndexT),
+				new_capacity * sizeof(LSQ_IntegerIndexT));
+			if (grown == NULL)
+			{
+				lsqDeallocate(tree->allocator, erased, capacity * sizeof(LSQ_IntegerIndexT));
+				return -1;
+			}
+			erased = grown;
+			capacity = new_capacity;
+		}
+		erased[count++] = node->key;
+	}
+	if (count > 0 && !unshareTree(tree))
+		count = -1;
+	else if (count > 0)
+	{
+		refreshWrittenNode(tree);
+		if ((long long)count * ERASE_REBUILD_RATIO >= tree->size)
+		{
+			walk.tree = tree;
+			walk.node = tree->root;
+			walk.depth = 0;
+			walk.erased = erased;
+			walk.erased_count = count;
+			walk.erased_next = 0;
+			tree->size -= count;
+			tree->root = buildTreeFromWalk(&walk, tree->size, NULL);
+			tree->maximum = NULL;
+			tree->version++;
+			/* Frees the erased nodes after the last kept one */
+			nextKeptNode(&walk);
+		}
+		else
+		{
+			for (i = 0; i < count; i++)
+				deleteNode(tree, findNode(tree->root, erased[i]));
+		}
+		if (tree->size <= SMALL_MAP_RETURN_SIZE)
+			convertToSmallMap(tree);
+	}
+	lsqDeallocate(tree->allocator, erased, capacity * sizeof(LSQ_IntegerIndexT));
+	return count;
+}
+
+extern LSQ_HandleT LSQ_CloneSequence(LSQ_HandleT handle)
+{
+	AVLTreeT * tree = (AVLTreeT *)handle, * clone = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	/* The clone must not inherit the written node, which becomes shared */
+	refreshWrittenNode(tree);
+	if (tree->root != NULL && tree->share_count == NULL)
+	{
+		tree->share_count = (int *)lsqAllocate(tree->allocator, sizeof(int));
+		if (tree->share_count == NULL)
+			return LSQ_HandleInvalid;
+		*tree->share_count = 1;
+	}
+	clone = (AVLTreeT *)lsqAllocate(tree->allocator, sizeof(AVLTreeT));
+	if (clone == NULL)
+		return LSQ_HandleInvalid;
+	*clone = *tree;
+	if (tree->share_count != NULL)
+		__atomic_add_fetch(tree->share_count, 1, __ATOMIC_RELAXED);
+	return clone;
+}
+
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator))
+		return NULL;
+	return isSmallMap(iter->tree) ? &iter->tree->small_values[iter->slot] : &iter->node->value;
+}
+
+extern void LSQ_GetTreeStats(LSQ_HandleT handle, LSQ_TreeStatsT * stats)
+{
+	AVLTreeT * tree = (AVLTreeT *)handle;
+	long long total_depth = 0;
+	if (IS_HANDLE_INVALID(handle) || stats == NULL)
+		return;
+	stats->rotations = tree->rotations;
+	stats->rebalance_steps = tree->rebalance_steps;
+	stats->height = sumDepths(tree->root, 1, &total_depth);
+	stats->average_depth = (tree->size > 0) ? (double)total_depth / tree->size : 0.0;
+}
+
+extern void LSQ_ResetTreeStats(LSQ_HandleT handle)
+{
+	AVLTreeT * tree = (AVLTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	tree->rotations = 0;
+	tree->rebalance_steps = 0;
+}
+
+#ifdef LSQ_AVL_AUGMENTED
+extern void LSQ_GetRangeAggregate(LSQ_HandleT handle, LSQ_IntegerIndexT low_key, LSQ_IntegerIndexT high_key,
+								  LSQ_AggregateT * aggregate)
+{
+	AVLTreeT * tree = (AVLTreeT *)handle;
+	TreeNodeT * split = NULL, * node = NULL;
+	int slot;
+	if (aggregate == NULL)
+		return;
+	aggregate->count = 0;
+	aggregate->sum = 0;
+	aggregate->min = aggregate->max = 0;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	if (isSmallMap(tree))
+	{
+		for (slot = smallMapSlot(tree, low_key); slot < tree->size && tree->small_keys[slot] < high_key; slot++)
+			addValueToAggregate(aggregate, tree->small_values[slot]);
+		return;
+	}
+	refreshWrittenNode(tree);
+	/* Descend to the highest node inside the range, then add the whole subtrees hanging inside the range off the *
+	 * paths to its two ends                                                                                       */
+	split = tree->root;
+	while (split != NULL && (split->key < low_key || split->key >= high_key))
+		split = (split->key < low_key) ? split->r_child : split->l_child;
+	if (split == NULL)
+		return;
+	addValueToAggregate(aggregate, split->value);
+	for (node = split->l_child; node != NULL; )
+	{
+		if (node->key < low_key)
+		{
+			node = node->r_child;
+			continue;
+		}
+		addValueToAggregate(aggregate, node->value);
+		if (node->r_child != NULL)
+			addToAggregate(aggregate, &node->r_child->aggregate);
+		node = node->l_child;
+	}
+	for (node = split->r_child; node != NULL; )
+	{
+		if (node->key >= high_key)
+		{
+			node = node->l_child;
+			continue;
+		}
+		addValueToAggregate(aggregate, node->value);
+		if (node->l_child != NULL)
+			addToAggregate(aggregate, &node->l_child->aggregate);
+		node = node->r_child;
+	}
+}
+
+extern void LSQ_SetIteratorValue(LSQ_IteratorT iterator, LSQ_BaseTypeT value)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator))
+		return;
+	if (isSmallMap(iter->tree))
+	{
+		iter->tree->small_values[iter->slot] = value;
+		return;
+	}
+	if (!unshareTree(iter->tree))
+		return;
+	syncIterator(iter);
+	iter->node->value = value;
+	refreshAggregates(iter->node);
+}
+#endif
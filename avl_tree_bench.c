@@ -0,0 +1,471 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "linear_sequence_assoc.h"
+#include "assoc_array_batch.h"
+#include "assoc_array_erase.h"
+#include "assoc_array_hint.h"
+#include "linear_sequence_clone.h"
+#include "linear_sequence_allocator.h"
+#ifdef LSQ_AVL_AUGMENTED
+#include "assoc_array_aggregate.h"
+#endif
+
+/* Single-threaded benchmarks for the extensions of avl_tree.c:                                                    *
+ *     cc -O2 avl_tree_bench.c avl_tree.c -o bench_avl_tree                                                        *
+ *     cc -O2 -DLSQ_AVL_AUGMENTED avl_tree_bench.c avl_tree.c -o bench_avl_tree_augmented                          *
+ * Usage: bench batch [tree size] [batch size]                                                                     *
+ *        bench lookup [tree size] [lookups] [batch size]                                                          *
+ *        bench aggregate [tree size] [window] [queries]                                                           *
+ *        bench small [keys per map] [maps]                                                                        *
+ *        bench erase [tree size] [removed per mille] [sequential | random]                                        *
+ *        bench hint [keys] [jitter]                                                                               *
+ * batch builds two equal trees of random keys and upserts the same random keys into them, one at a time with      *
+ * LSQ_InsertElement and at once with LSQ_InsertElements. Keys are drawn from four times the tree size, so about   *
+ * a fifth of the batch overwrites existing keys.                                                                  *
+ * lookup looks up random keys in a tree built by random insertion, first one at a time with LSQ_GetElementByIndex *
+ * and then in batches with LSQ_GetElements; about two fifths of the keys are present. Trees much larger than the  *
+ * cache, e.g. of 4000000 keys, show the effect of the interleaved descents.                                       *
+ * aggregate inserts the keys below the tree size in random order and sums the values in windows of keys with an   *
+ * in-order scan. The augmented build also answers random windows with LSQ_GetRangeAggregate, then again with      *
+ * nine values written through LSQ_DereferenceIterator before each query, and checks the results against the       *
+ * scans. Comparing the insertion rates of both builds gives the cost of keeping the aggregates.                   *
+ * small fills many maps with a few keys each and reports the heap bytes per map, counted by an allocator, and the *
+ * time to build and scan one. Maps of up to 16 keys live inside their handle.                                     *
+ * erase removes a share of the elements of two equal trees, by collecting their keys in an in-order pass and      *
+ * deleting them one by one and with LSQ_EraseIf. The keys are inserted in key order or in a scattered order,      *
+ * which places the nodes in memory accordingly. Setting ERASE_REBUILD_RATIO times LSQ_EraseIf in one mode:        *
+ *     cc -O2 -DERASE_REBUILD_RATIO=0 avl_tree_bench.c avl_tree.c -o bench_erase_in_place                          *
+ *     cc -O2 -DERASE_REBUILD_RATIO=1000000000 avl_tree_bench.c avl_tree.c -o bench_erase_rebuild                  *
+ * hint inserts keys spaced 4 apart, each moved forward by a random jitter below the given one, into one tree with *
+ * LSQ_InsertElement and into another with LSQ_InsertElementWithHint and a single hint.                            */
+
+static unsigned int nextRandom(unsigned int * state)
+{
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static double elapsedSeconds(const struct timespec * start, const struct timespec * finish)
+{
+	return (finish->tv_sec - start->tv_sec) + (finish->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Creates a map of size insertions of random keys below key_range, with values equal to the keys */
+static LSQ_HandleT createRandomMap(int size, int key_range, unsigned int seed)
+{
+	LSQ_HandleT handle = LSQ_CreateSequence();
+	int i, key;
+	for (i = 0; i < size && handle != LSQ_HandleInvalid; i++)
+	{
+		key = (int)(nextRandom(&seed) % (unsigned int)key_range);
+		LSQ_InsertElement(handle, key, key);
+	}
+	return handle;
+}
+
+static int runBatch(int argc, char ** argv)
+{
+	int size = (argc > 0) ? atoi(argv[0]) : 1000000;
+	int count = (argc > 1) ? atoi(argv[1]) : 100000;
+	unsigned int seed = 88675123u;
+	LSQ_HandleT single = LSQ_HandleInvalid, batch = LSQ_HandleInvalid;
+	LSQ_IntegerIndexT * keys = NULL;
+	LSQ_BaseTypeT * values = NULL;
+	struct timespec start, middle, finish;
+	int i, initial_size;
+
+	if (size < 1 || count < 1)
+		return 0;
+	single = createRandomMap(size, 4 * size, 2463534242u);
+	batch = createRandomMap(size, 4 * size, 2463534242u);
+	keys = (LSQ_IntegerIndexT *)malloc(count * sizeof(LSQ_IntegerIndexT));
+	values = (LSQ_BaseTypeT *)malloc(count * sizeof(LSQ_BaseTypeT));
+	if (single == LSQ_HandleInvalid || batch == LSQ_HandleInvalid || keys == NULL || values == NULL)
+		return 0;
+	for (i = 0; i < count; i++)
+	{
+		keys[i] = (LSQ_IntegerIndexT)(nextRandom(&seed) % (4u * size));
+		values[i] = i;
+	}
+	initial_size = LSQ_GetSize(single);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; i++)
+		LSQ_InsertElement(single, keys[i], values[i]);
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+	LSQ_InsertElements(batch, keys, values, count);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	printf("tree of %d keys, %d upserts: %.3f s one at a time, %.3f s batched, final sizes %d and %d\n",
+		initial_size, count, elapsedSeconds(&start, &middle), elapsedSeconds(&middle, &finish), LSQ_GetSize(single),
+		LSQ_GetSize(batch));
+	LSQ_DestroySequence(single);
+	LSQ_DestroySequence(batch);
+	free(keys);
+	free(values);
+	return 1;
+}
+
+static int runLookup(int argc, char ** argv)
+{
+	int size = (argc > 0) ? atoi(argv[0]) : 4000000;
+	int count = (argc > 1) ? atoi(argv[1]) : 2000000;
+	int batch = (argc > 2) ? atoi(argv[2]) : 256;
+	unsigned int seed = 88675123u;
+	LSQ_HandleT handle = LSQ_HandleInvalid;
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_IntegerIndexT * keys = NULL;
+	const LSQ_BaseTypeT ** values = NULL;
+	struct timespec start, middle, finish;
+	long long single_sum = 0, batch_sum = 0;
+	int i, single_found = 0, batch_found = 0;
+
+	if (size < 1 || count < 1 || batch < 1)
+		return 0;
+	handle = createRandomMap(size, 2 * size, 2463534242u);
+	keys = (LSQ_IntegerIndexT *)malloc(count * sizeof(LSQ_IntegerIndexT));
+	values = (const LSQ_BaseTypeT **)malloc(count * sizeof(LSQ_BaseTypeT *));
+	if (handle == LSQ_HandleInvalid || keys == NULL || values == NULL)
+		return 0;
+	for (i = 0; i < count; i++)
+		keys[i] = (LSQ_IntegerIndexT)(nextRandom(&seed) % (2u * size));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; i++)
+	{
+		iterator = LSQ_GetElementByIndex(handle, keys[i]);
+		if (LSQ_IsIteratorDereferencable(iterator))
+		{
+			single_sum += *LSQ_DereferenceIterator(iterator);
+			single_found++;
+		}
+		LSQ_DestroyIterator(iterator);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+	for (i = 0; i < count; i += batch)
+		batch_found += LSQ_GetElements(handle, keys + i, values + i, (count - i < batch) ? count - i : batch);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	for (i = 0; i < count; i++)
+	{
+		if (values[i] != NULL)
+			batch_sum += *values[i];
+	}
+
+	printf("tree of %d keys, %d lookups: %.0f/s one at a time, %.0f/s in batches of %d, found %d and %d, "
+		"checksums %lld and %lld\n", LSQ_GetSize(handle), count, count / elapsedSeconds(&start, &middle),
+		count / elapsedSeconds(&middle, &finish), batch, single_found, batch_found, single_sum, batch_sum);
+	LSQ_DestroySequence(handle);
+	free(keys);
+	free(values);
+	return 1;
+}
+
+/* Returns the sum of the values of the keys in [low_key, high_key) found by an in-order scan */
+static long long scanWindow(LSQ_HandleT handle, LSQ_IntegerIndexT low_key, LSQ_IntegerIndexT high_key)
+{
+	LSQ_IteratorT iterator = LSQ_GetElementByIndex(handle, low_key);
+	long long sum = 0;
+	for (; LSQ_IsIteratorDereferencable(iterator) && LSQ_GetIteratorKey(iterator) < high_key;
+		 LSQ_AdvanceOneElement(iterator))
+		sum += *LSQ_PeekIterator(iterator);
+	LSQ_DestroyIterator(iterator);
+	return sum;
+}
+
+static int runAggregate(int argc, char ** argv)
+{
+	int size = (argc > 0) ? atoi(argv[0]) : 2000000;
+	int window = (argc > 1) ? atoi(argv[1]) : 400000;
+	int queries = (argc > 2) ? atoi(argv[2]) : 100000;
+	int scans = 20;
+	unsigned int seed = 2463534242u;
+	LSQ_HandleT handle = LSQ_HandleInvalid;
+	LSQ_IntegerIndexT * keys = NULL, key;
+	struct timespec start, finish;
+	long long checksum = 0;
+	int i, j;
+#ifdef LSQ_AVL_AUGMENTED
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_AggregateT aggregate;
+	int mismatches = 0, k;
+#endif
+
+	if (size < 1 || window < 1 || window > size || queries < 1)
+		return 0;
+	handle = LSQ_CreateSequence();
+	keys = (LSQ_IntegerIndexT *)malloc(size * sizeof(LSQ_IntegerIndexT));
+	if (handle == LSQ_HandleInvalid || keys == NULL)
+		return 0;
+	for (i = 0; i < size; i++)
+		keys[i] = i;
+	for (i = size - 1; i > 0; i--)
+	{
+		j = (int)(nextRandom(&seed) % (unsigned int)(i + 1));
+		key = keys[i];
+		keys[i] = keys[j];
+		keys[j] = key;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < size; i++)
+		LSQ_InsertElement(handle, keys[i], keys[i] & 1023);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	printf("%d insertions in random order: %.0f/s\n", size, size / elapsedSeconds(&start, &finish));
+
+	for (i = 0; i < scans; i++)
+		keys[i] = (LSQ_IntegerIndexT)(nextRandom(&seed) % (unsigned int)(size - window + 1));
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < scans; i++)
+		checksum += scanWindow(handle, keys[i], keys[i] + window);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	printf("windows of %d keys by in-order scan: %.1f/s, checksum %lld\n", window,
+		scans / elapsedSeconds(&start, &finish), checksum);
+
+#ifdef LSQ_AVL_AUGMENTED
+	iterator = LSQ_GetFrontElement(handle);
+	for (j = 0; j < 2; j++)
+	{
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (i = 0; i < queries; i++)
+		{
+			/* The second pass writes the next nine values through pointers before every query */
+			for (k = 0; j == 1 && k < 9; k++, LSQ_AdvanceOneElement(iterator))
+			{
+				if (!LSQ_IsIteratorDereferencable(iterator))
+					LSQ_SetPosition(iterator, 0);
+				checksum += ++*LSQ_DereferenceIterator(iterator);
+			}
+			key = (LSQ_IntegerIndexT)(nextRandom(&seed) % (unsigned int)(size - window + 1));
+			LSQ_GetRangeAggregate(handle, key, key + window, &aggregate);
+			checksum += aggregate.sum;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &finish);
+		printf("windows of %d keys by LSQ_GetRangeAggregate%s: %.0f/s, checksum %lld\n", window,
+			j == 1 ? " after nine dereferences each" : "", queries / elapsedSeconds(&start, &finish), checksum);
+	}
+	LSQ_DestroyIterator(iterator);
+	for (i = 0; i < scans; i++)
+	{
+		LSQ_GetRangeAggregate(handle, keys[i], keys[i] + window, &aggregate);
+		mismatches += aggregate.count != window || aggregate.sum != scanWindow(handle, keys[i], keys[i] + window);
+	}
+	if (mismatches != 0)
+		printf("%d of %d aggregates differ from the scans\n", mismatches, scans);
+#endif
+	LSQ_DestroySequence(handle);
+	free(keys);
+	return 1;
+}
+
+/* Allocator that keeps the number of bytes in use in the long long its context points to */
+static void * countingAllocate(void * context, size_t size)
+{
+	void * ptr = malloc(size);
+	if (ptr != NULL)
+		*(long long *)context += size;
+	return ptr;
+}
+
+static void * countingReallocate(void * context, void * ptr, size_t old_size, size_t new_size)
+{
+	void * new_ptr = realloc(ptr, new_size);
+	if (new_ptr != NULL)
+		*(long long *)context += (long long)new_size - (long long)old_size;
+	return new_ptr;
+}
+
+static void countingDeallocate(void * context, void * ptr, size_t size)
+{
+	*(long long *)context -= size;
+	free(ptr);
+}
+
+/* Fills count containers with size keys each, either from allocator or from the default one */
+static void fillContainers(LSQ_HandleT * handles, int count, int size, const LSQ_AllocatorT * allocator)
+{
+	int i, j;
+	for (i = 0; i < count; i++)
+	{
+		handles[i] = (allocator == NULL) ? LSQ_CreateSequence() : LSQ_CreateSequenceWithAllocator(allocator);
+		for (j = 0; j < size; j++)
+			LSQ_InsertElement(handles[i], (j * 7919) % 101, j);
+	}
+}
+
+static int runSmall(int argc, char ** argv)
+{
+	int size = (argc > 0) ? atoi(argv[0]) : 12;
+	int count = (argc > 1) ? atoi(argv[1]) : 1000000;
+	LSQ_HandleT * handles = NULL;
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_AllocatorT allocator;
+	struct timespec start, middle, finish;
+	long long bytes = 0, checksum = 0;
+	int i;
+
+	if (size < 0 || count < 1)
+		return 0;
+	handles = (LSQ_HandleT *)malloc(count * sizeof(LSQ_HandleT));
+	if (handles == NULL)
+		return 0;
+	allocator.allocate = countingAllocate;
+	allocator.reallocate = countingReallocate;
+	allocator.deallocate = countingDeallocate;
+	allocator.context = &bytes;
+	allocator.releases_in_bulk = 0;
+	fillContainers(handles, count, size, &allocator);
+	printf("%d maps of %d keys: %.1f bytes each", count, size, (double)bytes / count);
+	for (i = 0; i < count; i++)
+		LSQ_DestroySequence(handles[i]);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	fillContainers(handles, count, size, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+	for (i = 0; i < count; i++)
+	{
+		for (iterator = LSQ_GetFrontElement(handles[i]); LSQ_IsIteratorDereferencable(iterator);
+			 LSQ_AdvanceOneElement(iterator))
+			checksum += *LSQ_PeekIterator(iterator);
+		LSQ_DestroyIterator(iterator);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	printf(", %.0f ns to build and %.0f ns to scan each, checksum %lld\n", elapsedSeconds(&start, &middle) * 1e9 / count,
+		elapsedSeconds(&middle, &finish) * 1e9 / count, checksum);
+	for (i = 0; i < count; i++)
+		LSQ_DestroySequence(handles[i]);
+	free(handles);
+	return 1;
+}
+
+/* Predicate that removes a pseudo-random share of the elements, given in per mille by the context */
+static int isErased(void * context, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	(void)key;
+	return (unsigned int)value * 2654435761u % 1000u < (unsigned int)*(int *)context;
+}
+
+/* Creates a map of the values below size; sequential keys allocate the nodes in key order, random ones do not */
+static LSQ_HandleT createEraseMap(int size, int sequential)
+{
+	LSQ_HandleT handle = LSQ_CreateSequence();
+	int i;
+	for (i = 0; i < size && handle != LSQ_HandleInvalid; i++)
+		LSQ_InsertElement(handle, sequential ? i : (int)((i * 2654435761u) >> 1), i);
+	return handle;
+}
+
+static int runErase(int argc, char ** argv)
+{
+	int size = (argc > 0) ? atoi(argv[0]) : 1000000;
+	int per_mille = (argc > 1) ? atoi(argv[1]) : 500;
+	int sequential = (argc <= 2) || strcmp(argv[2], "random") != 0;
+	LSQ_HandleT looped = LSQ_HandleInvalid, erased = LSQ_HandleInvalid;
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_IntegerIndexT * keys = NULL;
+	struct timespec start, middle, finish;
+	int i, count = 0, erased_count;
+
+	if (size < 1 || per_mille < 0 || per_mille > 1000)
+		return 0;
+	/* Both trees are built before either is modified, so freed nodes do not end up in the second one */
+	looped = createEraseMap(size, sequential);
+	erased = createEraseMap(size, sequential);
+	keys = (LSQ_IntegerIndexT *)malloc(size * sizeof(LSQ_IntegerIndexT));
+	if (looped == LSQ_HandleInvalid || erased == LSQ_HandleInvalid || keys == NULL)
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (iterator = LSQ_GetFrontElement(looped); LSQ_IsIteratorDereferencable(iterator); LSQ_AdvanceOneElement(iterator))
+	{
+		if (isErased(&per_mille, LSQ_GetIteratorKey(iterator), *LSQ_PeekIterator(iterator)))
+			keys[count++] = LSQ_GetIteratorKey(iterator);
+	}
+	LSQ_DestroyIterator(iterator);
+	for (i = 0; i < count; i++)
+		LSQ_DeleteElement(looped, keys[i]);
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+	erased_count = LSQ_EraseIf(erased, isErased, &per_mille);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	printf("%d %s keys, %d removed: %.1f ms collecting and deleting, %.1f ms by LSQ_EraseIf, which removed %d\n", size,
+		sequential ? "sequential" : "random", count, elapsedSeconds(&start, &middle) * 1e3,
+		elapsedSeconds(&middle, &finish) * 1e3, erased_count);
+	LSQ_DestroySequence(looped);
+	LSQ_DestroySequence(erased);
+	free(keys);
+	return 1;
+}
+
+static int runHint(int argc, char ** argv)
+{
+	int count = (argc > 0) ? atoi(argv[0]) : 2000000;
+	int jitter = (argc > 1) ? atoi(argv[1]) : 0;
+	unsigned int seed = 2463534242u;
+	LSQ_HandleT plain = LSQ_HandleInvalid, hinted = LSQ_HandleInvalid;
+	LSQ_IteratorT hint = LSQ_HandleInvalid;
+	LSQ_IntegerIndexT * keys = NULL;
+	struct timespec start, middle, finish;
+	int i;
+
+	if (count < 1 || jitter < 0 || count > 0x7fffffff / 4 - jitter)
+		return 0;
+	plain = LSQ_CreateSequence();
+	hinted = LSQ_CreateSequence();
+	keys = (LSQ_IntegerIndexT *)malloc(count * sizeof(LSQ_IntegerIndexT));
+	if (plain == LSQ_HandleInvalid || hinted == LSQ_HandleInvalid || keys == NULL)
+		return 0;
+	for (i = 0; i < count; i++)
+		keys[i] = 4 * i + ((jitter > 0) ? (int)(nextRandom(&seed) % (unsigned int)jitter) : 0);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < count; i++)
+		LSQ_InsertElement(plain, keys[i], i);
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+	hint = LSQ_GetPastRearElement(hinted);
+	for (i = 0; i < count; i++)
+		LSQ_InsertElementWithHint(hinted, hint, keys[i], i);
+	LSQ_DestroyIterator(hint);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	printf("%d keys 4 apart with jitter %d: %.1f ns per key plain, %.1f ns hinted, final sizes %d and %d\n", count, jitter,
+		elapsedSeconds(&start, &middle) * 1e9 / count, elapsedSeconds(&middle, &finish) * 1e9 / count,
+		LSQ_GetSize(plain), LSQ_GetSize(hinted));
+	LSQ_DestroySequence(plain);
+	LSQ_DestroySequence(hinted);
+	free(keys);
+	return 1;
+}
+
+int main(int argc, char ** argv)
+{
+	int done = 0;
+	if (argc > 1 && strcmp(argv[1], "batch") == 0)
+		done = runBatch(argc - 2, argv + 2);
+	else if (argc > 1 && strcmp(argv[1], "lookup") == 0)
+		done = runLookup(argc - 2, argv + 2);
+	else if (argc > 1 && strcmp(argv[1], "aggregate") == 0)
+		done = runAggregate(argc - 2, argv + 2);
+	else if (argc > 1 && strcmp(argv[1], "small") == 0)
+		done = runSmall(argc - 2, argv + 2);
+	else if (argc > 1 && strcmp(argv[1], "erase") == 0)
+		done = runErase(argc - 2, argv + 2);
+	else if (argc > 1 && strcmp(argv[1], "hint") == 0)
+		done = runHint(argc - 2, argv + 2);
+	if (!done)
+	{
+		fprintf(stderr, "usage: %s batch [tree size] [batch size]\n"
+			"       %s lookup [tree size] [lookups] [batch size]\n"
+			"       %s aggregate [tree size] [window] [queries]\n"
+			"       %s small [keys per map] [maps]\n"
+			"       %s erase [tree size] [removed per mille] [sequential | random]\n"
+			"       %s hint [keys] [jitter]\n", argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+		return 1;
+	}
+	return 0;
+}
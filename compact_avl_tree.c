@@ -0,0 +1,692 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "linear_sequence_assoc.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_capacity.h"
+
+/* Compact AVL tree: nodes live in one array and refer to their children by 32-bit indices, the balance factor takes *
+ * the two high bits of the right child index, and there are no parent pointers. A node is 16 bytes against 40 plus *
+ * the malloc header in avl_tree.c, and nodes allocated together share cache lines. Iterators keep the path from the *
+ * root on a stack and remember their key: after the tree was modified they find the key again, or the next greater *
+ * one if it was deleted. Insertions invalidate pointers returned by LSQ_DereferenceIterator. LSQ_ShrinkToFit lays   *
+ * the nodes out in key order. The tree holds at most 2^30 - 1 elements.                                            */
+
+#define IS_HANDLE_INVALID(handle)        ((handle) == LSQ_HandleInvalid)
+#define TREE_MAX_HEIGHT 48
+#define NIL_NODE 0u
+#define NODE_INDEX_BITS 30
+#define NODE_INDEX_MASK ((1u << NODE_INDEX_BITS) - 1)
+#define MIN_NODE_CAPACITY 16u
+
+typedef enum
+{
+	IST_BEFORE_FIRST,
+	IST_DEREFERENCABLE,
+	IST_PAST_REAR,
+} IteratorStateT;
+
+typedef struct
+{
+	/* Left child index, or the next free node for nodes on the free list */
+	unsigned int l_child;
+	/* Right child index in the low bits, balance factor plus one in the high two bits */
+	unsigned int r_child_balance;
+	LSQ_IntegerIndexT key;
+	LSQ_BaseTypeT value;
+} TreeNodeT;
+
+typedef struct
+{
+	/* nodes[NIL_NODE] is never used, so that index zero can mean "no child" */
+	TreeNodeT * nodes;
+	unsigned int capacity;
+	unsigned int next_unused;
+	unsigned int free_list;
+	unsigned int root;
+	int size;
+	/* Incremented by every modification, iterators compare it to find out their path is stale */
+	unsigned int version;
+	const LSQ_AllocatorT * allocator;
+} CompactTreeT;
+
+typedef struct
+{
+	CompactTreeT * tree;
+	unsigned int path[TREE_MAX_HEIGHT];
+	int depth;
+	LSQ_IntegerIndexT key;
+	unsigned int version;
+	IteratorStateT state;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static __inline unsigned int rightChild(const CompactTreeT * tree, unsigned int node);
+static __inline int nodeBalance(const CompactTreeT * tree, unsigned int node);
+static __inline void setRightChild(CompactTreeT * tree, unsigned int node, unsigned int child);
+static __inline void setBalance(CompactTreeT * tree, unsigned int node, int balance);
+static int growNodes(CompactTreeT * tree, unsigned int capacity);
+static int reserveNode(CompactTreeT * tree);
+static unsigned int createNode(CompactTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+static void releaseNode(CompactTreeT * tree, unsigned int node);
+static unsigned int rotateLeft(CompactTreeT * tree, unsigned int node, int * lowered);
+static unsigned int rotateRight(CompactTreeT * tree, unsigned int node, int * lowered);
+static unsigned int leanLeft(CompactTreeT * tree, unsigned int node, int growing, int * changed);
+static unsigned int leanRight(CompactTreeT * tree, unsigned int node, int growing, int * changed);
+static unsigned int insertNode(CompactTreeT * tree, unsigned int node, LSQ_IntegerIndexT key, LSQ_BaseTypeT value,
+							   int * grew);
+static unsigned int removeMinimum(CompactTreeT * tree, unsigned int node, unsigned int * minimum, int * shrunk);
+static unsigned int deleteNode(CompactTreeT * tree, unsigned int node, LSQ_IntegerIndexT key, int * shrunk);
+static unsigned int linkBalanced(TreeNodeT * nodes, unsigned int first, unsigned int last, int * height);
+static int rebuildTree(CompactTreeT * tree);
+static void pushLeftSpine(IteratorT * iter, unsigned int node);
+static void pushRightSpine(IteratorT * iter, unsigned int node);
+static void settleIterator(IteratorT * iter, IteratorStateT empty_state);
+static void seekKey(IteratorT * iter, LSQ_IntegerIndexT key);
+static void syncIterator(IteratorT * iter);
+static IteratorT * createIterator(LSQ_HandleT handle);
+
+static __inline unsigned int rightChild(const CompactTreeT * tree, unsigned int node)
+{
+	return tree->nodes[node].r_child_balance & NODE_INDEX_MASK;
+}
+
+static __inline int nodeBalance(const CompactTreeT * tree, unsigned int node)
+{
+	return (int)(tree->nodes[node].r_child_balance >> NODE_INDEX_BITS) - 1;
+}
+
+static __inline void setRightChild(CompactTreeT * tree, unsigned int node, unsigned int child)
+{
+	tree->nodes[node].r_child_balance = (tree->nodes[node].r_child_balance & ~NODE_INDEX_MASK) | child;
+}
+
+static __inline void setBalance(CompactTreeT * tree, unsigned int node, int balance)
+{
+	tree->nodes[node].r_child_balance = (tree->nodes[node].r_child_balance & NODE_INDEX_MASK) |
+		((unsigned int)(balance + 1) << NODE_INDEX_BITS);
+}
+
+static int growNodes(CompactTreeT * tree, unsigned int capacity)
+{
+	TreeNodeT * nodes = NULL;
+	if (capacity > NODE_INDEX_MASK + 1)
+		capacity = NODE_INDEX_MASK + 1;
+	if (capacity <= tree->capacity)
+		return 0;
+	nodes = (TreeNodeT *)lsqReallocate(tree->allocator, tree->nodes, (size_t)tree->capacity * sizeof(TreeNodeT),
+		(size_t)capacity * sizeof(TreeNodeT));
+	if (nodes == NULL)
+		return 0;
+	if (tree->nodes == NULL)
+	{
+		nodes[NIL_NODE].l_child = NIL_NODE;
+		nodes[NIL_NODE].r_child_balance = NIL_NODE;
+	}
+	tree->nodes = nodes;
+	tree->capacity = capacity;
+	return 1;
+}
+
+/* Makes sure createNode succeeds without moving the array, so that node indices and pointers into the array *
+ * stay valid during an insertion                                                                             */
+static int reserveNode(CompactTreeT * tree)
+{
+	return tree->free_list != NIL_NODE || tree->next_unused < tree->capacity ||
+		growNodes(tree, tree->capacity < MIN_NODE_CAPACITY ? MIN_NODE_CAPACITY : tree->capacity * 2);
+}
+
+static unsigned int createNode(CompactTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	unsigned int node = tree->free_list;
+	if (node != NIL_NODE)
+		tree->free_list = tree->nodes[node].l_child;
+	else
+		node = tree->next_unused++;
+	assert(node < tree->capacity);
+	tree->nodes[node].l_child = NIL_NODE;
+	tree->nodes[node].r_child_balance = NIL_NODE;
+	setBalance(tree, node, 0);
+	tree->nodes[node].key = key;
+	tree->nodes[node].value = value;
+	tree->size++;
+	return node;
+}
+
+static void releaseNode(CompactTreeT * tree, unsigned int node)
+{
+	tree->nodes[node].l_child = tree->free_list;
+	tree->free_list = node;
+	tree->size--;
+}
+
+/* Rotates a subtree whose right side is two levels taller. Sets *lowered if the result is one level lower */
+static unsigned int rotateLeft(CompactTreeT * tree, unsigned int node, int * lowered)
+{
+	unsigned int right = rightChild(tree, node), inner = NIL_NODE;
+	int inner_balance;
+	if (nodeBalance(tree, right) >= 0)
+	{
+		setRightChild(tree, node, tree->nodes[right].l_child);
+		tree->nodes[right].l_child = node;
+		*lowered = nodeBalance(tree, right) > 0;
+		setBalance(tree, node, *lowered ? 0 : 1);
+		setBalance(tree, right, *lowered ? 0 : -1);
+		return right;
+	}
+	inner = tree->nodes[right].l_child;
+	inner_balance = nodeBalance(tree, inner);
+	tree->nodes[right].l_child = rightChild(tree, inner);
+	setRightChild(tree, node, tree->nodes[inner].l_child);
+	tree->nodes[inner].l_child = node;
+	setRightChild(tree, inner, right);
+	setBalance(tree, node, inner_balance > 0 ? -1 : 0);
+	setBalance(tree, right, inner_balance < 0 ? 1 : 0);
+	setBalance(tree, inner, 0);
+	*lowered = 1;
+	return inner;
+}
+
+/* Rotates a subtree whose left side is two levels taller. Sets *lowered if the result is one level lower */
+static unsigned int rotateRight(CompactTreeT * tree, unsigned int node, int * lowered)
+{
+	unsigned int left = tree->nodes[node].l_child, inner = NIL_NODE;
+	int inner_balance;
+	if (nodeBalance(tree, left) <= 0)
+	{
+		tree->nodes[node].l_child = rightChild(tree, left);
+		setRightChild(tree, left, node);
+		*lowered = nodeBalance(tree, left) < 0;
+		setBalance(tree, node, *lowered ? 0 : -1);
+		setBalance(tree, left, *lowered ? 0 : 1);
+		return left;
+	}
+	inner = rightChild(tree, left);
+	inner_balance = nodeBalance(tree, inner);
+	setRightChild(tree, left, tree->nodes[inner].l_child);
+	tree->nodes[node].l_child = rightChild(tree, inner);
+	tree->nodes[inner].l_child = left;
+	setRightChild(tree, inner, node);
+	setBalance(tree, node, inner_balance < 0 ? 1 : 0);
+	setBalance(tree, left, inner_balance > 0 ? -1 : 0);
+	setBalance(tree, inner, 0);
+	*lowered = 1;
+	return inner;
+}
+
+/* Updates node after its left subtree grew (growing) or its right subtree shrank (!growing) by one level. *
+ * Returns the new subtree root and sets *changed if the height of the subtree changed the same way         */
+static unsigned int leanLeft(CompactTreeT * tree, unsigned int node, int growing, int * changed)
+{
+	int lowered;
+	switch (nodeBalance(tree, node))
+	{
+	case 1:
+		setBalance(tree, node, 0);
+		*changed = !growing;
+		return node;
+	case 0:
+		setBalance(tree, node, -1);
+		*changed = growing;
+		return node;
+	default:
+		node = rotateRight(tree, node, &lowered);
+		*changed = !growing && lowered;
+		return node;
+	}
+}
+
+/* Updates node after its right subtree grew (growing) or its left subtree shrank (!growing) by one level. *
+ * Returns the new subtree root and sets *changed if the height of the subtree changed the same way         */
+static unsigned int leanRight(CompactTreeT * tree, unsigned int node, int growing, int * changed)
+{
+	int lowered;
+	switch (nodeBalance(tree, node))
+	{
+	case -1:
+		setBalance(tree, node, 0);
+		*changed = !growing;
+		return node;
+	case 0:
+		setBalance(tree, node, 1);
+		*changed = growing;
+		return node;
+	default:
+		node = rotateLeft(tree, node, &lowered);
+		*changed = !growing && lowered;
+		return node;
+	}
+}
+
+/* Requires a node in reserve (see reserveNode). Returns the new subtree root */
+static unsigned int insertNode(CompactTreeT * tree, unsigned int node, LSQ_IntegerIndexT key, LSQ_BaseTypeT value,
+							   int * grew)
+{
+	TreeNodeT * nodes = tree->nodes;
+	if (node == NIL_NODE)
+	{
+		*grew = 1;
+		return createNode(tree, key, value);
+	}
+	if (key == nodes[node].key)
+	{
+		nodes[node].value = value;
+		*grew = 0;
+		return node;
+	}
+	if (key < nodes[node].key)
+	{
+		nodes[node].l_child = insertNode(tree, nodes[node].l_child, key, value, grew);
+		return *grew ? leanLeft(tree, node, 1, grew) : node;
+	}
+	setRightChild(tree, node, insertNode(tree, rightChild(tree, node), key, value, grew));
+	return *grew ? leanRight(tree, node, 1, grew) : node;
+}
+
+/* Unlinks the minimal node of the subtree without releasing it */
+static unsigned int removeMinimum(CompactTreeT * tree, unsigned int node, unsigned int * minimum, int * shrunk)
+{
+	if (tree->nodes[node].l_child == NIL_NODE)
+	{
+		*minimum = node;
+		*shrunk = 1;
+		return rightChild(tree, node);
+	}
+	tree->nodes[node].l_child = removeMinimum(tree, tree->nodes[node].l_child, minimum, shrunk);
+	return *shrunk ? leanRight(tree, node, 0, shrunk) : node;
+}
+
+static unsigned int deleteNode(CompactTreeT * tree, unsigned int node, LSQ_IntegerIndexT key, int * shrunk)
+{
+	TreeNodeT * nodes = tree->nodes;
+	unsigned int child = NIL_NODE, successor = NIL_NODE;
+	if (node == NIL_NODE)
+	{
+		*shrunk = 0;
+		return NIL_NODE;
+	}
+	if (key < nodes[node].key)
+	{
+		nodes[node].l_child = deleteNode(tree, nodes[node].l_child, key, shrunk);
+		return *shrunk ? leanRight(tree, node, 0, shrunk) : node;
+	}
+	if (key > nodes[node].key)
+	{
+		setRightChild(tree, node, deleteNode(tree, rightChild(tree, node), key, shrunk));
+		return *shrunk ? leanLeft(tree, node, 0, shrunk) : node;
+	}
+	if (nodes[node].l_child == NIL_NODE || rightChild(tree, node) == NIL_NODE)
+	{
+		child = (nodes[node].l_child != NIL_NODE) ? nodes[node].l_child : rightChild(tree, node);
+		releaseNode(tree, node);
+		*shrunk = 1;
+		return child;
+	}
+	setRightChild(tree, node, removeMinimum(tree, rightChild(tree, node), &successor, shrunk));
+	nodes[node].key = nodes[successor].key;
+	nodes[node].value = nodes[successor].value;
+	releaseNode(tree, successor);
+	return *shrunk ? leanLeft(tree, node, 0, shrunk) : node;
+}
+
+/* Links the nodes first..last, sorted by key, into a perfectly balanced tree and returns its root */
+static unsigned int linkBalanced(TreeNodeT * nodes, unsigned int first, unsigned int last, int * height)
+{
+	unsigned int middle, right;
+	int l_height, r_height;
+	if (first > last)
+	{
+		*height = 0;
+		return NIL_NODE;
+	}
+	middle = first + (last - first) / 2;
+	nodes[middle].l_child = linkBalanced(nodes, first, middle - 1, &l_height);
+	right = linkBalanced(nodes, middle + 1, last, &r_height);
+	nodes[middle].r_child_balance = right | ((unsigned int)(r_height - l_height + 1) << NODE_INDEX_BITS);
+	*height = (l_height > r_height ? l_height : r_height) + 1;
+	return middle;
+}
+
+/* Moves the elements into an array of exactly size nodes in key order, so that iteration reads it sequentially */
+static int rebuildTree(CompactTreeT * tree)
+{
+	TreeNodeT * nodes = NULL;
+	unsigned int stack[TREE_MAX_HEIGHT], node = tree->root, count = 0;
+	int depth = 0, height;
+	nodes = (TreeNodeT *)lsqAllocate(tree->allocator, ((size_t)tree->size + 1) * sizeof(TreeNodeT));
+	if (nodes == NULL)
+		return 0;
+	nodes[NIL_NODE].l_child = NIL_NODE;
+	nodes[NIL_NODE].r_child_balance = NIL_NODE;
+	while (node != NIL_NODE || depth > 0)
+	{
+		for (; node != NIL_NODE; node = tree->nodes[node].l_child)
+			stack[depth++] = node;
+		node = stack[--depth];
+		count++;
+		nodes[count].key = tree->nodes[node].key;
+		nodes[count].value = tree->nodes[node].value;
+		node = rightChild(tree, node);
+	}
+	lsqDeallocate(tree->allocator, tree->nodes, (size_t)tree->capacity * sizeof(TreeNodeT));
+	tree->nodes = nodes;
+	tree->capacity = count + 1;
+	tree->next_unused = count + 1;
+	tree->free_list = NIL_NODE;
+	tree->root = linkBalanced(nodes, 1, count, &height);
+	tree->version++;
+	return 1;
+}
+
+static void pushLeftSpine(IteratorT * iter, unsigned int node)
+{
+	for (; node != NIL_NODE; node = iter->tree->nodes[node].l_child)
+		iter->path[iter->depth++] = node;
+}
+
+static void pushRightSpine(IteratorT * iter, unsigned int node)
+{
+	for (; node != NIL_NODE; node = rightChild(iter->tree, node))
+		iter->path[iter->depth++] = node;
+}
+
+static void settleIterator(IteratorT * iter, IteratorStateT empty_state)
+{
+	iter->state = (iter->depth > 0) ? IST_DEREFERENCABLE : empty_state;
+	if (iter->depth > 0)
+		iter->key = iter->tree->nodes[iter->path[iter->depth - 1]].key;
+}
+
+/* Positions the iterator at the minimal key not less than key */
+static void seekKey(IteratorT * iter, LSQ_IntegerIndexT key)
+{
+	const TreeNodeT * nodes = iter->tree->nodes;
+	unsigned int node = iter->tree->root;
+	iter->depth = 0;
+	while (node != NIL_NODE)
+	{
+		iter->path[iter->depth++] = node;
+		if (key == nodes[node].key)
+			break;
+		node = (key < nodes[node].key) ? nodes[node].l_child : rightChild(iter->tree, node);
+	}
+	/* The successor is the deepest node on the path the search went left from */
+	while (iter->depth > 0 && nodes[iter->path[iter->depth - 1]].key < key)
+		iter->depth--;
+	settleIterator(iter, IST_PAST_REAR);
+}
+
+static void syncIterator(IteratorT * iter)
+{
+	if (iter->version == iter->tree->version)
+		return;
+	iter->version = iter->tree->version;
+	if (iter->state == IST_DEREFERENCABLE)
+		seekKey(iter, iter->key);
+}
+
+static IteratorT * createIterator(LSQ_HandleT handle)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(tree->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = tree->allocator;
+	iterator->tree = tree;
+	iterator->depth = 0;
+	iterator->key = 0;
+	iterator->version = tree->version;
+	iterator->state = IST_PAST_REAR;
+	return iterator;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	CompactTreeT * tree = (CompactTreeT *)lsqAllocate(allocator, sizeof(CompactTreeT));
+	if (tree == NULL)
+		return LSQ_HandleInvalid;
+	tree->allocator = allocator;
+	tree->nodes = NULL;
+	tree->capacity = 0;
+	tree->next_unused = NIL_NODE + 1;
+	tree->free_list = NIL_NODE;
+	tree->root = NIL_NODE;
+	tree->size = 0;
+	tree->version = 0;
+	return tree;
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(tree->allocator))
+		return;
+	lsqDeallocate(tree->allocator, tree->nodes, (size_t)tree->capacity * sizeof(TreeNodeT));
+	lsqDeallocate(tree->allocator, tree, sizeof(CompactTreeT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? -1 : ((CompactTreeT *)handle)->size;
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator))
+		return 0;
+	syncIterator(iter);
+	return iter->state == IST_DEREFERENCABLE;
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator))
+		return 0;
+	syncIterator(iter);
+	return iter->state == IST_PAST_REAR;
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_BEFORE_FIRST;
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !LSQ_IsIteratorDereferencable(iterator) ? NULL :
+		&iter->tree->nodes[iter->path[iter->depth - 1]].value;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetIteratorKey(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	assert(LSQ_IsIteratorDereferencable(iterator));
+	return iter->key;
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	IteratorT * iter = createIterator(handle);
+	if (iter == NULL)
+		return LSQ_HandleInvalid;
+	seekKey(iter, index);
+	if (iter->state == IST_DEREFERENCABLE && iter->key != index)
+	{
+		iter->depth = 0;
+		iter->state = IST_PAST_REAR;
+	}
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	IteratorT * iter = createIterator(handle);
+	if (iter == NULL)
+		return LSQ_HandleInvalid;
+	pushLeftSpine(iter, iter->tree->root);
+	settleIterator(iter, IST_PAST_REAR);
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	return createIterator(handle);
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	lsqDeallocate(iter->allocator, iter, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	unsigned int child = NIL_NODE;
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	syncIterator(iter);
+	if (iter->tree->root == NIL_NODE || iter->state == IST_PAST_REAR)
+		return;
+	if (iter->state == IST_BEFORE_FIRST)
+		pushLeftSpine(iter, iter->tree->root);
+	else if (rightChild(iter->tree, iter->path[iter->depth - 1]) != NIL_NODE)
+		pushLeftSpine(iter, rightChild(iter->tree, iter->path[iter->depth - 1]));
+	else
+	{
+		do
+			child = iter->path[--iter->depth];
+		while (iter->depth > 0 && rightChild(iter->tree, iter->path[iter->depth - 1]) == child);
+	}
+	settleIterator(iter, IST_PAST_REAR);
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	unsigned int child = NIL_NODE;
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	syncIterator(iter);
+	if (iter->tree->root == NIL_NODE || iter->state == IST_BEFORE_FIRST)
+		return;
+	if (iter->state == IST_PAST_REAR)
+		pushRightSpine(iter, iter->tree->root);
+	else if (iter->tree->nodes[iter->path[iter->depth - 1]].l_child != NIL_NODE)
+		pushRightSpine(iter, iter->tree->nodes[iter->path[iter->depth - 1]].l_child);
+	else
+	{
+		do
+			child = iter->path[--iter->depth];
+		while (iter->depth > 0 && iter->tree->nodes[iter->path[iter->depth - 1]].l_child == child);
+	}
+	settleIterator(iter, IST_BEFORE_FIRST);
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	for(; shift > 0; shift--)
+		LSQ_AdvanceOneElement(iterator);
+	for(; shift < 0; shift++)
+		LSQ_RewindOneElement(iterator);
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter->depth = 0;
+	iter->state = IST_BEFORE_FIRST;
+	iter->version = iter->tree->version;
+	LSQ_ShiftPosition(iterator, pos + 1);
+}
+
+extern void LSQ_InsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	int grew;
+	if (IS_HANDLE_INVALID(handle) || !reserveNode(tree))
+		return;
+	tree->root = insertNode(tree, tree->root, key, value, &grew);
+	tree->version++;
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	unsigned int node = NIL_NODE;
+	if (IS_HANDLE_INVALID(handle) || tree->root == NIL_NODE)
+		return;
+	for (node = tree->root; tree->nodes[node].l_child != NIL_NODE; node = tree->nodes[node].l_child)
+		;
+	LSQ_DeleteElement(handle, tree->nodes[node].key);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	unsigned int node = NIL_NODE;
+	if (IS_HANDLE_INVALID(handle) || tree->root == NIL_NODE)
+		return;
+	for (node = tree->root; rightChild(tree, node) != NIL_NODE; node = rightChild(tree, node))
+		;
+	LSQ_DeleteElement(handle, tree->nodes[node].key);
+}
+
+extern void LSQ_DeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	int shrunk;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	tree->root = deleteNode(tree, tree->root, key, &shrunk);
+	tree->version++;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetCapacity(LSQ_HandleT handle)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	return IS_HANDLE_INVALID(handle) ? -1 : (tree->nodes == NULL ? 0 : (LSQ_IntegerIndexT)tree->capacity - 1);
+}
+
+extern void LSQ_ReserveCapacity(LSQ_HandleT handle, LSQ_IntegerIndexT capacity)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || capacity <= LSQ_GetCapacity(handle))
+		return;
+	growNodes(tree, (unsigned int)capacity + 1);
+}
+
+extern void LSQ_ShrinkToFit(LSQ_HandleT handle)
+{
+	CompactTreeT * tree = (CompactTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || tree->nodes == NULL)
+		return;
+	if (tree->size == 0)
+	{
+		lsqDeallocate(tree->allocator, tree->nodes, (size_t)tree->capacity * sizeof(TreeNodeT));
+		tree->nodes = NULL;
+		tree->capacity = 0;
+		tree->next_unused = NIL_NODE + 1;
+		tree->free_list = NIL_NODE;
+		return;
+	}
+	if ((unsigned int)tree->size + 1 < tree->capacity)
+		rebuildTree(tree);
+}
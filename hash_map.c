@@ -0,0 +1,445 @@
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include "linear_sequence_assoc.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_capacity.h"
+
+/* Associative array on a Robin Hood open-addressing hash table. Keys and values are stored inline in the slots.  *
+ * Iteration order is the slot order, i.e. unordered: LSQ_GetFrontElement and LSQ_DeleteFrontElement refer to the  *
+ * first element of that order, not to the minimal key. Any insertion or deletion invalidates iterators.           */
+
+#define IS_HANDLE_INVALID(handle)        ((handle) == LSQ_HandleInvalid)
+
+#define HASH_MIN_CAPACITY_BITS 4
+#define HASH_MAX_LOAD_NUMERATOR 7
+#define HASH_MAX_LOAD_DENOMINATOR 8
+#define HASH_SHRINK_LOAD_DENOMINATOR 8
+#define HASH_MAX_DISTANCE 255
+#define HASH_MULTIPLIER 2654435769u
+
+typedef enum
+{
+	IST_BEFORE_FIRST,
+	IST_DEREFERENCABLE,
+	IST_PAST_REAR,
+} IteratorStateT;
+
+typedef struct
+{
+	LSQ_IntegerIndexT key;
+	LSQ_BaseTypeT value;
+} SlotT;
+
+typedef struct
+{
+	SlotT * slots;
+	/* Probe distance from the home slot plus one, zero marks an empty slot */
+	unsigned char * distances;
+	int capacity_bits;
+	int size;
+	const LSQ_AllocatorT * allocator;
+} HashMapT;
+
+typedef struct
+{
+	HashMapT * map;
+	int slot;
+	IteratorStateT state;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static __inline int capacity(const HashMapT * map);
+static __inline int homeSlot(const HashMapT * map, LSQ_IntegerIndexT key);
+static __inline int maxLoad(int capacity_bits);
+static size_t tableBytes(int capacity_bits);
+static int findSlot(const HashMapT * map, LSQ_IntegerIndexT key);
+static int placeEntry(HashMapT * map, SlotT * entry, int * distance);
+static int resizeTable(HashMapT * map, int capacity_bits);
+static int requiredCapacityBits(int size);
+static void eraseSlot(HashMapT * map, int slot);
+static int nextOccupied(const HashMapT * map, int slot);
+static int previousOccupied(const HashMapT * map, int slot);
+static IteratorT * createIterator(LSQ_HandleT handle, int slot);
+
+static __inline int capacity(const HashMapT * map)
+{
+	return (map->slots == NULL) ? 0 : 1 << map->capacity_bits;
+}
+
+static __inline int homeSlot(const HashMapT * map, LSQ_IntegerIndexT key)
+{
+	return (int)(((unsigned int)key * HASH_MULTIPLIER) >> (32 - map->capacity_bits));
+}
+
+static __inline int maxLoad(int capacity_bits)
+{
+	return (int)(((long long)1 << capacity_bits) * HASH_MAX_LOAD_NUMERATOR / HASH_MAX_LOAD_DENOMINATOR);
+}
+
+static size_t tableBytes(int capacity_bits)
+{
+	return ((size_t)1 << capacity_bits) * (sizeof(SlotT) + sizeof(unsigned char));
+}
+
+static int requiredCapacityBits(int size)
+{
+	int bits = HASH_MIN_CAPACITY_BITS;
+	while (maxLoad(bits) < size)
+		bits++;
+	return bits;
+}
+
+static int findSlot(const HashMapT * map, LSQ_IntegerIndexT key)
+{
+	int slot, distance, mask = capacity(map) - 1;
+	if (map->slots == NULL)
+		return -1;
+	slot = homeSlot(map, key);
+	for (distance = 1; distance <= map->distances[slot]; distance++)
+	{
+		if (map->distances[slot] == distance && map->slots[slot].key == key)
+			return slot;
+		slot = (slot + 1) & mask;
+	}
+	return -1;
+}
+
+/* Robin Hood placement: the carried entry takes the slot of any entry that is closer to its home. *
+ * Returns 0 if a probe distance overflows; the entry still without a slot is left in entry.        */
+static int placeEntry(HashMapT * map, SlotT * entry, int * distance)
+{
+	int slot = homeSlot(map, entry->key), mask = capacity(map) - 1, tmp_distance;
+	SlotT tmp_entry;
+	*distance = 1;
+	while (map->distances[slot] != 0)
+	{
+		if (map->distances[slot] < *distance)
+		{
+			tmp_entry = map->slots[slot];
+			tmp_distance = map->distances[slot];
+			map->slots[slot] = *entry;
+			map->distances[slot] = (unsigned char)*distance;
+			*entry = tmp_entry;
+			*distance = tmp_distance;
+		}
+		slot = (slot + 1) & mask;
+		if (++(*distance) > HASH_MAX_DISTANCE)
+			return 0;
+	}
+	map->slots[slot] = *entry;
+	map->distances[slot] = (unsigned char)*distance;
+	return 1;
+}
+
+static int resizeTable(HashMapT * map, int capacity_bits)
+{
+	HashMapT old_map = *map;
+	SlotT entry;
+	int i, distance;
+	char * table = (char *)lsqAllocate(map->allocator, tableBytes(capacity_bits));
+	if (table == NULL)
+		return 0;
+	map->slots = (SlotT *)table;
+	map->distances = (unsigned char *)(table + ((size_t)1 << capacity_bits) * sizeof(SlotT));
+	map->capacity_bits = capacity_bits;
+	memset(map->distances, 0, (size_t)1 << capacity_bits);
+	for (i = 0; i < capacity(&old_map); i++)
+	{
+		if (old_map.distances[i] == 0)
+			continue;
+		entry = old_map.slots[i];
+		if (!placeEntry(map, &entry, &distance))
+		{
+			lsqDeallocate(map->allocator, table, tableBytes(capacity_bits));
+			*map = old_map;
+			return resizeTable(map, capacity_bits + 1);
+		}
+	}
+	if (old_map.slots != NULL)
+		lsqDeallocate(map->allocator, old_map.slots, tableBytes(old_map.capacity_bits));
+	return 1;
+}
+
+/* Backward-shift deletion: entries after the erased one move a slot closer to home, no tombstones remain */
+static void eraseSlot(HashMapT * map, int slot)
+{
+	int mask = capacity(map) - 1, next = (slot + 1) & mask;
+	while (map->distances[next] > 1)
+	{
+		map->slots[slot] = map->slots[next];
+		map->distances[slot] = (unsigned char)(map->distances[next] - 1);
+		slot = next;
+		next = (next + 1) & mask;
+	}
+	map->distances[slot] = 0;
+	map->size--;
+	if (map->capacity_bits > HASH_MIN_CAPACITY_BITS &&
+		map->size < capacity(map) / HASH_SHRINK_LOAD_DENOMINATOR)
+		resizeTable(map, map->capacity_bits - 1);
+}
+
+static int nextOccupied(const HashMapT * map, int slot)
+{
+	int cap = capacity(map);
+	for (slot++; slot < cap; slot++)
+		if (map->distances[slot] != 0)
+			return slot;
+	return cap;
+}
+
+static int previousOccupied(const HashMapT * map, int slot)
+{
+	for (slot--; slot >= 0; slot--)
+		if (map->distances[slot] != 0)
+			return slot;
+	return -1;
+}
+
+static IteratorT * createIterator(LSQ_HandleT handle, int slot)
+{
+	HashMapT * map = (HashMapT *)handle;
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(map->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = map->allocator;
+	iterator->map = map;
+	iterator->slot = slot;
+	iterator->state = IST_DEREFERENCABLE;
+	if (slot < 0)
+	{
+		iterator->slot = -1;
+		iterator->state = IST_BEFORE_FIRST;
+	}
+	if (slot >= capacity(map))
+	{
+		iterator->slot = capacity(map);
+		iterator->state = IST_PAST_REAR;
+	}
+	return iterator;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	HashMapT * map = (HashMapT *)lsqAllocate(allocator, sizeof(HashMapT));
+	if (map == NULL)
+		return LSQ_HandleInvalid;
+	map->allocator = allocator;
+	map->slots = NULL;
+	map->distances = NULL;
+	map->capacity_bits = HASH_MIN_CAPACITY_BITS;
+	map->size = 0;
+	return map;
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	HashMapT * map = (HashMapT *)handle;
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(map->allocator))
+		return;
+	if (map->slots != NULL)
+		lsqDeallocate(map->allocator, map->slots, tableBytes(map->capacity_bits));
+	lsqDeallocate(map->allocator, map, sizeof(HashMapT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? -1 : ((HashMapT *)handle)->size;
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_DEREFERENCABLE;
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_PAST_REAR;
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_BEFORE_FIRST;
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !LSQ_IsIteratorDereferencable(iterator) ? NULL :
+		&iter->map->slots[iter->slot].value;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetIteratorKey(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	assert(LSQ_IsIteratorDereferencable(iterator));
+	return iter->map->slots[iter->slot].key;
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	HashMapT * map = (HashMapT *)handle;
+	int slot;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	slot = findSlot(map, index);
+	return createIterator(handle, (slot < 0) ? capacity(map) : slot);
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	return createIterator(handle, nextOccupied((HashMapT *)handle, -1));
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	return createIterator(handle, capacity((HashMapT *)handle));
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || LSQ_IsIteratorPastRear(iterator))
+		return;
+	iter->slot = nextOccupied(iter->map, iter->slot);
+	iter->state = (iter->slot < capacity(iter->map)) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || LSQ_IsIteratorBeforeFirst(iterator))
+		return;
+	iter->slot = previousOccupied(iter->map, iter->slot);
+	iter->state = (iter->slot >= 0) ? IST_DEREFERENCABLE : IST_BEFORE_FIRST;
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	for(; shift > 0; shift--)
+		LSQ_AdvanceOneElement(iterator);
+	for(; shift < 0; shift++)
+		LSQ_RewindOneElement(iterator);
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter->slot = -1;
+	iter->state = IST_BEFORE_FIRST;
+	LSQ_ShiftPosition(iterator, pos + 1);
+}
+
+extern void LSQ_InsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	HashMapT * map = (HashMapT *)handle;
+	SlotT entry;
+	int slot, distance;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	slot = findSlot(map, key);
+	if (slot >= 0)
+	{
+		map->slots[slot].value = value;
+		return;
+	}
+	if ((map->slots == NULL || map->size + 1 > maxLoad(map->capacity_bits)) &&
+		!resizeTable(map, requiredCapacityBits(map->size + 1)))
+		return;
+	entry.key = key;
+	entry.value = value;
+	while (!placeEntry(map, &entry, &distance))
+	{
+		if (!resizeTable(map, map->capacity_bits + 1))
+			return;
+	}
+	map->size++;
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	HashMapT * map = (HashMapT *)handle;
+	int slot;
+	if (IS_HANDLE_INVALID(handle) || map->size == 0)
+		return;
+	slot = nextOccupied(map, -1);
+	eraseSlot(map, slot);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	HashMapT * map = (HashMapT *)handle;
+	int slot;
+	if (IS_HANDLE_INVALID(handle) || map->size == 0)
+		return;
+	slot = previousOccupied(map, capacity(map));
+	eraseSlot(map, slot);
+}
+
+extern void LSQ_DeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key)
+{
+	HashMapT * map = (HashMapT *)handle;
+	int slot;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	slot = findSlot(map, key);
+	if (slot >= 0)
+		eraseSlot(map, slot);
+}
+
+extern LSQ_IntegerIndexT LSQ_GetCapacity(LSQ_HandleT handle)
+{
+	HashMapT * map = (HashMapT *)handle;
+	return IS_HANDLE_INVALID(handle) ? -1 : (map->slots == NULL ? 0 : maxLoad(map->capacity_bits));
+}
+
+extern void LSQ_ReserveCapacity(LSQ_HandleT handle, LSQ_IntegerIndexT capacity)
+{
+	HashMapT * map = (HashMapT *)handle;
+	if (IS_HANDLE_INVALID(handle) || capacity <= LSQ_GetCapacity(handle))
+		return;
+	resizeTable(map, requiredCapacityBits(capacity));
+}
+
+extern void LSQ_ShrinkToFit(LSQ_HandleT handle)
+{
+	HashMapT * map = (HashMapT *)handle;
+	if (IS_HANDLE_INVALID(handle) || map->slots == NULL)
+		return;
+	if (map->size == 0)
+	{
+		lsqDeallocate(map->allocator, map->slots, tableBytes(map->capacity_bits));
+		map->slots = NULL;
+		map->distances = NULL;
+		map->capacity_bits = HASH_MIN_CAPACITY_BITS;
+		return;
+	}
+	if (requiredCapacityBits(map->size) < map->capacity_bits)
+		resizeTable(map, requiredCapacityBits(map->size));
+}
@@ -0,0 +1,335 @@
+#ifndef LINEAR_SEQUENCE_HPP
+#define LINEAR_SEQUENCE_HPP
+
+/* Header-only C++ layer over the sequence backends that provide linear_sequence_span.h: linear_sequence_arrays.c,   *
+ * linear_sequence_dyn_arrays.c, linear_sequence_lists.c and linear_sequence_rope.c. lsq::sequence owns a handle     *
+ * and offers the usual container interface with random-access iterators, so the standard algorithms apply. An       *
+ * iterator is an index plus the span of contiguous elements last fetched around it; increments, comparisons and     *
+ * dereferences inside that span are inlined, and only stepping out of it calls the backend. A traversal therefore   *
+ * makes one call for the arrays, one per chunk for the rope and one per element for lists, where jumping by n also  *
+ * costs O(n). for_each_span hands the spans themselves to the caller for loops the compiler can vectorize. A        *
+ * const_iterator and the const for_each_span read through LSQ_PeekSpan, which leaves a cloned array shared. Any     *
+ * modification of the sequence invalidates its iterators and references. Functions that allocate fail silently      *
+ * like the C API they call, except the constructor, which throws std::bad_alloc. Dereferencing an iterator outside  *
+ * the sequence throws std::out_of_range.                                                                            */
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+extern "C" {
+#include "linear_sequence.h"
+#include "linear_sequence_span.h"
+}
+
+namespace lsq
+{
+
+class sequence;
+
+/* Random-access iterator of sequence; Value is LSQ_BaseTypeT or const LSQ_BaseTypeT */
+template <typename Value>
+class sequence_iterator
+{
+public:
+	typedef std::random_access_iterator_tag iterator_category;
+	typedef LSQ_BaseTypeT value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Value * pointer;
+	typedef Value & reference;
+
+	sequence_iterator() : owner_(NULL), index_(0), first_(0), count_(0), span_(NULL) {}
+	/* Copies an iterator, or converts iterator to const_iterator, keeping the cached span */
+	sequence_iterator(const sequence_iterator<LSQ_BaseTypeT> & other) :
+		owner_(other.owner_), index_(other.index_), first_(other.first_), count_(other.count_), span_(other.span_) {}
+
+	reference operator*() const
+	{
+		if ((std::size_t)(index_ - first_) >= (std::size_t)count_)
+			fetch();
+		return span_[index_ - first_];
+	}
+	pointer operator->() const { return &**this; }
+	reference operator[](difference_type shift) const { return *(*this + shift); }
+
+	sequence_iterator & operator++() { index_++; return *this; }
+	sequence_iterator & operator--() { index_--; return *this; }
+	sequence_iterator operator++(int) { sequence_iterator old(*this); index_++; return old; }
+	sequence_iterator operator--(int) { sequence_iterator old(*this); index_--; return old; }
+	sequence_iterator & operator+=(difference_type shift) { index_ += shift; return *this; }
+	sequence_iterator & operator-=(difference_type shift) { index_ -= shift; return *this; }
+	sequence_iterator operator+(difference_type shift) const { sequence_iterator result(*this); return result += shift; }
+	sequence_iterator operator-(difference_type shift) const { sequence_iterator result(*this); return result -= shift; }
+	friend sequence_iterator operator+(difference_type shift, const sequence_iterator & iterator) { return iterator + shift; }
+
+	template <typename Other>
+	difference_type operator-(const sequence_iterator<Other> & other) const { return index_ - other.index_; }
+	template <typename Other>
+	bool operator==(const sequence_iterator<Other> & other) const { return index_ == other.index_; }
+	template <typename Other>
+	bool operator!=(const sequence_iterator<Other> & other) const { return index_ != other.index_; }
+	template <typename Other>
+	bool operator<(const sequence_iterator<Other> & other) const { return index_ < other.index_; }
+	template <typename Other>
+	bool operator>(const sequence_iterator<Other> & other) const { return index_ > other.index_; }
+	template <typename Other>
+	bool operator<=(const sequence_iterator<Other> & other) const { return index_ <= other.index_; }
+	template <typename Other>
+	bool operator>=(const sequence_iterator<Other> & other) const { return index_ >= other.index_; }
+
+	/* Index of the element in the sequence */
+	LSQ_IntegerIndexT index() const { return index_; }
+
+private:
+	friend class sequence;
+	template <typename> friend class sequence_iterator;
+
+	sequence_iterator(const sequence * owner, LSQ_IntegerIndexT index) :
+		owner_(owner), index_(index), first_(0), count_(0), span_(NULL) {}
+	/* Fetches the span starting at index_, throwing std::out_of_range if there is none; defined after sequence */
+	void fetch() const;
+
+	const sequence * owner_;
+	LSQ_IntegerIndexT index_;
+	/* Cached span: count_ contiguous elements starting at span_, the first of which has index first_ */
+	mutable LSQ_IntegerIndexT first_;
+	mutable LSQ_IntegerIndexT count_;
+	mutable Value * span_;
+};
+
+/* Owning, move-only container over a sequence handle */
+class sequence
+{
+public:
+	typedef LSQ_BaseTypeT value_type;
+	typedef LSQ_IntegerIndexT size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef LSQ_BaseTypeT & reference;
+	typedef const LSQ_BaseTypeT & const_reference;
+	typedef LSQ_BaseTypeT * pointer;
+	typedef const LSQ_BaseTypeT * const_pointer;
+	typedef sequence_iterator<LSQ_BaseTypeT> iterator;
+	typedef sequence_iterator<const LSQ_BaseTypeT> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	sequence() : handle_(LSQ_CreateSequence()), cursor_(LSQ_HandleInvalid), cursor_index_(0)
+	{
+		if (handle_ == LSQ_HandleInvalid)
+			throw std::bad_alloc();
+	}
+	/* Takes ownership of a handle created by LSQ_CreateSequence or another function of the backend */
+	explicit sequence(LSQ_HandleT handle) : handle_(handle), cursor_(LSQ_HandleInvalid), cursor_index_(0) {}
+	sequence(sequence && other) : handle_(other.handle_), cursor_(other.cursor_), cursor_index_(other.cursor_index_)
+	{
+		other.handle_ = LSQ_HandleInvalid;
+		other.cursor_ = LSQ_HandleInvalid;
+	}
+	sequence & operator=(sequence && other)
+	{
+		swap(other);
+		return *this;
+	}
+	~sequence()
+	{
+		LSQ_DestroyIterator(cursor_);
+		LSQ_DestroySequence(handle_);
+	}
+
+	/* Handle for calling the C API directly. Modifying the sequence through it must be followed by touch() */
+	LSQ_HandleT handle() const { return handle_; }
+	/* Releases the handle to the caller, leaving the sequence without one */
+	LSQ_HandleT release()
+	{
+		LSQ_HandleT handle = handle_;
+		touch();
+		handle_ = LSQ_HandleInvalid;
+		return handle;
+	}
+	/* Drops the position the sequence keeps for fetching spans */
+	void touch()
+	{
+		LSQ_DestroyIterator(cursor_);
+		cursor_ = LSQ_HandleInvalid;
+	}
+	void swap(sequence & other)
+	{
+		std::swap(handle_, other.handle_);
+		std::swap(cursor_, other.cursor_);
+		std::swap(cursor_index_, other.cursor_index_);
+	}
+
+	size_type size() const { return LSQ_GetSize(handle_); }
+	bool empty() const { return size() == 0; }
+
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, size()); }
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, size()); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	reference operator[](size_type index) { return *(begin() + index); }
+	const_reference operator[](size_type index) const { return *(begin() + index); }
+	reference front() { return *begin(); }
+	const_reference front() const { return *begin(); }
+	reference back() { return *(end() - 1); }
+	const_reference back() const { return *(end() - 1); }
+
+	void push_back(const value_type & value)
+	{
+		touch();
+		LSQ_InsertRearElement(handle_, value);
+	}
+	void push_front(const value_type & value)
+	{
+		touch();
+		LSQ_InsertFrontElement(handle_, value);
+	}
+	template <typename... Args>
+	reference emplace_back(Args &&... args)
+	{
+		push_back(value_type(std::forward<Args>(args)...));
+		return back();
+	}
+	template <typename... Args>
+	reference emplace_front(Args &&... args)
+	{
+		push_front(value_type(std::forward<Args>(args)...));
+		return front();
+	}
+	/* Inserts value before position and returns an iterator to it */
+	iterator insert(const_iterator position, const value_type & value)
+	{
+		touch();
+		LSQ_IteratorT iterator = LSQ_GetElementByIndex(handle_, position.index_);
+		LSQ_InsertElementBeforeGiven(iterator, value);
+		LSQ_DestroyIterator(iterator);
+		return begin() + position.index_;
+	}
+	template <typename... Args>
+	iterator emplace(const_iterator position, Args &&... args)
+	{
+		return insert(position, value_type(std::forward<Args>(args)...));
+	}
+	/* Removes the element at position and returns an iterator to the one that followed it */
+	iterator erase(const_iterator position)
+	{
+		touch();
+		LSQ_IteratorT iterator = LSQ_GetElementByIndex(handle_, position.index_);
+		LSQ_DeleteGivenElement(iterator);
+		LSQ_DestroyIterator(iterator);
+		return begin() + position.index_;
+	}
+	void pop_back()
+	{
+		touch();
+		LSQ_DeleteRearElement(handle_);
+	}
+	void pop_front()
+	{
+		touch();
+		LSQ_DeleteFrontElement(handle_);
+	}
+	void clear()
+	{
+		touch();
+		while (LSQ_GetSize(handle_) > 0)
+			LSQ_DeleteRearElement(handle_);
+	}
+
+	/* Calls function(pointer, count) for each run of contiguous elements, front to rear. The elements may be written *
+	 * in place but the sequence must not be modified otherwise until the call returns                                 */
+	template <typename Function>
+	void for_each_span(Function function)
+	{
+		iterator_holder holder = { LSQ_GetFrontElement(handle_) };
+		LSQ_BaseTypeT * span = NULL;
+		LSQ_IntegerIndexT count;
+		while ((count = LSQ_GetSpan(holder.iterator, &span)) > 0)
+		{
+			function(span, count);
+			LSQ_ShiftPosition(holder.iterator, count);
+		}
+	}
+	template <typename Function>
+	void for_each_span(Function function) const
+	{
+		iterator_holder holder = { LSQ_GetFrontElement(handle_) };
+		const LSQ_BaseTypeT * span = NULL;
+		LSQ_IntegerIndexT count;
+		while ((count = LSQ_PeekSpan(holder.iterator, &span)) > 0)
+		{
+			function(span, count);
+			LSQ_ShiftPosition(holder.iterator, count);
+		}
+	}
+
+private:
+	template <typename> friend class sequence_iterator;
+
+	struct iterator_holder
+	{
+		LSQ_IteratorT iterator;
+		~iterator_holder() { LSQ_DestroyIterator(iterator); }
+	};
+
+	sequence(const sequence &) = delete;
+	sequence & operator=(const sequence &) = delete;
+
+	/* Moves the cursor to index. The cursor is reused when moving forward, which makes a traversal cost one shift *
+	 * per span; it makes const member functions unsafe to call from several threads at once                       */
+	void seek(LSQ_IntegerIndexT index) const
+	{
+		if (cursor_ != LSQ_HandleInvalid && index >= cursor_index_)
+			LSQ_ShiftPosition(cursor_, index - cursor_index_);
+		else
+		{
+			LSQ_DestroyIterator(cursor_);
+			cursor_ = LSQ_GetElementByIndex(handle_, index);
+		}
+		cursor_index_ = index;
+	}
+	/* Fetches the span that starts at index, writable for an iterator and read-only for a const_iterator, which *
+	 * therefore does not unshare a cloned array                                                                 */
+	void fetch(LSQ_IntegerIndexT index, LSQ_BaseTypeT *& span, LSQ_IntegerIndexT & first, LSQ_IntegerIndexT & count) const
+	{
+		seek(index);
+		first = index;
+		count = LSQ_GetSpan(cursor_, &span);
+	}
+	void fetch(LSQ_IntegerIndexT index, const LSQ_BaseTypeT *& span, LSQ_IntegerIndexT & first,
+			   LSQ_IntegerIndexT & count) const
+	{
+		seek(index);
+		first = index;
+		count = LSQ_PeekSpan(cursor_, &span);
+	}
+
+	LSQ_HandleT handle_;
+	mutable LSQ_IteratorT cursor_;
+	mutable LSQ_IntegerIndexT cursor_index_;
+};
+
+template <typename Value>
+inline void sequence_iterator<Value>::fetch() const
+{
+	owner_->fetch(index_, span_, first_, count_);
+	if (count_ <= 0)
+		throw std::out_of_range("lsq::sequence_iterator");
+}
+
+inline void swap(sequence & first, sequence & second)
+{
+	first.swap(second);
+}
+
+}
+
+#endif
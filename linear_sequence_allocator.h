@@ -0,0 +1,50 @@
+#ifndef LINEAR_SEQUENCE_ALLOCATOR_H
+#define LINEAR_SEQUENCE_ALLOCATOR_H
+
+#include <stdlib.h>
+
+/* Allocator table used by a container for its handle, nodes, buffers and iterators.       *
+ * The header expects linear_sequence.h or linear_sequence_assoc.h to be included first.    */
+typedef struct
+{
+	void * (*allocate)(void * context, size_t size);
+	void * (*reallocate)(void * context, void * ptr, size_t old_size, size_t new_size);
+	void (*deallocate)(void * context, void * ptr, size_t size);
+	void * context;
+	/* Non-zero if the owner of the allocator releases all of its memory at once (see linear_sequence_arena.h). *
+	 * LSQ_DestroySequence then returns without walking the container and freeing every node.                   */
+	int releases_in_bulk;
+} LSQ_AllocatorT;
+
+/* Function that creates an empty container which takes all its memory from allocator. NULL means  *
+ * malloc/realloc/free. The table must stay valid until the container and its iterators are destroyed; *
+ * iterators keep a pointer to it, so they may be destroyed after their container                      */
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator);
+
+static __inline void * lsqAllocate(const LSQ_AllocatorT * allocator, size_t size)
+{
+	return (allocator == NULL) ? malloc(size) : allocator->allocate(allocator->context, size);
+}
+
+static __inline void * lsqReallocate(const LSQ_AllocatorT * allocator, void * ptr, size_t old_size, size_t new_size)
+{
+	return (allocator == NULL) ? realloc(ptr, new_size) :
+		allocator->reallocate(allocator->context, ptr, old_size, new_size);
+}
+
+static __inline void lsqDeallocate(const LSQ_AllocatorT * allocator, void * ptr, size_t size)
+{
+	if (ptr == NULL)
+		return;
+	if (allocator == NULL)
+		free(ptr);
+	else
+		allocator->deallocate(allocator->context, ptr, size);
+}
+
+static __inline int lsqReleasesInBulk(const LSQ_AllocatorT * allocator)
+{
+	return allocator != NULL && allocator->releases_in_bulk;
+}
+
+#endif
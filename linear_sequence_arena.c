@@ -0,0 +1,171 @@
+#include <string.h>
+#include <stdlib.h>
+#include "linear_sequence.h"
+#include "linear_sequence_arena.h"
+
+#define ARENA_DEFAULT_CHUNK_SIZE 65536
+#define ARENA_ALIGNMENT 16
+#define IS_HANDLE_INVALID(handle)(handle == LSQ_HandleInvalid)
+
+typedef struct ArenaChunkStruct
+{
+	struct ArenaChunkStruct * next;
+	size_t size;
+	size_t used;
+} ArenaChunkT;
+
+typedef struct
+{
+	LSQ_AllocatorT allocator;
+	ArenaChunkT * first_chunk;
+	ArenaChunkT * current_chunk;
+	void * last_allocation;
+	size_t chunk_size;
+	size_t usage;
+} ArenaT;
+
+static size_t alignSize(size_t size);
+
+static char * chunkData(ArenaChunkT * chunk);
+
+static ArenaChunkT * createChunk(size_t size);
+
+static void * arenaAllocate(void * context, size_t size);
+
+static void * arenaReallocate(void * context, void * ptr, size_t old_size, size_t new_size);
+
+static void arenaDeallocate(void * context, void * ptr, size_t size);
+
+
+static size_t alignSize(size_t size)
+{
+	return (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+}
+
+static char * chunkData(ArenaChunkT * chunk)
+{
+	return (char *)chunk + alignSize(sizeof(ArenaChunkT));
+}
+
+static ArenaChunkT * createChunk(size_t size)
+{
+	ArenaChunkT * chunk = (ArenaChunkT *)malloc(alignSize(sizeof(ArenaChunkT)) + size);
+	if (chunk == NULL)
+		return NULL;
+	chunk->next = NULL;
+	chunk->size = size;
+	chunk->used = 0;
+	return chunk;
+}
+
+static void * arenaAllocate(void * context, size_t size)
+{
+	ArenaT * arena = (ArenaT *)context;
+	ArenaChunkT * chunk = arena->current_chunk;
+	size = alignSize(size);
+	if (chunk->size - chunk->used < size)
+	{
+		chunk->next = createChunk(size > arena->chunk_size ? size : arena->chunk_size);
+		if (chunk->next == NULL)
+			return NULL;
+		chunk = chunk->next;
+		arena->current_chunk = chunk;
+	}
+	arena->last_allocation = chunkData(chunk) + chunk->used;
+	chunk->used += size;
+	arena->usage += size;
+	return arena->last_allocation;
+}
+
+static void * arenaReallocate(void * context, void * ptr, size_t old_size, size_t new_size)
+{
+	ArenaT * arena = (ArenaT *)context;
+	ArenaChunkT * chunk = arena->current_chunk;
+	void * new_ptr = NULL;
+	if (ptr == NULL)
+		return arenaAllocate(context, new_size);
+	old_size = alignSize(old_size);
+	if (ptr == arena->last_allocation && chunk->used - old_size + alignSize(new_size) <= chunk->size)
+	{
+		chunk->used = chunk->used - old_size + alignSize(new_size);
+		arena->usage = arena->usage - old_size + alignSize(new_size);
+		return ptr;
+	}
+	new_ptr = arenaAllocate(context, new_size);
+	if (new_ptr == NULL)
+		return NULL;
+	memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+	return new_ptr;
+}
+
+static void arenaDeallocate(void * context, void * ptr, size_t size)
+{
+	ArenaT * arena = (ArenaT *)context;
+	if (ptr != arena->last_allocation)
+		return;
+	size = alignSize(size);
+	arena->current_chunk->used -= size;
+	arena->usage -= size;
+	arena->last_allocation = NULL;
+}
+
+extern LSQ_ArenaT LSQ_CreateArena(size_t chunk_size)
+{
+	ArenaT * arena = (ArenaT *)malloc(sizeof(ArenaT));
+	if (arena == NULL)
+		return LSQ_ArenaInvalid;
+	arena->chunk_size = (chunk_size == 0) ? ARENA_DEFAULT_CHUNK_SIZE : alignSize(chunk_size);
+	arena->first_chunk = createChunk(arena->chunk_size);
+	if (arena->first_chunk == NULL)
+	{
+		free(arena);
+		return LSQ_ArenaInvalid;
+	}
+	arena->current_chunk = arena->first_chunk;
+	arena->last_allocation = NULL;
+	arena->usage = 0;
+	arena->allocator.allocate = arenaAllocate;
+	arena->allocator.reallocate = arenaReallocate;
+	arena->allocator.deallocate = arenaDeallocate;
+	arena->allocator.context = arena;
+	arena->allocator.releases_in_bulk = 1;
+	return arena;
+}
+
+extern void LSQ_DestroyArena(LSQ_ArenaT arena)
+{
+	ArenaT * tmp_arena = (ArenaT *)arena;
+	if (IS_HANDLE_INVALID(arena))
+		return;
+	LSQ_ResetArena(arena);
+	free(tmp_arena->first_chunk);
+	free(tmp_arena);
+}
+
+extern void LSQ_ResetArena(LSQ_ArenaT arena)
+{
+	ArenaT * tmp_arena = (ArenaT *)arena;
+	ArenaChunkT * chunk = NULL, * next_chunk = NULL;
+	if (IS_HANDLE_INVALID(arena))
+		return;
+	for (chunk = tmp_arena->first_chunk->next; chunk != NULL; chunk = next_chunk)
+	{
+		next_chunk = chunk->next;
+		free(chunk);
+	}
+	tmp_arena->first_chunk->next = NULL;
+	tmp_arena->first_chunk->used = 0;
+	tmp_arena->current_chunk = tmp_arena->first_chunk;
+	tmp_arena->last_allocation = NULL;
+	tmp_arena->usage = 0;
+}
+
+extern const LSQ_AllocatorT * LSQ_GetArenaAllocator(LSQ_ArenaT arena)
+{
+	return IS_HANDLE_INVALID(arena) ? NULL : &((ArenaT *)arena)->allocator;
+}
+
+extern size_t LSQ_GetArenaUsage(LSQ_ArenaT arena)
+{
+	return IS_HANDLE_INVALID(arena) ? 0 : ((ArenaT *)arena)->usage;
+}
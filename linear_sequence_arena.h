@@ -0,0 +1,25 @@
+#ifndef LINEAR_SEQUENCE_ARENA_H
+#define LINEAR_SEQUENCE_ARENA_H
+
+#include "linear_sequence_allocator.h"
+
+/* Bump allocator for short-lived containers. Containers created with its allocator are destroyed in O(1), *
+ * and all of their memory is given back by LSQ_ResetArena or LSQ_DestroyArena.                            */
+typedef void * LSQ_ArenaT;
+
+#define LSQ_ArenaInvalid NULL
+
+/* Function that creates an arena which requests memory from the system in chunks of chunk_size bytes. *
+ * Zero selects the default chunk size                                                                   */
+extern LSQ_ArenaT LSQ_CreateArena(size_t chunk_size);
+/* Function that destroys the arena and every container allocated from it */
+extern void LSQ_DestroyArena(LSQ_ArenaT arena);
+/* Function that releases everything allocated from the arena, keeping the first chunk for reuse */
+extern void LSQ_ResetArena(LSQ_ArenaT arena);
+
+/* Function that returns the allocator table of the arena for LSQ_CreateSequenceWithAllocator */
+extern const LSQ_AllocatorT * LSQ_GetArenaAllocator(LSQ_ArenaT arena);
+/* Function that returns the number of bytes currently handed out by the arena */
+extern size_t LSQ_GetArenaUsage(LSQ_ArenaT arena);
+
+#endif
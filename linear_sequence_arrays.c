@@ -2,8 +2,13 @@
 #include <string.h>
 #include <stdlib.h>
 #include "linear_sequence.h"
+#include "linear_sequence_capacity.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_span.h"
 
-#define LSQ_BASE_ARRAY_PHYS_SIZE 10;
+#define LSQ_BASE_ARRAY_PHYS_SIZE 10
+#define LSQ_DEFAULT_GROWTH_FACTOR 2.0
+#define LSQ_DEFAULT_SHRINK_THRESHOLD 0.25
 #define isHandleInvalid(handle)(handle == LSQ_HandleInvalid)
 
 typedef enum 
@@ -18,6 +23,8 @@ typedef struct
 	LSQ_BaseTypeT * data_ptr;
 	int physical_size;
 	int logical_size;
+	LSQ_GrowthPolicyT policy;
+	const LSQ_AllocatorT * allocator;
 } ArrayDataT;
 
 typedef struct 
@@ -25,13 +32,20 @@ typedef struct
 	ArrayDataT * array_data;
 	IteratorPosKindT position_kind;
 	LSQ_IntegerIndexT index;
+	const LSQ_AllocatorT * allocator;
 } IteratorT;
 
 static int isContainerFull(ArrayDataT * handle);
 
 static LSQ_IteratorT createIterator(LSQ_HandleT handle);
 
-static void setContainerSize(ArrayDataT * handle, int size);
+static int setContainerSize(ArrayDataT * handle, int size);
+
+static int growContainer(ArrayDataT * handle, int required_size);
+
+static void shrinkContainer(ArrayDataT * handle);
+
+static void setDefaultPolicy(LSQ_GrowthPolicyT * policy);
 
 
 
@@ -40,13 +54,60 @@ static int isContainerFull(ArrayDataT * handle)
 	return (isHandleInvalid(handle)) ? -1 : handle->logical_size == handle->physical_size;	
 }
 
-static void setContainerSize(ArrayDataT * handle, int size)
+static int setContainerSize(ArrayDataT * handle, int size)
 {
+	LSQ_BaseTypeT * data_ptr = NULL;
 	if (isHandleInvalid(handle)) 
-		return;
+		return 0;
+	if (size == 0)
+	{
+		lsqDeallocate(handle->allocator, handle->data_ptr, handle->physical_size * sizeof(LSQ_BaseTypeT));
+		handle->data_ptr = NULL;
+		handle->physical_size = 0;
+		return 1;
+	}
+	data_ptr = (LSQ_BaseTypeT *)lsqReallocate(handle->allocator, handle->data_ptr, 
+											 handle->physical_size * sizeof(LSQ_BaseTypeT), size * sizeof(LSQ_BaseTypeT));
+	if isHandleInvalid(data_ptr)
+		return 0;
+	handle->data_ptr = data_ptr;
 	handle->physical_size = size;
-	handle->data_ptr = (LSQ_BaseTypeT *)realloc(handle->data_ptr, 
-												size * sizeof(LSQ_BaseTypeT));
+	return 1;
+}
+
+static int growContainer(ArrayDataT * handle, int required_size)
+{
+	int new_size = handle->physical_size, next_size;
+	if (required_size <= handle->physical_size)
+		return 1;
+	if (new_size < handle->policy.min_capacity)
+		new_size = handle->policy.min_capacity;
+	while (new_size < required_size)
+	{
+		next_size = (int)(new_size * handle->policy.growth_factor);
+		new_size = (next_size > new_size) ? next_size : new_size + 1;
+	}
+	return setContainerSize(handle, new_size);
+}
+
+static void shrinkContainer(ArrayDataT * handle)
+{
+	int new_size;
+	if (handle->policy.shrink_threshold <= 0.0 || handle->physical_size <= handle->policy.min_capacity ||
+		handle->logical_size > handle->physical_size * handle->policy.shrink_threshold)
+		return;
+	new_size = (int)(handle->logical_size * handle->policy.growth_factor);
+	if (new_size < handle->policy.min_capacity)
+		new_size = handle->policy.min_capacity;
+	if (new_size < handle->physical_size)
+		setContainerSize(handle, new_size);
+}
+
+static void setDefaultPolicy(LSQ_GrowthPolicyT * policy)
+{
+	policy->growth_factor = LSQ_DEFAULT_GROWTH_FACTOR;
+	policy->shrink_threshold = LSQ_DEFAULT_SHRINK_THRESHOLD;
+	policy->min_capacity = LSQ_BASE_ARRAY_PHYS_SIZE;
 }
 
 static LSQ_IteratorT createIterator(LSQ_HandleT handle)
@@ -54,32 +115,40 @@ static LSQ_IteratorT createIterator(LSQ_HandleT handle)
 	IteratorT * iterator = NULL;
 	if(isHandleInvalid(handle)) 
 		return LSQ_HandleInvalid;
-	iterator = (IteratorT *)malloc(sizeof(IteratorT));
+	iterator = (IteratorT *)lsqAllocate(((ArrayDataT *)handle)->allocator, sizeof(IteratorT));
 	if isHandleInvalid(iterator) 
 		return LSQ_HandleInvalid;
+	iterator->allocator = ((ArrayDataT *)handle)->allocator;
 	iterator->array_data = (ArrayDataT *)handle;
 	return iterator;
 }
 
 extern LSQ_HandleT LSQ_CreateSequence(void) 
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
 {
 	ArrayDataT * array_data = NULL;
-	array_data = (ArrayDataT *)malloc(sizeof(ArrayDataT));
+	array_data = (ArrayDataT *)lsqAllocate(allocator, sizeof(ArrayDataT));
 	if isHandleInvalid(array_data)
 		return LSQ_HandleInvalid;
+	array_data->allocator = allocator;
 	array_data->data_ptr = NULL;
 	array_data->physical_size = 0;
 	array_data->logical_size = 0;
+	setDefaultPolicy(&array_data->policy);
 	return array_data;
 }
 
 extern void LSQ_DestroySequence(LSQ_HandleT handle) 
 {
 	ArrayDataT * tmp_array = (ArrayDataT *)handle;
-	if isHandleInvalid(handle)
+	if (isHandleInvalid(handle) || lsqReleasesInBulk(tmp_array->allocator))
 		return;
-	free(tmp_array->data_ptr);
-	free(handle);
+	lsqDeallocate(tmp_array->allocator, tmp_array->data_ptr, tmp_array->physical_size * sizeof(LSQ_BaseTypeT));
+	lsqDeallocate(tmp_array->allocator, handle, sizeof(ArrayDataT));
 }
 
 extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
@@ -146,7 +215,7 @@ extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
 {
 	if (isHandleInvalid(iterator))  
 		return;
-	free(iterator);
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
 }
 
 extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
@@ -204,18 +273,15 @@ extern void LSQ_InsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT n
 {
 	IteratorT * tmp_iterator = (IteratorT *)iterator;
     ArrayDataT * tmp_array = NULL;
-	int * element_ptr = NULL, tmp_size = LSQ_BASE_ARRAY_PHYS_SIZE;
+	int * element_ptr = NULL;
 
     if (isHandleInvalid(iterator))
     {
         return;
     }
 	tmp_array = tmp_iterator->array_data;
-	if (isContainerFull(tmp_array))
-	{
-		tmp_size = tmp_array->physical_size + LSQ_BASE_ARRAY_PHYS_SIZE;
-		setContainerSize(tmp_array, tmp_size);
-	}
+	if (isContainerFull(tmp_array) && !growContainer(tmp_array, tmp_array->logical_size + 1))
+		return;
 	tmp_array->logical_size++;
 	memmove(tmp_array->data_ptr + tmp_iterator->index + 1, 
 			tmp_array->data_ptr + tmp_iterator->index , 
@@ -243,7 +309,6 @@ extern void LSQ_DeleteGivenElement(LSQ_IteratorT iterator)
 {
 	IteratorT * tmp_iterator = (IteratorT *)iterator;
     ArrayDataT * tmp_array = NULL;
-	int tmp_size = LSQ_BASE_ARRAY_PHYS_SIZE;
 
     if (!LSQ_IsIteratorDereferencable(iterator))
     {
@@ -254,9 +319,63 @@ extern void LSQ_DeleteGivenElement(LSQ_IteratorT iterator)
 	memmove(tmp_array->data_ptr + tmp_iterator->index, 
 			tmp_array->data_ptr + tmp_iterator->index + 1, 
 			sizeof(LSQ_BaseTypeT) * (tmp_array->logical_size - tmp_iterator->index));
-	if ((tmp_array->physical_size - tmp_array->logical_size) >= tmp_size)
-	{
-		tmp_size = tmp_array->physical_size - LSQ_BASE_ARRAY_PHYS_SIZE;
-		setContainerSize(tmp_array, tmp_size);
-	}
-}
\ No newline at end of file
+	shrinkContainer(tmp_array);
+}
+
+extern void LSQ_SetGrowthPolicy(LSQ_HandleT handle, const LSQ_GrowthPolicyT * policy)
+{
+	ArrayDataT * tmp_array = (ArrayDataT *)handle;
+	if (isHandleInvalid(handle) || isHandleInvalid(policy))
+		return;
+	setDefaultPolicy(&tmp_array->policy);
+	if (policy->growth_factor > 1.0)
+		tmp_array->policy.growth_factor = policy->growth_factor;
+	if (policy->min_capacity >= 0)
+		tmp_array->policy.min_capacity = policy->min_capacity;
+	tmp_array->policy.shrink_threshold = 0.0;
+	if (policy->shrink_threshold > 0.0)
+		tmp_array->policy.shrink_threshold = (policy->shrink_threshold * tmp_array->policy.growth_factor < 1.0) ?
+			policy->shrink_threshold : 0.5 / tmp_array->policy.growth_factor;
+}
+
+extern void LSQ_GetGrowthPolicy(LSQ_HandleT handle, LSQ_GrowthPolicyT * policy)
+{
+	if (isHandleInvalid(handle) || isHandleInvalid(policy))
+		return;
+	*policy = ((ArrayDataT *)handle)->policy;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetCapacity(LSQ_HandleT handle)
+{
+	return (isHandleInvalid(handle)) ? -1 : ((ArrayDataT *)handle)->physical_size;
+}
+
+extern void LSQ_ReserveCapacity(LSQ_HandleT handle, LSQ_IntegerIndexT capacity)
+{
+	ArrayDataT * tmp_array = (ArrayDataT *)handle;
+	if (isHandleInvalid(handle) || capacity <= tmp_array->physical_size)
+		return;
+	setContainerSize(tmp_array, capacity);
+}
+
+extern void LSQ_ShrinkToFit(LSQ_HandleT handle)
+{
+	ArrayDataT * tmp_array = (ArrayDataT *)handle;
+	if (isHandleInvalid(handle) || tmp_array->physical_size == tmp_array->logical_size)
+		return;
+	setContainerSize(tmp_array, tmp_array->logical_size);
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSpan(LSQ_IteratorT iterator, LSQ_BaseTypeT ** span)
+{
+	IteratorT * tmp_iterator = (IteratorT *)iterator;
+	if (isHandleInvalid(span))
+		return 0;
+	*span = LSQ_DereferenceIterator(iterator);
+	return (*span == NULL) ? 0 : tmp_iterator->array_data->logical_size - tmp_iterator->index;
+}
+
+extern LSQ_IntegerIndexT LSQ_PeekSpan(LSQ_IteratorT iterator, const LSQ_BaseTypeT ** span)
+{
+	return LSQ_GetSpan(iterator, (LSQ_BaseTypeT **)span);
+}
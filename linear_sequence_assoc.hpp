@@ -0,0 +1,296 @@
+#ifndef LINEAR_SEQUENCE_ASSOC_HPP
+#define LINEAR_SEQUENCE_ASSOC_HPP
+
+/* Header-only C++ layer over avl_tree.c, the ordered map counterpart of linear_sequence.hpp; the two cannot be     *
+ * used in one translation unit since their C headers share an include guard. lsq::map owns a handle and offers the *
+ * usual ordered map interface with bidirectional iterators. Dereferencing an iterator yields the mapped value and  *
+ * key() yields the key, as in the C API. Iterators own an iterator of avl_tree.c and therefore stay on their key   *
+ * across modifications of the map, moving to the next key if theirs is erased; copying one looks its key up again  *
+ * in O(log n), so loops should prefer the prefix increments. A const_iterator reads through LSQ_PeekIterator,      *
+ * which neither unshares a clone nor marks the value as written for the aggregates. Copying a map clones it in     *
+ * O(1) until either copy is modified. Functions that allocate fail silently like the C API they call, except       *
+ * constructors, including those of iterators, and writable dereferences, which throw std::bad_alloc.               */
+
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+extern "C" {
+#include "linear_sequence_assoc.h"
+#include "linear_sequence_clone.h"
+#include "assoc_array_hint.h"
+}
+
+namespace lsq
+{
+
+class map;
+
+/* Bidirectional iterator of map; Value is LSQ_BaseTypeT or const LSQ_BaseTypeT */
+template <typename Value>
+class map_iterator
+{
+public:
+	typedef std::bidirectional_iterator_tag iterator_category;
+	typedef LSQ_BaseTypeT value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef Value * pointer;
+	typedef Value & reference;
+
+	map_iterator() : handle_(LSQ_HandleInvalid), iterator_(LSQ_HandleInvalid) {}
+	/* Copies an iterator, or converts iterator to const_iterator, by finding its position again */
+	map_iterator(const map_iterator & other) : handle_(other.handle_), iterator_(other.copy()) {}
+	template <typename Other, typename = typename std::enable_if<std::is_const<Value>::value &&
+																   !std::is_const<Other>::value>::type>
+	map_iterator(const map_iterator<Other> & other) : handle_(other.handle_), iterator_(other.copy()) {}
+	map_iterator(map_iterator && other) : handle_(other.handle_), iterator_(other.iterator_)
+	{
+		other.iterator_ = LSQ_HandleInvalid;
+	}
+	map_iterator & operator=(map_iterator other)
+	{
+		std::swap(handle_, other.handle_);
+		std::swap(iterator_, other.iterator_);
+		return *this;
+	}
+	~map_iterator() { LSQ_DestroyIterator(iterator_); }
+
+	reference operator*() const { return *element(iterator_, pointer()); }
+	pointer operator->() const { return element(iterator_, pointer()); }
+	/* Key of the element */
+	LSQ_IntegerIndexT key() const { return LSQ_GetIteratorKey(iterator_); }
+
+	map_iterator & operator++() { LSQ_AdvanceOneElement(iterator_); return *this; }
+	map_iterator & operator--() { LSQ_RewindOneElement(iterator_); return *this; }
+	map_iterator operator++(int) { map_iterator old(*this); ++*this; return old; }
+	map_iterator operator--(int) { map_iterator old(*this); --*this; return old; }
+
+	template <typename Other>
+	bool operator==(const map_iterator<Other> & other) const
+	{
+		int dereferencable = LSQ_IsIteratorDereferencable(iterator_);
+		if (handle_ != other.handle_ || dereferencable != LSQ_IsIteratorDereferencable(other.iterator_))
+			return false;
+		if (dereferencable)
+			return key() == other.key();
+		return LSQ_IsIteratorPastRear(iterator_) == LSQ_IsIteratorPastRear(other.iterator_);
+	}
+	template <typename Other>
+	bool operator!=(const map_iterator<Other> & other) const { return !(*this == other); }
+
+private:
+	friend class map;
+	template <typename> friend class map_iterator;
+
+	/* Takes ownership of an iterator of handle, throwing if the backend could not create it */
+	map_iterator(LSQ_HandleT handle, LSQ_IteratorT iterator) : handle_(handle), iterator_(iterator)
+	{
+		if (iterator_ == LSQ_HandleInvalid)
+			throw std::bad_alloc();
+	}
+
+	/* Returns a new iterator of the backend at the same position */
+	LSQ_IteratorT copy() const
+	{
+		LSQ_IteratorT result = LSQ_HandleInvalid;
+		if (iterator_ == LSQ_HandleInvalid)
+			return LSQ_HandleInvalid;
+		if (LSQ_IsIteratorDereferencable(iterator_))
+			result = LSQ_GetElementByIndex(handle_, key());
+		else if (LSQ_IsIteratorPastRear(iterator_))
+			result = LSQ_GetPastRearElement(handle_);
+		else
+		{
+			result = LSQ_GetFrontElement(handle_);
+			LSQ_RewindOneElement(result);
+		}
+		if (result == LSQ_HandleInvalid)
+			throw std::bad_alloc();
+		return result;
+	}
+
+	/* A writable dereference unshares a cloned map and may fail to allocate */
+	static LSQ_BaseTypeT * element(LSQ_IteratorT iterator, LSQ_BaseTypeT *)
+	{
+		LSQ_BaseTypeT * value = LSQ_DereferenceIterator(iterator);
+		if (value == NULL)
+			throw std::bad_alloc();
+		return value;
+	}
+	static const LSQ_BaseTypeT * element(LSQ_IteratorT iterator, const LSQ_BaseTypeT *)
+	{
+		return LSQ_PeekIterator(iterator);
+	}
+
+	LSQ_HandleT handle_;
+	LSQ_IteratorT iterator_;
+};
+
+/* Owning container over a map handle. Copies share the nodes until either of them is modified */
+class map
+{
+public:
+	typedef LSQ_IntegerIndexT key_type;
+	typedef LSQ_BaseTypeT mapped_type;
+	typedef LSQ_BaseTypeT value_type;
+	typedef LSQ_IntegerIndexT size_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef LSQ_BaseTypeT & reference;
+	typedef const LSQ_BaseTypeT & const_reference;
+	typedef map_iterator<LSQ_BaseTypeT> iterator;
+	typedef map_iterator<const LSQ_BaseTypeT> const_iterator;
+	typedef std::reverse_iterator<iterator> reverse_iterator;
+	typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+	map() : handle_(LSQ_CreateSequence())
+	{
+		if (handle_ == LSQ_HandleInvalid)
+			throw std::bad_alloc();
+	}
+	/* Takes ownership of a handle created by LSQ_CreateSequence or another function of the backend */
+	explicit map(LSQ_HandleT handle) : handle_(handle) {}
+	map(const map & other) : handle_(LSQ_CloneSequence(other.handle_))
+	{
+		if (handle_ == LSQ_HandleInvalid && other.handle_ != LSQ_HandleInvalid)
+			throw std::bad_alloc();
+	}
+	map(map && other) : handle_(other.handle_)
+	{
+		other.handle_ = LSQ_HandleInvalid;
+	}
+	map & operator=(map other)
+	{
+		swap(other);
+		return *this;
+	}
+	~map() { LSQ_DestroySequence(handle_); }
+
+	/* Handle for calling the C API directly */
+	LSQ_HandleT handle() const { return handle_; }
+	/* Releases the handle to the caller, leaving the map without one */
+	LSQ_HandleT release()
+	{
+		LSQ_HandleT handle = handle_;
+		handle_ = LSQ_HandleInvalid;
+		return handle;
+	}
+	void swap(map & other) { std::swap(handle_, other.handle_); }
+
+	size_type size() const { return LSQ_GetSize(handle_); }
+	bool empty() const { return size() == 0; }
+
+	iterator begin() { return iterator(handle_, LSQ_GetFrontElement(handle_)); }
+	iterator end() { return iterator(handle_, LSQ_GetPastRearElement(handle_)); }
+	const_iterator begin() const { return const_iterator(handle_, LSQ_GetFrontElement(handle_)); }
+	const_iterator end() const { return const_iterator(handle_, LSQ_GetPastRearElement(handle_)); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin() { return reverse_iterator(end()); }
+	reverse_iterator rend() { return reverse_iterator(begin()); }
+	const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+	const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+	/* Returns the element of key, or end() */
+	iterator find(key_type key) { return locate<iterator>(key); }
+	const_iterator find(key_type key) const { return locate<const_iterator>(key); }
+	size_type count(key_type key) const { return LSQ_IsIteratorDereferencable(find(key).iterator_); }
+
+	reference at(key_type key)
+	{
+		iterator position = find(key);
+		if (!LSQ_IsIteratorDereferencable(position.iterator_))
+			throw std::out_of_range("lsq::map::at");
+		return *position;
+	}
+	const_reference at(key_type key) const
+	{
+		const_iterator position = find(key);
+		if (!LSQ_IsIteratorDereferencable(position.iterator_))
+			throw std::out_of_range("lsq::map::at");
+		return *position;
+	}
+	/* Returns the value of key, inserting a value-initialized one first if the key is absent. The reference stays *
+	 * valid until the next modification                                                                           */
+	reference operator[](key_type key)
+	{
+		iterator position = find(key);
+		if (LSQ_IsIteratorDereferencable(position.iterator_))
+			return *position;
+		return *insert_or_assign(key, mapped_type()).first;
+	}
+
+	/* Inserts key unless it is present; returns the element of key and whether it was inserted */
+	std::pair<iterator, bool> insert(key_type key, const mapped_type & value)
+	{
+		iterator position = find(key);
+		if (LSQ_IsIteratorDereferencable(position.iterator_))
+			return std::make_pair(std::move(position), false);
+		LSQ_InsertElement(handle_, key, value);
+		return std::make_pair(find(key), true);
+	}
+	template <typename... Args>
+	std::pair<iterator, bool> emplace(key_type key, Args &&... args)
+	{
+		return insert(key, mapped_type(std::forward<Args>(args)...));
+	}
+	/* Inserts key or overwrites its value; returns the element of key and whether it was inserted */
+	std::pair<iterator, bool> insert_or_assign(key_type key, const mapped_type & value)
+	{
+		size_type old_size = size();
+		LSQ_InsertElement(handle_, key, value);
+		return std::make_pair(find(key), size() != old_size);
+	}
+	/* Same, starting the search from hint, which costs O(log d) for a key d positions away from it */
+	iterator insert_or_assign(const_iterator hint, key_type key, const mapped_type & value)
+	{
+		LSQ_InsertElementWithHint(handle_, hint.iterator_, key, value);
+		return find(key);
+	}
+
+	/* Removes the element at position and returns an iterator to the one that followed it */
+	iterator erase(const_iterator position)
+	{
+		iterator next = locate<iterator>(position.key());
+		LSQ_DeleteElement(handle_, position.key());
+		return next;
+	}
+	/* Removes key and returns the number of elements removed */
+	size_type erase(key_type key)
+	{
+		size_type old_size = size();
+		LSQ_DeleteElement(handle_, key);
+		return old_size - size();
+	}
+	void clear()
+	{
+		while (LSQ_GetSize(handle_) > 0)
+			LSQ_DeleteRearElement(handle_);
+	}
+
+private:
+	template <typename Iterator>
+	Iterator locate(key_type key) const
+	{
+		LSQ_IteratorT iterator = LSQ_GetElementByIndex(handle_, key);
+		if (iterator != LSQ_HandleInvalid && !LSQ_IsIteratorDereferencable(iterator))
+		{
+			LSQ_DestroyIterator(iterator);
+			iterator = LSQ_GetPastRearElement(handle_);
+		}
+		return Iterator(handle_, iterator);
+	}
+
+	LSQ_HandleT handle_;
+};
+
+inline void swap(map & first, map & second)
+{
+	first.swap(second);
+}
+
+}
+
+#endif
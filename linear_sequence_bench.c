@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "linear_sequence.h"
+#include "linear_sequence_heap.h"
+#include "linear_sequence_queue.h"
+#include "linear_sequence_allocator.h"
+
+/* Single-threaded benchmarks for the functions that linear_sequence_dyn_arrays.c adds to the sequence interface:  *
+ *     cc -O2 linear_sequence_bench.c linear_sequence_dyn_arrays.c -o bench_sequence                               *
+ * Usage: bench heap [elements] [arity] [random | timer] [operations]                                              *
+ *        bench queue [spsc | mpmc | sequence] [batch] [items]                                                     *
+ *        bench small [elements per array] [arrays]                                                                *
+ * heap pops the minimum of a heap of the given size and pushes a new element, operations times. Random priorities *
+ * are uniform; timer priorities are the popped one plus a random delay, as in a timer queue. To compare the       *
+ * arities, run e.g.                                                                                               *
+ *     bench heap 1000 2 random      bench heap 1000 4 random                                                      *
+ *     bench heap 1000000 2 timer    bench heap 1000000 4 timer                                                    *
+ * queue passes items through the queue on one thread, a batch in and the same batch out, which measures the cost  *
+ * of the queue operations alone; sequence does the same with LSQ_InsertRearElement, an iterator on the front      *
+ * element and LSQ_DeleteFrontElement.                                                                             *
+ * small fills many arrays with a few elements each and reports the heap bytes per array, counted by an allocator, *
+ * and the time to build and scan one. Arrays of up to 16 elements keep them inside their handle.                  */
+
+static unsigned int nextRandom(unsigned int * state)
+{
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static double elapsedSeconds(const struct timespec * start, const struct timespec * finish)
+{
+	return (finish->tv_sec - start->tv_sec) + (finish->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int runHeap(int argc, char ** argv)
+{
+	int elements = (argc > 0) ? atoi(argv[0]) : 1000000;
+	int arity = (argc > 1) ? atoi(argv[1]) : 2;
+	int timer = (argc > 2) && strcmp(argv[2], "timer") == 0;
+	int operations = (argc > 3) ? atoi(argv[3]) : 4000000;
+	unsigned int seed = 2463534242u;
+	LSQ_HandleT handle = LSQ_HandleInvalid;
+	LSQ_BaseTypeT * priorities = NULL;
+	LSQ_BaseTypeT priority = 0;
+	struct timespec start, finish;
+	long long checksum = 0;
+	int i;
+
+	if (elements < 1 || arity < 2 || operations < 1)
+		return 0;
+	handle = LSQ_CreateSequence();
+	priorities = (LSQ_BaseTypeT *)malloc(elements * sizeof(LSQ_BaseTypeT));
+	if (handle == LSQ_HandleInvalid || priorities == NULL)
+		return 0;
+	/* Timer delays stay below twice the heap size, so the minimum grows by about one per operation */
+	for (i = 0; i < elements; i++)
+		priorities[i] = (LSQ_BaseTypeT)(nextRandom(&seed) % (timer ? 2u * elements : 1u << 30));
+	LSQ_SetHeapArity(handle, arity);
+	LSQ_HeapBuild(handle, priorities, elements);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < operations; i++)
+	{
+		LSQ_HeapPop(handle, &priority);
+		checksum += priority;
+		if (timer)
+			priority += 1 + (LSQ_BaseTypeT)(nextRandom(&seed) % (2u * elements));
+		else
+			priority = (LSQ_BaseTypeT)(nextRandom(&seed) % (1u << 30));
+		LSQ_HeapPush(handle, priority);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	printf("heap of %d, arity %d, %s priorities: %.1f ns per pop and push, checksum %lld\n", elements, arity,
+		timer ? "timer" : "random", elapsedSeconds(&start, &finish) * 1e9 / operations, checksum);
+	LSQ_DestroySequence(handle);
+	free(priorities);
+	return 1;
+}
+
+static int runQueue(int argc, char ** argv)
+{
+	const char * mode = (argc > 0) ? argv[0] : "spsc";
+	int batch = (argc > 1) ? atoi(argv[1]) : 1;
+	int items = (argc > 2) ? atoi(argv[2]) : 20000000;
+	int sequence = strcmp(mode, "sequence") == 0;
+	LSQ_HandleT handle = LSQ_HandleInvalid;
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_BaseTypeT * buffer = NULL;
+	struct timespec start, finish;
+	long long checksum = 0;
+	int i, j;
+
+	if (batch < 1 || items < batch || (!sequence && strcmp(mode, "spsc") != 0 && strcmp(mode, "mpmc") != 0))
+		return 0;
+	handle = LSQ_CreateSequence();
+	buffer = (LSQ_BaseTypeT *)malloc(batch * sizeof(LSQ_BaseTypeT));
+	if (handle == LSQ_HandleInvalid || buffer == NULL)
+		return 0;
+	if (!sequence && !LSQ_StartQueueMode(handle, batch, strcmp(mode, "spsc") == 0 ? LSQ_QUEUE_SPSC : LSQ_QUEUE_MPMC))
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i + batch <= items; i += batch)
+	{
+		if (sequence)
+		{
+			for (j = 0; j < batch; j++)
+				LSQ_InsertRearElement(handle, i + j);
+			for (j = 0; j < batch; j++)
+			{
+				iterator = LSQ_GetFrontElement(handle);
+				checksum += *LSQ_DereferenceIterator(iterator);
+				LSQ_DestroyIterator(iterator);
+				LSQ_DeleteFrontElement(handle);
+			}
+		}
+		else if (batch == 1)
+		{
+			LSQ_TryEnqueue(handle, i);
+			LSQ_TryDequeue(handle, buffer);
+			checksum += buffer[0];
+		}
+		else
+		{
+			for (j = 0; j < batch; j++)
+				buffer[j] = i + j;
+			LSQ_EnqueueBatch(handle, buffer, batch);
+			LSQ_DequeueBatch(handle, buffer, batch);
+			for (j = 0; j < batch; j++)
+				checksum += buffer[j];
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	printf("%s, batch %d: %.0f items/s, checksum %lld\n", mode, batch,
+		(items - items % batch) / elapsedSeconds(&start, &finish), checksum);
+	if (!sequence)
+		LSQ_StopQueueMode(handle);
+	LSQ_DestroySequence(handle);
+	free(buffer);
+	return 1;
+}
+
+/* Allocator that keeps the number of bytes in use in the long long its context points to */
+static void * countingAllocate(void * context, size_t size)
+{
+	void * ptr = malloc(size);
+	if (ptr != NULL)
+		*(long long *)context += size;
+	return ptr;
+}
+
+static void * countingReallocate(void * context, void * ptr, size_t old_size, size_t new_size)
+{
+	void * new_ptr = realloc(ptr, new_size);
+	if (new_ptr != NULL)
+		*(long long *)context += (long long)new_size - (long long)old_size;
+	return new_ptr;
+}
+
+static void countingDeallocate(void * context, void * ptr, size_t size)
+{
+	*(long long *)context -= size;
+	free(ptr);
+}
+
+/* Fills count containers with size elements each, either from allocator or from the default one */
+static void fillContainers(LSQ_HandleT * handles, int count, int size, const LSQ_AllocatorT * allocator)
+{
+	int i, j;
+	for (i = 0; i < count; i++)
+	{
+		handles[i] = (allocator == NULL) ? LSQ_CreateSequence() : LSQ_CreateSequenceWithAllocator(allocator);
+		for (j = 0; j < size; j++)
+			LSQ_InsertRearElement(handles[i], j);
+	}
+}
+
+static int runSmall(int argc, char ** argv)
+{
+	int size = (argc > 0) ? atoi(argv[0]) : 12;
+	int count = (argc > 1) ? atoi(argv[1]) : 1000000;
+	LSQ_HandleT * handles = NULL;
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_AllocatorT allocator;
+	struct timespec start, middle, finish;
+	long long bytes = 0, checksum = 0;
+	int i;
+
+	if (size < 0 || count < 1)
+		return 0;
+	handles = (LSQ_HandleT *)malloc(count * sizeof(LSQ_HandleT));
+	if (handles == NULL)
+		return 0;
+	allocator.allocate = countingAllocate;
+	allocator.reallocate = countingReallocate;
+	allocator.deallocate = countingDeallocate;
+	allocator.context = &bytes;
+	allocator.releases_in_bulk = 0;
+	fillContainers(handles, count, size, &allocator);
+	printf("%d arrays of %d elements: %.1f bytes each", count, size, (double)bytes / count);
+	for (i = 0; i < count; i++)
+		LSQ_DestroySequence(handles[i]);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	fillContainers(handles, count, size, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &middle);
+	for (i = 0; i < count; i++)
+	{
+		for (iterator = LSQ_GetFrontElement(handles[i]); LSQ_IsIteratorDereferencable(iterator);
+			 LSQ_AdvanceOneElement(iterator))
+			checksum += *LSQ_DereferenceIterator(iterator);
+		LSQ_DestroyIterator(iterator);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	printf(", %.0f ns to build and %.0f ns to scan each, checksum %lld\n", elapsedSeconds(&start, &middle) * 1e9 / count,
+		elapsedSeconds(&middle, &finish) * 1e9 / count, checksum);
+	for (i = 0; i < count; i++)
+		LSQ_DestroySequence(handles[i]);
+	free(handles);
+	return 1;
+}
+
+int main(int argc, char ** argv)
+{
+	int done = 0;
+	if (argc > 1 && strcmp(argv[1], "heap") == 0)
+		done = runHeap(argc - 2, argv + 2);
+	else if (argc > 1 && strcmp(argv[1], "queue") == 0)
+		done = runQueue(argc - 2, argv + 2);
+	else if (argc > 1 && strcmp(argv[1], "small") == 0)
+		done = runSmall(argc - 2, argv + 2);
+	if (!done)
+	{
+		fprintf(stderr, "usage: %s heap [elements] [arity] [random | timer] [operations]\n"
+			"       %s queue [spsc | mpmc | sequence] [batch] [items]\n"
+			"       %s small [elements per array] [arrays]\n", argv[0], argv[0], argv[0]);
+		return 1;
+	}
+	return 0;
+}
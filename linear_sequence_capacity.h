@@ -0,0 +1,33 @@
+#ifndef LINEAR_SEQUENCE_CAPACITY_H
+#define LINEAR_SEQUENCE_CAPACITY_H
+
+/* Capacity management for the array backends (linear_sequence_arrays.c, linear_sequence_dyn_arrays.c).   *
+ * hash_map.c and compact_avl_tree.c provide the capacity functions but not the growth policy. The header    *
+ * expects linear_sequence.h or linear_sequence_assoc.h to be included first.                                */
+
+/* Growth policy of the element buffer */
+typedef struct
+{
+	/* Multiplier applied to the capacity when the buffer is full. Must be greater than 1 */
+	double growth_factor;
+	/* The buffer shrinks once size <= capacity * shrink_threshold. The new capacity is size * growth_factor, *
+	 * so the threshold is clamped below 1 / growth_factor to keep a gap between the grow and shrink points. *
+	 * Zero disables automatic shrinking.                                                                    */
+	double shrink_threshold;
+	/* The buffer never shrinks below this number of elements automatically */
+	LSQ_IntegerIndexT min_capacity;
+} LSQ_GrowthPolicyT;
+
+/* Function that replaces the growth policy of the container. Invalid fields are replaced by defaults */
+extern void LSQ_SetGrowthPolicy(LSQ_HandleT handle, const LSQ_GrowthPolicyT * policy);
+/* Function that copies the current growth policy of the container into policy */
+extern void LSQ_GetGrowthPolicy(LSQ_HandleT handle, LSQ_GrowthPolicyT * policy);
+
+/* Function that returns the number of elements the container can hold without reallocation */
+extern LSQ_IntegerIndexT LSQ_GetCapacity(LSQ_HandleT handle);
+/* Function that grows the buffer so it holds at least capacity elements. Never shrinks the buffer */
+extern void LSQ_ReserveCapacity(LSQ_HandleT handle, LSQ_IntegerIndexT capacity);
+/* Function that reallocates the buffer to exactly the current number of elements */
+extern void LSQ_ShrinkToFit(LSQ_HandleT handle);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef LINEAR_SEQUENCE_CLONE_H
+#define LINEAR_SEQUENCE_CLONE_H
+
+/* Copy-on-write cloning, provided by linear_sequence_dyn_arrays.c, avl_tree.c and persistent_avl_tree.c. The        *
+ * header expects linear_sequence.h or linear_sequence_assoc.h to be included first. A clone shares storage with     *
+ * its original and costs O(1) until one of them is modified: the array copies its buffer and avl_tree.c its whole   *
+ * tree on the first modification, persistent_avl_tree.c copies only the O(log n) nodes on the modified path. The    *
+ * nodes of avl_tree.c point to their parents, which a node shared by two trees cannot do, so its first write after  *
+ * a clone costs O(n); handles that are cloned and then modified often belong in persistent_avl_tree.c. Iterators    *
+ * of avl_tree.c survive the copy and find their keys again in the new nodes. LSQ_DereferenceIterator hands out a    *
+ * writable pointer and therefore counts as a modification, so read-only code should use LSQ_PeekIterator, or        *
+ * LSQ_PeekSpan of linear_sequence_span.h, instead. persistent_avl_tree.c copies the path of the iterator on         *
+ * dereference, and returns NULL for an iterator created before the last update of its handle.                       */
+
+/* Function that returns a copy of the container that shares its storage until either of them is modified. *
+ * The copy uses the allocator of the original                                                              */
+extern LSQ_HandleT LSQ_CloneSequence(LSQ_HandleT handle);
+/* Function that returns a read-only pointer to the element of the iterator without unsharing the storage, *
+ * or NULL if the iterator is not dereferencable                                                            */
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator);
+
+#endif
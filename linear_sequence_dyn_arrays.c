@@ -2,10 +2,22 @@
 #include <string.h>
 #include <stdlib.h>
 #include "linear_sequence.h"
+#include "linear_sequence_capacity.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_lazy_delete.h"
+#include "linear_sequence_span.h"
+#include "linear_sequence_clone.h"
+#include "linear_sequence_heap.h"
+#include "linear_sequence_queue.h"
 
-#define PHYS_SIZE_CHANGE_FACTOR 2;
-#define LSQ_ARRAY_BASE_PHYS_SIZE 1;
-#define SIZE_RATIO_LOWER_THRESHOLD 0.25;
+#define PHYS_SIZE_CHANGE_FACTOR 2.0
+#define LSQ_ARRAY_BASE_PHYS_SIZE 1
+#define SIZE_RATIO_LOWER_THRESHOLD 0.25
+#define HEAP_DEFAULT_ARITY 2
+#define QUEUE_CACHE_LINE 64
+#define QUEUE_MAX_SLOTS (1 << 30)
+/* Buffers of up to this many elements are stored in the handle itself */
+#define INLINE_CAPACITY 16
 #define IS_HANDLE_INVALID(handle)(handle == LSQ_HandleInvalid)
 
 typedef enum 
@@ -15,11 +27,53 @@ typedef enum
 	PASTREAR,
 } IteratorStateT;
 
+/* Ring positions grow without wrapping, the slot of a position is position & mask */
+typedef struct
+{
+	char front_padding[QUEUE_CACHE_LINE];
+	/* Producer side. cached_head is the producer's last view of head (single-producer mode only) */
+	unsigned long long tail;
+	unsigned long long cached_head;
+	char middle_padding[QUEUE_CACHE_LINE - 2 * sizeof(unsigned long long)];
+	/* Consumer side. cached_tail is the consumer's last view of tail (single-producer mode only) */
+	unsigned long long head;
+	unsigned long long cached_tail;
+	char rear_padding[QUEUE_CACHE_LINE - 2 * sizeof(unsigned long long)];
+	unsigned long long mask;
+	/* Multi-producer mode: a slot is free for the producer of position p when its sequence is p, and ready for *
+	 * the consumer of p when it is p + 1                                                                       */
+	unsigned long long * sequences;
+	LSQ_QueueModeT mode;
+} QueueStateT;
+
 typedef struct 
 {
 	LSQ_BaseTypeT * data_ptr;
 	int physical_size;
 	int logical_size;
+	LSQ_GrowthPolicyT policy;
+	const LSQ_AllocatorT * allocator;
+	/* Lazy deletion: dead slots stay in the buffer, marked in dead_bits, until compaction. The bitmap and *
+	 * the Fenwick tree of dead slots per bitmap word exist only while dead_count is not zero              */
+	double dead_ratio;
+	int dead_count;
+	int dead_words;
+	unsigned long long * dead_bits;
+	int * dead_tree;
+	/* Number of clones sharing data_ptr, NULL while the buffer is not shared */
+	int * share_count;
+	/* Heap functions: slot_entries maps a slot to the entry handle of its element or -1, entry_slots maps an entry *
+	 * to its slot or chains free entries. Both arrays hold entry_capacity items in one block and exist only after  *
+	 * LSQ_HeapPushEntry                                                                                            */
+	int heap_arity;
+	int entry_capacity;
+	int free_entry;
+	int * slot_entries;
+	int * entry_slots;
+	/* Ring state of the queue mode, NULL for a sequence */
+	QueueStateT * queue;
+	/* Buffer of small sequences: data_ptr points here while physical_size <= INLINE_CAPACITY, which is never shared */
+	LSQ_BaseTypeT inline_data[INLINE_CAPACITY];
 } ArrayDataT;
 
 typedef struct 
@@ -27,27 +81,565 @@ typedef struct
 	ArrayDataT * array_data;
 	IteratorStateT state;
 	LSQ_IntegerIndexT index;
+	const LSQ_AllocatorT * allocator;
 } IteratorT;
 
 static int isContainerFull(ArrayDataT * handle);
 
 static LSQ_IteratorT createIterator(LSQ_HandleT handle);
 
-static void setContainerSize(ArrayDataT * handle, int size);
+static int setContainerSize(ArrayDataT * handle, int size);
+
+static int growContainer(ArrayDataT * handle, int required_size);
+
+static void shrinkContainer(ArrayDataT * handle);
+
+static void setDefaultPolicy(LSQ_GrowthPolicyT * policy);
+
+static int slotCount(ArrayDataT * handle);
+
+static int slotOfIndex(ArrayDataT * handle, int index);
+
+static int liveRunLength(ArrayDataT * handle, int slot);
+
+static int markSlotDead(ArrayDataT * handle, int slot);
+
+static void releaseDeadSlots(ArrayDataT * handle);
+
+static int compactSlots(ArrayDataT * handle);
+
+static void releaseBuffer(ArrayDataT * handle);
+
+static int unshareBuffer(ArrayDataT * handle);
+
+static void releaseHeapEntries(ArrayDataT * handle);
+
+static int reserveHeapEntries(ArrayDataT * handle, int size);
+
+static __inline int entryOfSlot(ArrayDataT * handle, int slot);
+
+static __inline void placeHeapElement(ArrayDataT * handle, int slot, LSQ_BaseTypeT element, int entry);
+
+static void siftUp(ArrayDataT * handle, int slot, LSQ_BaseTypeT element, int entry);
+
+static void siftDown(ArrayDataT * handle, int slot, LSQ_BaseTypeT element, int entry);
+
+static void restoreHeapOrder(ArrayDataT * handle);
+
+static int prepareHeapPush(ArrayDataT * handle);
+
+static int heapEntrySlot(ArrayDataT * handle, LSQ_HeapEntryT entry);
+
+static void removeHeapSlot(ArrayDataT * handle, int slot);
+
+static void reverseSlots(LSQ_BaseTypeT * data, int first, int last);
+
+static void releaseQueue(ArrayDataT * handle);
+
+static int enqueueSingle(ArrayDataT * handle, const LSQ_BaseTypeT * elements, int count);
+
+static int dequeueSingle(ArrayDataT * handle, LSQ_BaseTypeT * elements, int count);
+
+static int enqueueShared(ArrayDataT * handle, const LSQ_BaseTypeT * elements, int count);
+
+static int dequeueShared(ArrayDataT * handle, LSQ_BaseTypeT * elements, int count);
 
 
 static int isContainerFull(ArrayDataT * handle)
 {
-	return (IS_HANDLE_INVALID(handle)) ? -1 : handle->logical_size == handle->physical_size;	
+	return (IS_HANDLE_INVALID(handle)) ? -1 : slotCount(handle) == handle->physical_size;	
 }
 
-static void setContainerSize(ArrayDataT * handle, int size)
+static int slotCount(ArrayDataT * handle)
 {
-	if (IS_HANDLE_INVALID(handle)) 
+	return handle->logical_size + handle->dead_count;
+}
+
+/* Select over the live slots: descends the Fenwick tree to the word holding the live slot number index, *
+ * then scans the live bits of that word                                                                 */
+static int slotOfIndex(ArrayDataT * handle, int index)
+{
+	int word = 0, step = 1, live;
+	unsigned long long live_bits;
+	if (handle->dead_count == 0)
+		return index;
+	while (step * 2 <= handle->dead_words)
+		step *= 2;
+	for (; step > 0; step /= 2)
+	{
+		if (word + step > handle->dead_words)
+			continue;
+		live = step * 64 - handle->dead_tree[word + step - 1];
+		if (live <= index)
+		{
+			word += step;
+			index -= live;
+		}
+	}
+	for (live_bits = ~handle->dead_bits[word]; index > 0; index--)
+		live_bits &= live_bits - 1;
+	return word * 64 + __builtin_ctzll(live_bits);
+}
+
+/* Number of live slots from the live slot on to the next dead one or the end */
+static int liveRunLength(ArrayDataT * handle, int slot)
+{
+	unsigned long long dead_bits;
+	int end, word;
+	if (handle->dead_count == 0)
+		return handle->logical_size - slot;
+	end = slotCount(handle);
+	word = slot / 64;
+	for (dead_bits = handle->dead_bits[word] & (~0ULL << (slot % 64)); dead_bits == 0 && ++word * 64 < end;
+		dead_bits = handle->dead_bits[word])
+		;
+	if (dead_bits != 0 && word * 64 + __builtin_ctzll(dead_bits) < end)
+		end = word * 64 + __builtin_ctzll(dead_bits);
+	return end - slot;
+}
+
+static int markSlotDead(ArrayDataT * handle, int slot)
+{
+	int i;
+	if (handle->dead_bits == NULL)
+	{
+		handle->dead_words = (handle->physical_size + 63) / 64;
+		handle->dead_bits = (unsigned long long *)lsqAllocate(handle->allocator,
+			handle->dead_words * (sizeof(unsigned long long) + sizeof(int)));
+		if (handle->dead_bits == NULL)
+			return 0;
+		handle->dead_tree = (int *)(handle->dead_bits + handle->dead_words);
+		memset(handle->dead_bits, 0, handle->dead_words * (sizeof(unsigned long long) + sizeof(int)));
+	}
+	handle->dead_bits[slot / 64] |= 1ULL << (slot % 64);
+	for (i = slot / 64 + 1; i <= handle->dead_words; i += i & -i)
+		handle->dead_tree[i - 1]++;
+	handle->dead_count++;
+	return 1;
+}
+
+static void releaseDeadSlots(ArrayDataT * handle)
+{
+	if (handle->dead_bits != NULL)
+		lsqDeallocate(handle->allocator, handle->dead_bits,
+			handle->dead_words * (sizeof(unsigned long long) + sizeof(int)));
+	handle->dead_bits = NULL;
+	handle->dead_tree = NULL;
+	handle->dead_words = 0;
+	handle->dead_count = 0;
+}
+
+static int compactSlots(ArrayDataT * handle)
+{
+	int slot, target = 0, slot_count = slotCount(handle);
+	if (handle->dead_count == 0)
+		return 1;
+	if (!unshareBuffer(handle))
+		return 0;
+	for (slot = 0; slot < slot_count; slot++)
+	{
+		if ((slot % 64) == 0 && handle->dead_bits[slot / 64] == 0 && slot + 64 <= slot_count)
+		{
+			memmove(handle->data_ptr + target, handle->data_ptr + slot, 64 * sizeof(LSQ_BaseTypeT));
+			target += 64;
+			slot += 63;
+			continue;
+		}
+		if (!((handle->dead_bits[slot / 64] >> (slot % 64)) & 1))
+			handle->data_ptr[target++] = handle->data_ptr[slot];
+	}
+	releaseDeadSlots(handle);
+	return 1;
+}
+
+/* Drops the handle's reference to its buffer, which is freed unless other clones still share it */
+static void releaseBuffer(ArrayDataT * handle)
+{
+	if (handle->share_count == NULL || __atomic_sub_fetch(handle->share_count, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		if (handle->share_count != NULL)
+			lsqDeallocate(handle->allocator, handle->share_count, sizeof(int));
+		if (handle->data_ptr != handle->inline_data)
+			lsqDeallocate(handle->allocator, handle->data_ptr, handle->physical_size * sizeof(LSQ_BaseTypeT));
+	}
+	handle->share_count = NULL;
+	handle->data_ptr = NULL;
+}
+
+/* Gives the handle a buffer of its own before it is written. The copy is made before the reference to the *
+ * shared buffer is dropped, so a clone released concurrently cannot free it mid-copy                       */
+static int unshareBuffer(ArrayDataT * handle)
+{
+	LSQ_BaseTypeT * data_ptr = NULL;
+	if (handle->share_count == NULL)
+		return 1;
+	if (__atomic_load_n(handle->share_count, __ATOMIC_ACQUIRE) == 1)
+	{
+		lsqDeallocate(handle->allocator, handle->share_count, sizeof(int));
+		handle->share_count = NULL;
+		return 1;
+	}
+	data_ptr = (LSQ_BaseTypeT *)lsqAllocate(handle->allocator, handle->physical_size * sizeof(LSQ_BaseTypeT));
+	if (data_ptr == NULL)
+		return 0;
+	memcpy(data_ptr, handle->data_ptr, slotCount(handle) * sizeof(LSQ_BaseTypeT));
+	releaseBuffer(handle);
+	handle->data_ptr = data_ptr;
+	return 1;
+}
+
+static void releaseHeapEntries(ArrayDataT * handle)
+{
+	if (handle->slot_entries != NULL)
+		lsqDeallocate(handle->allocator, handle->slot_entries, 2 * handle->entry_capacity * sizeof(int));
+	handle->slot_entries = NULL;
+	handle->entry_slots = NULL;
+	handle->entry_capacity = 0;
+	handle->free_entry = -1;
+}
+
+/* Grows the entry arrays to cover size slots. New entries are chained into the free list */
+static int reserveHeapEntries(ArrayDataT * handle, int size)
+{
+	int * block = NULL, capacity = handle->entry_capacity, i;
+	if (size <= capacity)
+		return 1;
+	while (capacity < size)
+		capacity = (capacity < 16) ? 16 : capacity * 2;
+	block = (int *)lsqAllocate(handle->allocator, 2 * capacity * sizeof(int));
+	if (block == NULL)
+		return 0;
+	for (i = 0; i < handle->logical_size; i++)
+		block[i] = entryOfSlot(handle, i);
+	if (handle->entry_slots != NULL)
+		memcpy(block + capacity, handle->entry_slots, handle->entry_capacity * sizeof(int));
+	for (i = capacity - 1; i >= handle->entry_capacity; i--)
+	{
+		block[capacity + i] = handle->free_entry;
+		handle->free_entry = i;
+	}
+	if (handle->slot_entries != NULL)
+		lsqDeallocate(handle->allocator, handle->slot_entries, 2 * handle->entry_capacity * sizeof(int));
+	handle->slot_entries = block;
+	handle->entry_slots = block + capacity;
+	handle->entry_capacity = capacity;
+	return 1;
+}
+
+static __inline int entryOfSlot(ArrayDataT * handle, int slot)
+{
+	return (handle->slot_entries != NULL) ? handle->slot_entries[slot] : -1;
+}
+
+static __inline void placeHeapElement(ArrayDataT * handle, int slot, LSQ_BaseTypeT element, int entry)
+{
+	handle->data_ptr[slot] = element;
+	if (handle->slot_entries == NULL)
 		return;
+	handle->slot_entries[slot] = entry;
+	if (entry >= 0)
+		handle->entry_slots[entry] = slot;
+}
+
+/* Moves the hole at slot up until element fits into it */
+static void siftUp(ArrayDataT * handle, int slot, LSQ_BaseTypeT element, int entry)
+{
+	int parent;
+	while (slot > 0)
+	{
+		parent = (slot - 1) / handle->heap_arity;
+		if (!(element < handle->data_ptr[parent]))
+			break;
+		placeHeapElement(handle, slot, handle->data_ptr[parent], entryOfSlot(handle, parent));
+		slot = parent;
+	}
+	placeHeapElement(handle, slot, element, entry);
+}
+
+/* Moves the hole at slot down until element fits into it */
+static void siftDown(ArrayDataT * handle, int slot, LSQ_BaseTypeT element, int entry)
+{
+	LSQ_BaseTypeT * data = handle->data_ptr;
+	int child, last, best;
+	while ((child = slot * handle->heap_arity + 1) < handle->logical_size)
+	{
+		last = child + handle->heap_arity;
+		if (last > handle->logical_size)
+			last = handle->logical_size;
+		for (best = child++; child < last; child++)
+		{
+			if (data[child] < data[best])
+				best = child;
+		}
+		if (!(data[best] < element))
+			break;
+		placeHeapElement(handle, slot, data[best], entryOfSlot(handle, best));
+		slot = best;
+	}
+	placeHeapElement(handle, slot, element, entry);
+}
+
+/* Floyd's bottom-up construction, O(n) */
+static void restoreHeapOrder(ArrayDataT * handle)
+{
+	int slot;
+	for (slot = (handle->logical_size - 2) / handle->heap_arity; slot >= 0 && handle->logical_size > 1; slot--)
+		siftDown(handle, slot, handle->data_ptr[slot], entryOfSlot(handle, slot));
+}
+
+/* Makes room for one more element at the rear. The heap functions need a private buffer without dead slots */
+static int prepareHeapPush(ArrayDataT * handle)
+{
+	if (!compactSlots(handle) || !unshareBuffer(handle))
+		return 0;
+	if (isContainerFull(handle) && !growContainer(handle, handle->logical_size + 1))
+		return 0;
+	return handle->slot_entries == NULL || reserveHeapEntries(handle, handle->logical_size + 1);
+}
+
+/* Returns the slot of a live entry, or -1 */
+static int heapEntrySlot(ArrayDataT * handle, LSQ_HeapEntryT entry)
+{
+	int slot;
+	if (handle->slot_entries == NULL || entry < 0 || entry >= handle->entry_capacity)
+		return -1;
+	slot = handle->entry_slots[entry];
+	return (slot >= 0 && slot < handle->logical_size && handle->slot_entries[slot] == entry) ? slot : -1;
+}
+
+/* Removes the element at slot, fills the hole with the rear element and frees the entry of the removed one */
+static void removeHeapSlot(ArrayDataT * handle, int slot)
+{
+	int entry = entryOfSlot(handle, slot), rear;
+	if (entry >= 0)
+	{
+		handle->entry_slots[entry] = handle->free_entry;
+		handle->free_entry = entry;
+	}
+	rear = --handle->logical_size;
+	if (slot < rear)
+	{
+		if (slot > 0 && handle->data_ptr[rear] < handle->data_ptr[(slot - 1) / handle->heap_arity])
+			siftUp(handle, slot, handle->data_ptr[rear], entryOfSlot(handle, rear));
+		else
+			siftDown(handle, slot, handle->data_ptr[rear], entryOfSlot(handle, rear));
+	}
+	shrinkContainer(handle);
+}
+
+static void reverseSlots(LSQ_BaseTypeT * data, int first, int last)
+{
+	LSQ_BaseTypeT element;
+	for (last--; first < last; first++, last--)
+	{
+		element = data[first];
+		data[first] = data[last];
+		data[last] = element;
+	}
+}
+
+static void releaseQueue(ArrayDataT * handle)
+{
+	if (handle->queue == NULL)
+		return;
+	if (handle->queue->sequences != NULL)
+		lsqDeallocate(handle->allocator, handle->queue->sequences,
+			(handle->queue->mask + 1) * sizeof(unsigned long long));
+	lsqDeallocate(handle->allocator, handle->queue, sizeof(QueueStateT));
+	handle->queue = NULL;
+}
+
+/* Wait-free: only the producer writes tail, only the consumer writes head */
+static int enqueueSingle(ArrayDataT * handle, const LSQ_BaseTypeT * elements, int count)
+{
+	QueueStateT * queue = handle->queue;
+	unsigned long long tail = queue->tail, capacity = queue->mask + 1, slot;
+	int first_part;
+	if (tail - queue->cached_head + count > capacity)
+		queue->cached_head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+	if (tail - queue->cached_head + count > capacity)
+		count = (int)(capacity - (tail - queue->cached_head));
+	if (count <= 0)
+		return 0;
+	slot = tail & queue->mask;
+	first_part = (slot + count > capacity) ? (int)(capacity - slot) : count;
+	if (count == 1)
+		handle->data_ptr[slot] = elements[0];
+	else
+	{
+		memcpy(handle->data_ptr + slot, elements, first_part * sizeof(LSQ_BaseTypeT));
+		memcpy(handle->data_ptr, elements + first_part, (count - first_part) * sizeof(LSQ_BaseTypeT));
+	}
+	__atomic_store_n(&queue->tail, tail + count, __ATOMIC_RELEASE);
+	return count;
+}
+
+static int dequeueSingle(ArrayDataT * handle, LSQ_BaseTypeT * elements, int count)
+{
+	QueueStateT * queue = handle->queue;
+	unsigned long long head = queue->head, capacity = queue->mask + 1, slot;
+	int first_part;
+	if (queue->cached_tail - head < (unsigned long long)count)
+		queue->cached_tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+	if (queue->cached_tail - head < (unsigned long long)count)
+		count = (int)(queue->cached_tail - head);
+	if (count <= 0)
+		return 0;
+	slot = head & queue->mask;
+	first_part = (slot + count > capacity) ? (int)(capacity - slot) : count;
+	if (count == 1)
+		elements[0] = handle->data_ptr[slot];
+	else
+	{
+		memcpy(elements, handle->data_ptr + slot, first_part * sizeof(LSQ_BaseTypeT));
+		memcpy(elements + first_part, handle->data_ptr, (count - first_part) * sizeof(LSQ_BaseTypeT));
+	}
+	__atomic_store_n(&queue->head, head + count, __ATOMIC_RELEASE);
+	return count;
+}
+
+/* Lock-free bounded queue after D. Vyukov: a producer claims the run of free slots at tail by one CAS, then *
+ * fills the slots and publishes each through its sequence number                                           */
+static int enqueueShared(ArrayDataT * handle, const LSQ_BaseTypeT * elements, int count)
+{
+	QueueStateT * queue = handle->queue;
+	unsigned long long position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED), sequence;
+	int ready, i;
+	for (;;)
+	{
+		for (ready = 0; ready < count; ready++)
+		{
+			sequence = __atomic_load_n(&queue->sequences[(position + ready) & queue->mask], __ATOMIC_ACQUIRE);
+			if (sequence != position + ready)
+				break;
+		}
+		if (ready == 0)
+		{
+			/* A slot still holding the previous round means the queue is full, a newer one that tail moved */
+			if ((long long)(sequence - position) < 0)
+				return 0;
+			position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (__atomic_compare_exchange_n(&queue->tail, &position, position + ready, 1,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+	for (i = 0; i < ready; i++)
+	{
+		handle->data_ptr[(position + i) & queue->mask] = elements[i];
+		__atomic_store_n(&queue->sequences[(position + i) & queue->mask], position + i + 1, __ATOMIC_RELEASE);
+	}
+	return ready;
+}
+
+static int dequeueShared(ArrayDataT * handle, LSQ_BaseTypeT * elements, int count)
+{
+	QueueStateT * queue = handle->queue;
+	unsigned long long position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED), sequence;
+	int ready, i;
+	for (;;)
+	{
+		for (ready = 0; ready < count; ready++)
+		{
+			sequence = __atomic_load_n(&queue->sequences[(position + ready) & queue->mask], __ATOMIC_ACQUIRE);
+			if (sequence != position + ready + 1)
+				break;
+		}
+		if (ready == 0)
+		{
+			if ((long long)(sequence - (position + 1)) < 0)
+				return 0;
+			position = __atomic_load_n(&queue->head, __ATOMIC_RELAXED);
+			continue;
+		}
+		if (__atomic_compare_exchange_n(&queue->head, &position, position + ready, 1,
+			__ATOMIC_RELAXED, __ATOMIC_RELAXED))
+			break;
+	}
+	for (i = 0; i < ready; i++)
+	{
+		elements[i] = handle->data_ptr[(position + i) & queue->mask];
+		__atomic_store_n(&queue->sequences[(position + i) & queue->mask], position + i + queue->mask + 1,
+			__ATOMIC_RELEASE);
+	}
+	return ready;
+}
+
+static int setContainerSize(ArrayDataT * handle, int size)
+{
+	LSQ_BaseTypeT * data_ptr = NULL;
+	if (IS_HANDLE_INVALID(handle)) 
+		return 0;
+	if (size == 0 && handle->logical_size == 0)
+	{
+		releaseDeadSlots(handle);
+		releaseBuffer(handle);
+		handle->physical_size = 0;
+		return 1;
+	}
+	if (!compactSlots(handle) || !unshareBuffer(handle))
+		return 0;
+	if (size > INLINE_CAPACITY && handle->data_ptr != handle->inline_data)
+	{
+		data_ptr = (LSQ_BaseTypeT *)lsqReallocate(handle->allocator, handle->data_ptr, 
+			handle->physical_size * sizeof(LSQ_BaseTypeT), size * sizeof(LSQ_BaseTypeT));
+		if (data_ptr == NULL)
+			return 0;
+	}
+	else
+	{
+		/* Moving between the inline buffer and an allocated one, or staying inline */
+		data_ptr = (size > INLINE_CAPACITY) ?
+			(LSQ_BaseTypeT *)lsqAllocate(handle->allocator, size * sizeof(LSQ_BaseTypeT)) : handle->inline_data;
+		if (data_ptr == NULL)
+			return 0;
+		if (data_ptr != handle->data_ptr && handle->data_ptr != NULL)
+		{
+			memcpy(data_ptr, handle->data_ptr, slotCount(handle) * sizeof(LSQ_BaseTypeT));
+			if (handle->data_ptr != handle->inline_data)
+				lsqDeallocate(handle->allocator, handle->data_ptr, handle->physical_size * sizeof(LSQ_BaseTypeT));
+		}
+	}
+	handle->data_ptr = data_ptr;
 	handle->physical_size = size;
-	handle->data_ptr = (LSQ_BaseTypeT *)realloc(handle->data_ptr, 
-		size * sizeof(LSQ_BaseTypeT));
+	return 1;
+}
+
+static int growContainer(ArrayDataT * handle, int required_size)
+{
+	int new_size = handle->physical_size, next_size;
+	if (required_size <= handle->physical_size)
+		return 1;
+	if (new_size < handle->policy.min_capacity)
+		new_size = handle->policy.min_capacity;
+	while (new_size < required_size)
+	{
+		next_size = (int)(new_size * handle->policy.growth_factor);
+		new_size = (next_size > new_size) ? next_size : new_size + 1;
+	}
+	return setContainerSize(handle, new_size);
+}
+
+static void shrinkContainer(ArrayDataT * handle)
+{
+	int is_container_empty_enough, new_size;
+	is_container_empty_enough = handle->policy.shrink_threshold > 0.0 &&
+		handle->logical_size <= handle->physical_size * handle->policy.shrink_threshold;
+	if (!is_container_empty_enough || handle->physical_size <= handle->policy.min_capacity)
+		return;
+	new_size = (int)(handle->logical_size * handle->policy.growth_factor);
+	if (new_size < handle->policy.min_capacity)
+		new_size = handle->policy.min_capacity;
+	if (new_size < handle->physical_size)
+		setContainerSize(handle, new_size);
+}
+
+static void setDefaultPolicy(LSQ_GrowthPolicyT * policy)
+{
+	policy->growth_factor = PHYS_SIZE_CHANGE_FACTOR;
+	policy->shrink_threshold = SIZE_RATIO_LOWER_THRESHOLD;
+	policy->min_capacity = LSQ_ARRAY_BASE_PHYS_SIZE;
 }
 
 static LSQ_IteratorT createIterator(LSQ_HandleT handle)
@@ -55,37 +647,68 @@ static LSQ_IteratorT createIterator(LSQ_HandleT handle)
 	IteratorT * iterator = NULL;
 	if(IS_HANDLE_INVALID(handle)) 
 		return LSQ_HandleInvalid;
-	iterator = (IteratorT *)malloc(sizeof(IteratorT));
+	iterator = (IteratorT *)lsqAllocate(((ArrayDataT *)handle)->allocator, sizeof(IteratorT));
 	if (iterator == NULL) 
 		return LSQ_HandleInvalid;
+	iterator->allocator = ((ArrayDataT *)handle)->allocator;
 	iterator->array_data = (ArrayDataT *)handle;
 	return iterator;
 }
 
 extern LSQ_HandleT LSQ_CreateSequence(void) 
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
 {
 	ArrayDataT * array_data = NULL;
-	array_data = (ArrayDataT *)malloc(sizeof(ArrayDataT));
+	array_data = (ArrayDataT *)lsqAllocate(allocator, sizeof(ArrayDataT));
 	if (array_data == NULL)
 		return LSQ_HandleInvalid;
+	array_data->allocator = allocator;
 	array_data->physical_size = LSQ_ARRAY_BASE_PHYS_SIZE;
-	array_data->data_ptr = (LSQ_BaseTypeT *)malloc(sizeof(LSQ_BaseTypeT) * array_data->physical_size);
+	array_data->data_ptr = array_data->inline_data;
 	array_data->logical_size = 0;
+	setDefaultPolicy(&array_data->policy);
+	array_data->dead_ratio = 0.0;
+	array_data->dead_count = 0;
+	array_data->dead_words = 0;
+	array_data->dead_bits = NULL;
+	array_data->dead_tree = NULL;
+	array_data->share_count = NULL;
+	array_data->heap_arity = HEAP_DEFAULT_ARITY;
+	array_data->entry_capacity = 0;
+	array_data->free_entry = -1;
+	array_data->slot_entries = NULL;
+	array_data->entry_slots = NULL;
+	array_data->queue = NULL;
 	return array_data;
 }
 
 extern void LSQ_DestroySequence(LSQ_HandleT handle) 
 {
 	ArrayDataT * array_data = (ArrayDataT *)handle;
-	if (IS_HANDLE_INVALID(handle) || IS_HANDLE_INVALID(array_data->data_ptr))
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(array_data->allocator))
 		return;
-	free(array_data->data_ptr);
-	free(handle);
+	releaseDeadSlots(array_data);
+	releaseHeapEntries(array_data);
+	releaseQueue(array_data);
+	releaseBuffer(array_data);
+	lsqDeallocate(array_data->allocator, handle, sizeof(ArrayDataT));
 }
 
 extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
 {  
-	return (IS_HANDLE_INVALID(handle)) ? -1 : ((ArrayDataT *)handle)->logical_size;
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	long long size;
+	if (IS_HANDLE_INVALID(handle))
+		return -1;
+	if (array_data->queue == NULL)
+		return array_data->logical_size;
+	size = (long long)(__atomic_load_n(&array_data->queue->tail, __ATOMIC_RELAXED) -
+		__atomic_load_n(&array_data->queue->head, __ATOMIC_RELAXED));
+	return (size < 0) ? 0 : (LSQ_IntegerIndexT)size;
 }
 
 extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
@@ -106,10 +729,10 @@ extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
 extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
 {
 	IteratorT * iter = NULL;
-	if (!LSQ_IsIteratorDereferencable(iterator)) 
+	if (!LSQ_IsIteratorDereferencable(iterator) || !unshareBuffer(((IteratorT *)iterator)->array_data)) 
 		return LSQ_HandleInvalid;
 	iter = (IteratorT *)iterator;
-	return (iter)->array_data->data_ptr + iter->index;
+	return (iter)->array_data->data_ptr + slotOfIndex(iter->array_data, iter->index);
 }
 
 extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
@@ -145,7 +768,9 @@ extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
 
 extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
 {
-	free(iterator);
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
 }
 
 extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
@@ -204,23 +829,27 @@ extern void LSQ_InsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT n
 	IteratorT * iter = (IteratorT *)iterator;
     ArrayDataT * array_data = NULL;
 	int * element_ptr = NULL;
+	int slot;
 
     if (IS_HANDLE_INVALID(iterator))
     {
         return;
     }
 	array_data = iter->array_data;
-	if (isContainerFull(array_data))
-	{
-		int new_size = LSQ_ARRAY_BASE_PHYS_SIZE;
-		new_size = array_data->physical_size * PHYS_SIZE_CHANGE_FACTOR;
-		setContainerSize(array_data, new_size);
-	}
+	releaseHeapEntries(array_data);
+	/* Dead slots are only kept in front of rear insertions */
+	if (iter->index < array_data->logical_size && !compactSlots(array_data))
+		return;
+	if (isContainerFull(array_data) && !growContainer(array_data, slotCount(array_data) + 1))
+		return;
+	if (!unshareBuffer(array_data))
+		return;
+	slot = (array_data->dead_count > 0) ? slotCount(array_data) : iter->index;
+	memmove(array_data->data_ptr + slot + 1, 
+			array_data->data_ptr + slot , 
+			sizeof(LSQ_BaseTypeT) * (slotCount(array_data) - slot));
 	array_data->logical_size++;
-	memmove(array_data->data_ptr + iter->index + 1, 
-			array_data->data_ptr + iter->index , 
-			sizeof(LSQ_BaseTypeT) * (array_data->logical_size - iter->index - 1));
-	element_ptr = array_data->data_ptr + iter->index; 
+	element_ptr = array_data->data_ptr + slot; 
 	*(element_ptr) = newElement;
 }
 
@@ -243,23 +872,343 @@ extern void LSQ_DeleteGivenElement(LSQ_IteratorT iterator)
 {
 	IteratorT * iter = (IteratorT *)iterator;
     ArrayDataT * array_data = NULL;
-	int is_container_empty_enough, new_size = LSQ_ARRAY_BASE_PHYS_SIZE;
 
     if (!LSQ_IsIteratorDereferencable(iterator))
     {
         return;
     }
 	array_data = iter->array_data;
+	releaseHeapEntries(array_data);
+	if (array_data->dead_ratio > 0.0 && markSlotDead(array_data, slotOfIndex(array_data, iter->index)))
+	{
+		array_data->logical_size--;
+		if (array_data->dead_count > array_data->dead_ratio * slotCount(array_data))
+			LSQ_CompactSequence(array_data);
+		return;
+	}
+	if (!unshareBuffer(array_data))
+		return;
 	array_data->logical_size--;
 	memmove(array_data->data_ptr + iter->index, 
 			array_data->data_ptr + iter->index + 1, 
 			sizeof(LSQ_BaseTypeT) * (array_data->logical_size - iter->index));
-	is_container_empty_enough = array_data->logical_size <= array_data->physical_size * SIZE_RATIO_LOWER_THRESHOLD;
-	if (is_container_empty_enough)
+	shrinkContainer(array_data);
+}
+
+extern void LSQ_SetGrowthPolicy(LSQ_HandleT handle, const LSQ_GrowthPolicyT * policy)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || policy == NULL)
+		return;
+	setDefaultPolicy(&array_data->policy);
+	if (policy->growth_factor > 1.0)
+		array_data->policy.growth_factor = policy->growth_factor;
+	if (policy->min_capacity >= 0)
+		array_data->policy.min_capacity = policy->min_capacity;
+	array_data->policy.shrink_threshold = 0.0;
+	if (policy->shrink_threshold > 0.0)
+		array_data->policy.shrink_threshold = (policy->shrink_threshold * array_data->policy.growth_factor < 1.0) ?
+			policy->shrink_threshold : 0.5 / array_data->policy.growth_factor;
+}
+
+extern void LSQ_GetGrowthPolicy(LSQ_HandleT handle, LSQ_GrowthPolicyT * policy)
+{
+	if (IS_HANDLE_INVALID(handle) || policy == NULL)
+		return;
+	*policy = ((ArrayDataT *)handle)->policy;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetCapacity(LSQ_HandleT handle)
+{
+	return (IS_HANDLE_INVALID(handle)) ? -1 : ((ArrayDataT *)handle)->physical_size;
+}
+
+extern void LSQ_ReserveCapacity(LSQ_HandleT handle, LSQ_IntegerIndexT capacity)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || capacity <= array_data->physical_size)
+		return;
+	setContainerSize(array_data, capacity);
+}
+
+extern void LSQ_ShrinkToFit(LSQ_HandleT handle)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || array_data->physical_size == array_data->logical_size)
+		return;
+	setContainerSize(array_data, array_data->logical_size);
+}
+
+extern void LSQ_SetLazyDelete(LSQ_HandleT handle, double dead_ratio)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	array_data->dead_ratio = (dead_ratio > 0.0) ? dead_ratio : 0.0;
+	if (array_data->dead_ratio == 0.0)
+		LSQ_CompactSequence(handle);
+}
+
+extern void LSQ_CompactSequence(LSQ_HandleT handle)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || array_data->dead_count == 0)
+		return;
+	compactSlots(array_data);
+	shrinkContainer(array_data);
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSpan(LSQ_IteratorT iterator, LSQ_BaseTypeT ** span)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(span))
+		return 0;
+	*span = LSQ_DereferenceIterator(iterator);
+	if (*span == NULL)
+		return 0;
+	return liveRunLength(iter->array_data, (int)(*span - iter->array_data->data_ptr));
+}
+
+extern LSQ_IntegerIndexT LSQ_PeekSpan(LSQ_IteratorT iterator, const LSQ_BaseTypeT ** span)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(span))
+		return 0;
+	*span = LSQ_PeekIterator(iterator);
+	if (*span == NULL)
+		return 0;
+	return liveRunLength(iter->array_data, (int)(*span - iter->array_data->data_ptr));
+}
+
+extern LSQ_HandleT LSQ_CloneSequence(LSQ_HandleT handle)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle, * clone = NULL;
+	size_t dead_bytes;
+	if (IS_HANDLE_INVALID(handle) || array_data->queue != NULL)
+		return LSQ_HandleInvalid;
+	if (array_data->data_ptr != NULL && array_data->data_ptr != array_data->inline_data &&
+		array_data->share_count == NULL)
+	{
+		array_data->share_count = (int *)lsqAllocate(array_data->allocator, sizeof(int));
+		if (array_data->share_count == NULL)
+			return LSQ_HandleInvalid;
+		*array_data->share_count = 1;
+	}
+	clone = (ArrayDataT *)lsqAllocate(array_data->allocator, sizeof(ArrayDataT));
+	if (clone == NULL)
+		return LSQ_HandleInvalid;
+	*clone = *array_data;
+	if (array_data->data_ptr == array_data->inline_data)
+		clone->data_ptr = clone->inline_data;
+	if (array_data->dead_bits != NULL)
 	{
-		new_size = array_data->physical_size / PHYS_SIZE_CHANGE_FACTOR;
-		if (array_data->physical_size == 0)
-			new_size = LSQ_ARRAY_BASE_PHYS_SIZE;
-		setContainerSize(array_data, new_size);
+		dead_bytes = array_data->dead_words * (sizeof(unsigned long long) + sizeof(int));
+		clone->dead_bits = (unsigned long long *)lsqAllocate(array_data->allocator, dead_bytes);
+		if (clone->dead_bits == NULL)
+		{
+			lsqDeallocate(array_data->allocator, clone, sizeof(ArrayDataT));
+			return LSQ_HandleInvalid;
+		}
+		memcpy(clone->dead_bits, array_data->dead_bits, dead_bytes);
+		clone->dead_tree = (int *)(clone->dead_bits + clone->dead_words);
 	}
-}
\ No newline at end of file
+	clone->entry_capacity = 0;
+	clone->free_entry = -1;
+	clone->slot_entries = NULL;
+	clone->entry_slots = NULL;
+	if (array_data->share_count != NULL)
+		__atomic_add_fetch(array_data->share_count, 1, __ATOMIC_RELAXED);
+	return clone;
+}
+
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator))
+		return LSQ_HandleInvalid;
+	return iter->array_data->data_ptr + slotOfIndex(iter->array_data, iter->index);
+}
+
+extern void LSQ_SetHeapArity(LSQ_HandleT handle, int arity)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || arity < 2 || arity == array_data->heap_arity)
+		return;
+	array_data->heap_arity = arity;
+	LSQ_HeapBuild(handle, NULL, 0);
+}
+
+extern void LSQ_HeapBuild(LSQ_HandleT handle, const LSQ_BaseTypeT * elements, LSQ_IntegerIndexT count)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	int i;
+	if (IS_HANDLE_INVALID(handle) || count < 0 || (count > 0 && elements == NULL))
+		return;
+	if (!compactSlots(array_data) || !unshareBuffer(array_data))
+		return;
+	if (!growContainer(array_data, array_data->logical_size + count))
+		return;
+	if (array_data->slot_entries != NULL && !reserveHeapEntries(array_data, array_data->logical_size + count))
+		return;
+	for (i = 0; i < count; i++)
+		placeHeapElement(array_data, array_data->logical_size + i, elements[i], -1);
+	array_data->logical_size += count;
+	restoreHeapOrder(array_data);
+}
+
+extern void LSQ_HeapPush(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || !prepareHeapPush(array_data))
+		return;
+	array_data->logical_size++;
+	siftUp(array_data, array_data->logical_size - 1, element, -1);
+}
+
+extern LSQ_HeapEntryT LSQ_HeapPushEntry(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	int entry;
+	if (IS_HANDLE_INVALID(handle) || !prepareHeapPush(array_data) ||
+		!reserveHeapEntries(array_data, array_data->logical_size + 1))
+		return LSQ_HeapEntryInvalid;
+	entry = array_data->free_entry;
+	array_data->free_entry = array_data->entry_slots[entry];
+	array_data->logical_size++;
+	siftUp(array_data, array_data->logical_size - 1, element, entry);
+	return entry;
+}
+
+extern const LSQ_BaseTypeT* LSQ_HeapPeek(LSQ_HandleT handle)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || array_data->logical_size == 0)
+		return NULL;
+	return array_data->data_ptr + slotOfIndex(array_data, 0);
+}
+
+extern int LSQ_HeapPop(LSQ_HandleT handle, LSQ_BaseTypeT * element)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || array_data->logical_size == 0)
+		return 0;
+	if (!compactSlots(array_data) || !unshareBuffer(array_data))
+		return 0;
+	if (element != NULL)
+		*element = array_data->data_ptr[0];
+	removeHeapSlot(array_data, 0);
+	return 1;
+}
+
+extern void LSQ_HeapDecreaseKey(LSQ_HandleT handle, LSQ_HeapEntryT entry, LSQ_BaseTypeT element)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	int slot;
+	if (IS_HANDLE_INVALID(handle) || (slot = heapEntrySlot(array_data, entry)) < 0 || !unshareBuffer(array_data))
+		return;
+	if (element < array_data->data_ptr[slot])
+		siftUp(array_data, slot, element, entry);
+	else
+		siftDown(array_data, slot, element, entry);
+}
+
+extern void LSQ_HeapEraseEntry(LSQ_HandleT handle, LSQ_HeapEntryT entry)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	int slot;
+	if (IS_HANDLE_INVALID(handle) || (slot = heapEntrySlot(array_data, entry)) < 0 || !unshareBuffer(array_data))
+		return;
+	removeHeapSlot(array_data, slot);
+}
+
+extern int LSQ_StartQueueMode(LSQ_HandleT handle, LSQ_IntegerIndexT capacity, LSQ_QueueModeT mode)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	QueueStateT * queue = NULL;
+	int slot_count = 1, i;
+	if (IS_HANDLE_INVALID(handle) || array_data->queue != NULL)
+		return 0;
+	if (capacity < array_data->logical_size)
+		capacity = array_data->logical_size;
+	if (capacity > QUEUE_MAX_SLOTS)
+		return 0;
+	while (slot_count < capacity)
+		slot_count *= 2;
+	queue = (QueueStateT *)lsqAllocate(array_data->allocator, sizeof(QueueStateT));
+	if (queue == NULL)
+		return 0;
+	queue->mask = slot_count - 1;
+	queue->sequences = NULL;
+	if (mode == LSQ_QUEUE_MPMC)
+	{
+		queue->sequences = (unsigned long long *)lsqAllocate(array_data->allocator,
+			slot_count * sizeof(unsigned long long));
+		if (queue->sequences == NULL)
+		{
+			lsqDeallocate(array_data->allocator, queue, sizeof(QueueStateT));
+			return 0;
+		}
+	}
+	array_data->queue = queue;
+	if (!compactSlots(array_data) || !setContainerSize(array_data, slot_count))
+	{
+		releaseQueue(array_data);
+		return 0;
+	}
+	releaseHeapEntries(array_data);
+	queue->mode = mode;
+	queue->head = 0;
+	queue->cached_head = 0;
+	queue->tail = array_data->logical_size;
+	queue->cached_tail = array_data->logical_size;
+	for (i = 0; queue->sequences != NULL && i < slot_count; i++)
+		queue->sequences[i] = (i < array_data->logical_size) ? i + 1 : i;
+	return 1;
+}
+
+extern void LSQ_StopQueueMode(LSQ_HandleT handle)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	int front;
+	if (IS_HANDLE_INVALID(handle) || array_data->queue == NULL)
+		return;
+	/* Rotating the whole ring left by the front slot moves the elements to the start of the buffer */
+	front = (int)(array_data->queue->head & array_data->queue->mask);
+	array_data->logical_size = (int)(array_data->queue->tail - array_data->queue->head);
+	if (front != 0)
+	{
+		reverseSlots(array_data->data_ptr, 0, front);
+		reverseSlots(array_data->data_ptr, front, array_data->physical_size);
+		reverseSlots(array_data->data_ptr, 0, array_data->physical_size);
+	}
+	releaseQueue(array_data);
+	shrinkContainer(array_data);
+}
+
+extern int LSQ_TryEnqueue(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	return LSQ_EnqueueBatch(handle, &element, 1) == 1;
+}
+
+extern int LSQ_TryDequeue(LSQ_HandleT handle, LSQ_BaseTypeT * element)
+{
+	return LSQ_DequeueBatch(handle, element, 1) == 1;
+}
+
+extern LSQ_IntegerIndexT LSQ_EnqueueBatch(LSQ_HandleT handle, const LSQ_BaseTypeT * elements, LSQ_IntegerIndexT count)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || array_data->queue == NULL || elements == NULL || count <= 0)
+		return 0;
+	return (array_data->queue->mode == LSQ_QUEUE_MPMC) ? enqueueShared(array_data, elements, count) :
+		enqueueSingle(array_data, elements, count);
+}
+
+extern LSQ_IntegerIndexT LSQ_DequeueBatch(LSQ_HandleT handle, LSQ_BaseTypeT * elements, LSQ_IntegerIndexT count)
+{
+	ArrayDataT * array_data = (ArrayDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || array_data->queue == NULL || elements == NULL || count <= 0)
+		return 0;
+	return (array_data->queue->mode == LSQ_QUEUE_MPMC) ? dequeueShared(array_data, elements, count) :
+		dequeueSingle(array_data, elements, count);
+}
@@ -0,0 +1,787 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include "linear_sequence.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_external.h"
+#include "linear_sequence_span.h"
+
+/* Out-of-core sequence: the elements live in blocks of EXTERNAL_BLOCK_SIZE bytes, listed in sequence order in a    *
+ * directory that stays in memory. A Fenwick tree over the element counts of the blocks finds the block holding an  *
+ * index in O(log n). Blocks are cached in a fixed pool of frames with LRU replacement; a dirty block is written to *
+ * the spill file only when its frame is evicted. A miss right after the previous block was used is taken as a      *
+ * sequential scan and reads the following blocks too, with one system call when they lie next to each other in the *
+ * file, which is the case for blocks written in order, and asks the kernel to prefetch the window after them. A    *
+ * full block is split before an insertion, except at the ends of a full block where a new block is started so that *
+ * appending keeps blocks full; an emptied block is dropped and its file slot reused. Changing the number of blocks *
+ * in the middle rebuilds the Fenwick tree in O(b).                                                                 */
+
+#define IS_HANDLE_INVALID(handle)(handle == LSQ_HandleInvalid)
+#define EXTERNAL_BLOCK_SIZE 4096
+#define BLOCK_CAPACITY ((int)(EXTERNAL_BLOCK_SIZE / sizeof(LSQ_BaseTypeT)))
+#define EXTERNAL_DEFAULT_POOL_SIZE (4 << 20)
+#define EXTERNAL_MIN_FRAMES 4
+#define EXTERNAL_DEFAULT_READ_AHEAD 8
+#define EXTERNAL_MAX_READ_AHEAD 64
+#define EXTERNAL_DEFAULT_DIRECTORY "/tmp"
+#define NO_FRAME (-1)
+#define NO_BLOCK (-1)
+#define NO_SLOT (-1)
+
+typedef enum
+{
+	BEFOREFIRST,
+	DEREFERENCABLE,
+	PASTREAR,
+} IteratorStateT;
+
+typedef struct
+{
+	int count;
+	int frame;
+	/* Position of the block in the spill file in blocks, NO_SLOT until it is first written */
+	long long slot;
+} BlockT;
+
+typedef struct
+{
+	/* Directory position of the cached block, NO_BLOCK for an empty frame */
+	int block;
+	int dirty;
+	/* Neighbours in the LRU list, the most recently used frame is at the head */
+	int prev;
+	int next;
+} FrameT;
+
+typedef struct
+{
+	BlockT * blocks;
+	/* Fenwick tree over blocks[].count, indexed from 1 */
+	int * count_tree;
+	int block_count;
+	int block_capacity;
+	LSQ_BaseTypeT * frame_data;
+	FrameT * frames;
+	int frame_count;
+	int lru_head;
+	int lru_tail;
+	int read_ahead;
+	long long * free_slots;
+	int free_slot_count;
+	int free_slot_capacity;
+	long long file_slots;
+	int fd;
+	int size;
+	/* Incremented by every change of the block contents, which moves the block boundaries */
+	unsigned int version;
+	LSQ_ExternalStatsT stats;
+	const LSQ_AllocatorT * allocator;
+} ExternalDataT;
+
+typedef struct
+{
+	ExternalDataT * ext_data;
+	IteratorStateT state;
+	LSQ_IntegerIndexT index;
+	/* Block holding the element and the index of its first element, valid while version matches */
+	int block;
+	LSQ_IntegerIndexT block_start;
+	unsigned int version;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static int openSpillFile(const LSQ_AllocatorT * allocator, const char * directory);
+
+static int countPrefix(const ExternalDataT * ext_data, int position);
+
+static void addToCount(ExternalDataT * ext_data, int position, int delta);
+
+static void rebuildCountTree(ExternalDataT * ext_data);
+
+static int findBlock(const ExternalDataT * ext_data, int index, LSQ_IntegerIndexT * block_start);
+
+static void unlinkFrame(ExternalDataT * ext_data, int frame);
+
+static void linkFrameAtHead(ExternalDataT * ext_data, int frame);
+
+static void linkFrameAtTail(ExternalDataT * ext_data, int frame);
+
+static LSQ_BaseTypeT * frameData(const ExternalDataT * ext_data, int frame);
+
+static int writeFrame(ExternalDataT * ext_data, int frame);
+
+static int takeFrame(ExternalDataT * ext_data);
+
+static int readBlocks(ExternalDataT * ext_data, int position, int count);
+
+static LSQ_BaseTypeT * loadBlock(ExternalDataT * ext_data, int position, int for_writing);
+
+static int insertBlock(ExternalDataT * ext_data, int position);
+
+static void removeBlock(ExternalDataT * ext_data, int position);
+
+static int insertAt(ExternalDataT * ext_data, int index, LSQ_BaseTypeT value);
+
+static void deleteAt(ExternalDataT * ext_data, int index);
+
+static LSQ_BaseTypeT * iteratorElement(IteratorT * iter, int for_writing);
+
+static LSQ_IteratorT createIterator(LSQ_HandleT handle);
+
+static LSQ_HandleT createExternalSequence(const LSQ_ExternalOptionsT * options, const LSQ_AllocatorT * allocator);
+
+
+/* Creates a file in directory and unlinks it at once, so it disappears when it is closed */
+static int openSpillFile(const LSQ_AllocatorT * allocator, const char * directory)
+{
+	static const char name[] = "/lsq-spill-XXXXXX";
+	size_t length = strlen(directory);
+	char * path = (char *)lsqAllocate(allocator, length + sizeof(name));
+	int fd;
+	if (path == NULL)
+		return -1;
+	memcpy(path, directory, length);
+	memcpy(path + length, name, sizeof(name));
+	fd = mkstemp(path);
+	if (fd >= 0)
+		unlink(path);
+	lsqDeallocate(allocator, path, length + sizeof(name));
+	return fd;
+}
+
+/* Returns the number of elements in the blocks before position */
+static int countPrefix(const ExternalDataT * ext_data, int position)
+{
+	int sum = 0;
+	for (; position > 0; position &= position - 1)
+		sum += ext_data->count_tree[position];
+	return sum;
+}
+
+static void addToCount(ExternalDataT * ext_data, int position, int delta)
+{
+	ext_data->blocks[position].count += delta;
+	for (position++; position <= ext_data->block_count; position += position & -position)
+		ext_data->count_tree[position] += delta;
+}
+
+static void rebuildCountTree(ExternalDataT * ext_data)
+{
+	int i, parent;
+	for (i = 1; i <= ext_data->block_count; i++)
+		ext_data->count_tree[i] = ext_data->blocks[i - 1].count;
+	for (i = 1; i <= ext_data->block_count; i++)
+	{
+		parent = i + (i & -i);
+		if (parent <= ext_data->block_count)
+			ext_data->count_tree[parent] += ext_data->count_tree[i];
+	}
+}
+
+/* Returns the position of the block holding index, which must be below the size, and stores its first index */
+static int findBlock(const ExternalDataT * ext_data, int index, LSQ_IntegerIndexT * block_start)
+{
+	int position = 0, step = 1, start = 0;
+	while (step * 2 <= ext_data->block_count)
+		step *= 2;
+	for (; step > 0; step /= 2)
+	{
+		if (position + step <= ext_data->block_count && start + ext_data->count_tree[position + step] <= index)
+		{
+			position += step;
+			start += ext_data->count_tree[position];
+		}
+	}
+	*block_start = start;
+	return position;
+}
+
+static void unlinkFrame(ExternalDataT * ext_data, int frame)
+{
+	FrameT * frames = ext_data->frames;
+	if (frames[frame].prev != NO_FRAME)
+		frames[frames[frame].prev].next = frames[frame].next;
+	else
+		ext_data->lru_head = frames[frame].next;
+	if (frames[frame].next != NO_FRAME)
+		frames[frames[frame].next].prev = frames[frame].prev;
+	else
+		ext_data->lru_tail = frames[frame].prev;
+}
+
+static void linkFrameAtHead(ExternalDataT * ext_data, int frame)
+{
+	ext_data->frames[frame].prev = NO_FRAME;
+	ext_data->frames[frame].next = ext_data->lru_head;
+	if (ext_data->lru_head != NO_FRAME)
+		ext_data->frames[ext_data->lru_head].prev = frame;
+	else
+		ext_data->lru_tail = frame;
+	ext_data->lru_head = frame;
+}
+
+static void linkFrameAtTail(ExternalDataT * ext_data, int frame)
+{
+	ext_data->frames[frame].next = NO_FRAME;
+	ext_data->frames[frame].prev = ext_data->lru_tail;
+	if (ext_data->lru_tail != NO_FRAME)
+		ext_data->frames[ext_data->lru_tail].next = frame;
+	else
+		ext_data->lru_head = frame;
+	ext_data->lru_tail = frame;
+}
+
+static LSQ_BaseTypeT * frameData(const ExternalDataT * ext_data, int frame)
+{
+	return ext_data->frame_data + (size_t)frame * BLOCK_CAPACITY;
+}
+
+/* Writes the block of a dirty frame to its slot, giving it a slot first if it never was written */
+static int writeFrame(ExternalDataT * ext_data, int frame)
+{
+	BlockT * block = ext_data->blocks + ext_data->frames[frame].block;
+	if (!ext_data->frames[frame].dirty)
+		return 1;
+	if (block->slot == NO_SLOT)
+		block->slot = (ext_data->free_slot_count > 0) ? ext_data->free_slots[--ext_data->free_slot_count] :
+			ext_data->file_slots++;
+	if (pwrite(ext_data->fd, frameData(ext_data, frame), EXTERNAL_BLOCK_SIZE,
+			   (off_t)block->slot * EXTERNAL_BLOCK_SIZE) != EXTERNAL_BLOCK_SIZE)
+		return 0;
+	ext_data->frames[frame].dirty = 0;
+	ext_data->stats.blocks_written++;
+	return 1;
+}
+
+/* Empties the least recently used frame, writing its block back if needed, and moves it to the head of the list */
+static int takeFrame(ExternalDataT * ext_data)
+{
+	int frame = ext_data->lru_tail;
+	if (ext_data->frames[frame].block != NO_BLOCK)
+	{
+		if (!writeFrame(ext_data, frame))
+			return NO_FRAME;
+		ext_data->blocks[ext_data->frames[frame].block].frame = NO_FRAME;
+		ext_data->frames[frame].block = NO_BLOCK;
+	}
+	unlinkFrame(ext_data, frame);
+	linkFrameAtHead(ext_data, frame);
+	return frame;
+}
+
+/* Reads count blocks from position on, whose slots must be consecutive, into frames with one system call. The *
+ * first block ends up most recently used so that it outlives the blocks read ahead of it                      */
+static int readBlocks(ExternalDataT * ext_data, int position, int count)
+{
+	struct iovec vectors[EXTERNAL_MAX_READ_AHEAD + 1];
+	int frames[EXTERNAL_MAX_READ_AHEAD + 1];
+	int i;
+	for (i = count - 1; i >= 0; i--)
+	{
+		frames[i] = takeFrame(ext_data);
+		if (frames[i] == NO_FRAME)
+			break;
+		vectors[i].iov_base = frameData(ext_data, frames[i]);
+		vectors[i].iov_len = EXTERNAL_BLOCK_SIZE;
+	}
+	if (i < 0 && preadv(ext_data->fd, vectors, count, (off_t)ext_data->blocks[position].slot * EXTERNAL_BLOCK_SIZE) ==
+		(ssize_t)count * EXTERNAL_BLOCK_SIZE)
+	{
+		for (i = 0; i < count; i++)
+		{
+			ext_data->frames[frames[i]].block = position + i;
+			ext_data->frames[frames[i]].dirty = 0;
+			ext_data->blocks[position + i].frame = frames[i];
+		}
+		ext_data->stats.blocks_read += count;
+		ext_data->stats.blocks_read_ahead += count - 1;
+		/* Let the kernel fetch the next window while the caller works through this one */
+		if (count > 1)
+			posix_fadvise(ext_data->fd, (off_t)(ext_data->blocks[position].slot + count) * EXTERNAL_BLOCK_SIZE,
+						  (off_t)ext_data->read_ahead * EXTERNAL_BLOCK_SIZE, POSIX_FADV_WILLNEED);
+		return 1;
+	}
+	for (i++; i < count; i++)
+	{
+		unlinkFrame(ext_data, frames[i]);
+		linkFrameAtTail(ext_data, frames[i]);
+	}
+	return 0;
+}
+
+/* Returns the cached contents of the block at position, reading it if needed, or NULL if I/O failed */
+static LSQ_BaseTypeT * loadBlock(ExternalDataT * ext_data, int position, int for_writing)
+{
+	BlockT * block = ext_data->blocks + position;
+	int count = 1, frame = ext_data->lru_head;
+	if (block->frame != NO_FRAME)
+	{
+		ext_data->stats.hits++;
+		if (block->frame != frame)
+		{
+			unlinkFrame(ext_data, block->frame);
+			linkFrameAtHead(ext_data, block->frame);
+		}
+	}
+	else
+	{
+		ext_data->stats.misses++;
+		if (position > 0 && ext_data->frames[frame].block == position - 1)
+		{
+			while (count <= ext_data->read_ahead && position + count < ext_data->block_count &&
+				   ext_data->blocks[position + count].frame == NO_FRAME &&
+				   ext_data->blocks[position + count].slot == block->slot + count)
+				count++;
+		}
+		if (!readBlocks(ext_data, position, count))
+			return NULL;
+	}
+	ext_data->frames[block->frame].dirty |= for_writing;
+	return frameData(ext_data, block->frame);
+}
+
+/* Inserts an empty cached block at position of the directory */
+static int insertBlock(ExternalDataT * ext_data, int position)
+{
+	BlockT * blocks = NULL;
+	int * count_tree = NULL;
+	int frame, capacity, index, i;
+	if (ext_data->block_count == ext_data->block_capacity)
+	{
+		capacity = 2 * ext_data->block_capacity;
+		blocks = (BlockT *)lsqReallocate(ext_data->allocator, ext_data->blocks,
+			ext_data->block_capacity * sizeof(BlockT), capacity * sizeof(BlockT));
+		if (blocks == NULL)
+			return 0;
+		ext_data->blocks = blocks;
+		count_tree = (int *)lsqReallocate(ext_data->allocator, ext_data->count_tree,
+			(ext_data->block_capacity + 1) * sizeof(int), (capacity + 1) * sizeof(int));
+		if (count_tree == NULL)
+			return 0;
+		ext_data->count_tree = count_tree;
+		ext_data->block_capacity = capacity;
+	}
+	frame = takeFrame(ext_data);
+	if (frame == NO_FRAME)
+		return 0;
+	if (position < ext_data->block_count)
+	{
+		memmove(ext_data->blocks + position + 1, ext_data->blocks + position,
+				(ext_data->block_count - position) * sizeof(BlockT));
+		for (i = 0; i < ext_data->frame_count; i++)
+			if (ext_data->frames[i].block >= position)
+				ext_data->frames[i].block++;
+	}
+	ext_data->block_count++;
+	ext_data->blocks[position].count = 0;
+	ext_data->blocks[position].frame = frame;
+	ext_data->blocks[position].slot = NO_SLOT;
+	ext_data->frames[frame].block = position;
+	ext_data->frames[frame].dirty = 1;
+	if (position + 1 < ext_data->block_count)
+		rebuildCountTree(ext_data);
+	else
+	{
+		/* An appended entry of the Fenwick tree covers a range of earlier blocks and its own empty block */
+		index = ext_data->block_count;
+		ext_data->count_tree[index] = countPrefix(ext_data, index - 1) - countPrefix(ext_data, index - (index & -index));
+	}
+	return 1;
+}
+
+static void removeBlock(ExternalDataT * ext_data, int position)
+{
+	BlockT * block = ext_data->blocks + position;
+	int frame;
+	if (block->frame != NO_FRAME)
+	{
+		ext_data->frames[block->frame].block = NO_BLOCK;
+		ext_data->frames[block->frame].dirty = 0;
+		unlinkFrame(ext_data, block->frame);
+		linkFrameAtTail(ext_data, block->frame);
+	}
+	if (block->slot != NO_SLOT)
+	{
+		if (ext_data->free_slot_count == ext_data->free_slot_capacity)
+		{
+			long long * free_slots = (long long *)lsqReallocate(ext_data->allocator, ext_data->free_slots,
+				ext_data->free_slot_capacity * sizeof(long long), 2 * ext_data->free_slot_capacity * sizeof(long long));
+			if (free_slots != NULL)
+			{
+				ext_data->free_slots = free_slots;
+				ext_data->free_slot_capacity *= 2;
+			}
+		}
+		/* Without room in the list the slot is leaked, the file just stays larger */
+		if (ext_data->free_slot_count < ext_data->free_slot_capacity)
+			ext_data->free_slots[ext_data->free_slot_count++] = block->slot;
+	}
+	memmove(block, block + 1, (ext_data->block_count - position - 1) * sizeof(BlockT));
+	ext_data->block_count--;
+	for (frame = 0; frame < ext_data->frame_count; frame++)
+		if (ext_data->frames[frame].block > position)
+			ext_data->frames[frame].block--;
+	rebuildCountTree(ext_data);
+}
+
+static int insertAt(ExternalDataT * ext_data, int index, LSQ_BaseTypeT value)
+{
+	LSQ_BaseTypeT * data = NULL, * upper = NULL;
+	LSQ_IntegerIndexT start;
+	int position, half = BLOCK_CAPACITY / 2;
+	if (ext_data->block_count == 0 && !insertBlock(ext_data, 0))
+		return 0;
+	if (index == ext_data->size)
+	{
+		position = ext_data->block_count - 1;
+		start = ext_data->size - ext_data->blocks[position].count;
+	}
+	else
+		position = findBlock(ext_data, index, &start);
+	if (ext_data->blocks[position].count == BLOCK_CAPACITY)
+	{
+		if (index == start + BLOCK_CAPACITY || index == start)
+		{
+			if (index != start)
+			{
+				position++;
+				start = index;
+			}
+			if (!insertBlock(ext_data, position))
+				return 0;
+		}
+		else
+		{
+			/* Cut the block in half, the caller's block stays most recently used while the new one is loaded */
+			if (loadBlock(ext_data, position, 1) == NULL || !insertBlock(ext_data, position + 1))
+				return 0;
+			data = loadBlock(ext_data, position, 1);
+			upper = loadBlock(ext_data, position + 1, 1);
+			if (data == NULL || upper == NULL)
+				return 0;
+			memcpy(upper, data + half, (BLOCK_CAPACITY - half) * sizeof(LSQ_BaseTypeT));
+			addToCount(ext_data, position, half - BLOCK_CAPACITY);
+			addToCount(ext_data, position + 1, BLOCK_CAPACITY - half);
+			ext_data->version++;
+			if (index - start > half)
+			{
+				position++;
+				start += half;
+			}
+		}
+	}
+	data = loadBlock(ext_data, position, 1);
+	if (data == NULL)
+		return 0;
+	memmove(data + index - start + 1, data + index - start,
+			(ext_data->blocks[position].count - (index - start)) * sizeof(LSQ_BaseTypeT));
+	data[index - start] = value;
+	addToCount(ext_data, position, 1);
+	ext_data->size++;
+	ext_data->version++;
+	return 1;
+}
+
+static void deleteAt(ExternalDataT * ext_data, int index)
+{
+	LSQ_BaseTypeT * data = NULL;
+	LSQ_IntegerIndexT start;
+	int position = findBlock(ext_data, index, &start);
+	data = loadBlock(ext_data, position, 1);
+	if (data == NULL)
+		return;
+	memmove(data + index - start, data + index - start + 1,
+			(ext_data->blocks[position].count - (index - start) - 1) * sizeof(LSQ_BaseTypeT));
+	addToCount(ext_data, position, -1);
+	ext_data->size--;
+	ext_data->version++;
+	if (ext_data->blocks[position].count == 0)
+		removeBlock(ext_data, position);
+}
+
+static LSQ_BaseTypeT * iteratorElement(IteratorT * iter, int for_writing)
+{
+	LSQ_BaseTypeT * data = NULL;
+	if (!LSQ_IsIteratorDereferencable(iter) || iter->index >= iter->ext_data->size)
+		return NULL;
+	if (iter->version != iter->ext_data->version || iter->index < iter->block_start ||
+		iter->index >= iter->block_start + iter->ext_data->blocks[iter->block].count)
+	{
+		iter->block = findBlock(iter->ext_data, iter->index, &iter->block_start);
+		iter->version = iter->ext_data->version;
+	}
+	data = loadBlock(iter->ext_data, iter->block, for_writing);
+	return (data == NULL) ? NULL : data + (iter->index - iter->block_start);
+}
+
+static LSQ_IteratorT createIterator(LSQ_HandleT handle)
+{
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(((ExternalDataT *)handle)->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = ((ExternalDataT *)handle)->allocator;
+	iterator->ext_data = (ExternalDataT *)handle;
+	iterator->block = 0;
+	iterator->block_start = 0;
+	iterator->version = ((ExternalDataT *)handle)->version - 1;
+	return iterator;
+}
+
+static LSQ_HandleT createExternalSequence(const LSQ_ExternalOptionsT * options, const LSQ_AllocatorT * allocator)
+{
+	ExternalDataT * ext_data = (ExternalDataT *)lsqAllocate(allocator, sizeof(ExternalDataT));
+	const char * directory = (options != NULL) ? options->directory : NULL;
+	size_t pool_size = (options != NULL && options->pool_size != 0) ? options->pool_size : EXTERNAL_DEFAULT_POOL_SIZE;
+	int i;
+	if (ext_data == NULL)
+		return LSQ_HandleInvalid;
+	memset(ext_data, 0, sizeof(ExternalDataT));
+	ext_data->allocator = allocator;
+	if (directory == NULL)
+		directory = getenv("TMPDIR");
+	ext_data->fd = openSpillFile(allocator, (directory != NULL) ? directory : EXTERNAL_DEFAULT_DIRECTORY);
+	ext_data->frame_count = (int)(pool_size / EXTERNAL_BLOCK_SIZE);
+	if (ext_data->frame_count < EXTERNAL_MIN_FRAMES)
+		ext_data->frame_count = EXTERNAL_MIN_FRAMES;
+	/* Read-ahead must leave most of the pool to the blocks that are in use */
+	ext_data->read_ahead = (options == NULL || options->read_ahead_blocks == 0) ? EXTERNAL_DEFAULT_READ_AHEAD :
+		(options->read_ahead_blocks < 0) ? 0 : options->read_ahead_blocks;
+	if (ext_data->read_ahead > EXTERNAL_MAX_READ_AHEAD)
+		ext_data->read_ahead = EXTERNAL_MAX_READ_AHEAD;
+	if (ext_data->read_ahead > ext_data->frame_count / 2 - 1)
+		ext_data->read_ahead = ext_data->frame_count / 2 - 1;
+	ext_data->block_capacity = 1;
+	ext_data->free_slot_capacity = 1;
+	ext_data->blocks = (BlockT *)lsqAllocate(allocator, sizeof(BlockT));
+	ext_data->count_tree = (int *)lsqAllocate(allocator, 2 * sizeof(int));
+	ext_data->free_slots = (long long *)lsqAllocate(allocator, sizeof(long long));
+	ext_data->frames = (FrameT *)lsqAllocate(allocator, ext_data->frame_count * sizeof(FrameT));
+	ext_data->frame_data = (LSQ_BaseTypeT *)lsqAllocate(allocator, (size_t)ext_data->frame_count * EXTERNAL_BLOCK_SIZE);
+	if (ext_data->fd < 0 || ext_data->blocks == NULL || ext_data->count_tree == NULL || ext_data->free_slots == NULL ||
+		ext_data->frames == NULL || ext_data->frame_data == NULL)
+	{
+		LSQ_DestroySequence(ext_data);
+		return LSQ_HandleInvalid;
+	}
+	ext_data->lru_head = ext_data->lru_tail = NO_FRAME;
+	for (i = 0; i < ext_data->frame_count; i++)
+	{
+		ext_data->frames[i].block = NO_BLOCK;
+		ext_data->frames[i].dirty = 0;
+		linkFrameAtTail(ext_data, i);
+	}
+	return ext_data;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return createExternalSequence(NULL, NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	return createExternalSequence(NULL, allocator);
+}
+
+extern LSQ_HandleT LSQ_CreateExternalSequence(const LSQ_ExternalOptionsT * options)
+{
+	return createExternalSequence(options, NULL);
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	ExternalDataT * ext_data = (ExternalDataT *)handle;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	if (ext_data->fd >= 0)
+		close(ext_data->fd);
+	if (lsqReleasesInBulk(ext_data->allocator))
+		return;
+	lsqDeallocate(ext_data->allocator, ext_data->frame_data, (size_t)ext_data->frame_count * EXTERNAL_BLOCK_SIZE);
+	lsqDeallocate(ext_data->allocator, ext_data->frames, ext_data->frame_count * sizeof(FrameT));
+	lsqDeallocate(ext_data->allocator, ext_data->free_slots, ext_data->free_slot_capacity * sizeof(long long));
+	lsqDeallocate(ext_data->allocator, ext_data->count_tree, (ext_data->block_capacity + 1) * sizeof(int));
+	lsqDeallocate(ext_data->allocator, ext_data->blocks, ext_data->block_capacity * sizeof(BlockT));
+	lsqDeallocate(ext_data->allocator, ext_data, sizeof(ExternalDataT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return (IS_HANDLE_INVALID(handle)) ? -1 : ((ExternalDataT *)handle)->size;
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == DEREFERENCABLE));
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == PASTREAR));
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == BEFOREFIRST));
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	return iteratorElement((IteratorT *)iterator, 1);
+}
+
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator)
+{
+	return iteratorElement((IteratorT *)iterator, 0);
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSpan(LSQ_IteratorT iterator, LSQ_BaseTypeT ** span)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(span))
+		return 0;
+	*span = iteratorElement(iter, 1);
+	return (*span == NULL) ? 0 : iter->block_start + iter->ext_data->blocks[iter->block].count - iter->index;
+}
+
+extern LSQ_IntegerIndexT LSQ_PeekSpan(LSQ_IteratorT iterator, const LSQ_BaseTypeT ** span)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(span))
+		return 0;
+	*span = iteratorElement(iter, 0);
+	return (*span == NULL) ? 0 : iter->block_start + iter->ext_data->blocks[iter->block].count - iter->index;
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	IteratorT * iter = NULL;
+	if IS_HANDLE_INVALID(handle)
+		return LSQ_HandleInvalid;
+	iter = (IteratorT *)createIterator(handle);
+	if (iter == NULL)
+		return LSQ_HandleInvalid;
+	iter->index = 0;
+	LSQ_ShiftPosition(iter, index);
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	return LSQ_GetElementByIndex(handle, 0);
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? LSQ_HandleInvalid : LSQ_GetElementByIndex(handle, LSQ_GetSize(handle));
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	LSQ_ShiftPosition(iterator, 1);
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	LSQ_ShiftPosition(iterator, -1);
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	IteratorT * iter = NULL;
+	int size;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter = (IteratorT *)iterator;
+	size = iter->ext_data->size;
+	iter->index += shift;
+	iter->state = DEREFERENCABLE;
+	if (iter->index >= size)
+	{
+		iter->state = PASTREAR;
+		iter->index = size;
+	}
+	if (iter->index < 0)
+	{
+		iter->state = BEFOREFIRST;
+		iter->index = -1;
+	}
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	LSQ_ShiftPosition(iterator, pos - ((IteratorT *)iterator)->index);
+}
+
+extern void LSQ_InsertFrontElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	if (!IS_HANDLE_INVALID(handle))
+		insertAt((ExternalDataT *)handle, 0, element);
+}
+
+extern void LSQ_InsertRearElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	if (!IS_HANDLE_INVALID(handle))
+		insertAt((ExternalDataT *)handle, ((ExternalDataT *)handle)->size, element);
+}
+
+extern void LSQ_InsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT newElement)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || LSQ_IsIteratorBeforeFirst(iterator))
+		return;
+	insertAt(iter->ext_data, iter->index, newElement);
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	if (!IS_HANDLE_INVALID(handle) && ((ExternalDataT *)handle)->size > 0)
+		deleteAt((ExternalDataT *)handle, 0);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	if (!IS_HANDLE_INVALID(handle) && ((ExternalDataT *)handle)->size > 0)
+		deleteAt((ExternalDataT *)handle, ((ExternalDataT *)handle)->size - 1);
+}
+
+extern void LSQ_DeleteGivenElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator) || iter->index >= iter->ext_data->size)
+		return;
+	deleteAt(iter->ext_data, iter->index);
+	if (iter->index >= iter->ext_data->size)
+		iter->state = PASTREAR;
+}
+
+extern void LSQ_GetExternalStats(LSQ_HandleT handle, LSQ_ExternalStatsT * stats)
+{
+	if (IS_HANDLE_INVALID(handle) || stats == NULL)
+		return;
+	*stats = ((ExternalDataT *)handle)->stats;
+}
+
+extern void LSQ_ResetExternalStats(LSQ_HandleT handle)
+{
+	if (!IS_HANDLE_INVALID(handle))
+		memset(&((ExternalDataT *)handle)->stats, 0, sizeof(LSQ_ExternalStatsT));
+}
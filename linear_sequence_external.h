@@ -0,0 +1,50 @@
+#ifndef LINEAR_SEQUENCE_EXTERNAL_H
+#define LINEAR_SEQUENCE_EXTERNAL_H
+
+/* Configuration and cache statistics of the out-of-core backend (linear_sequence_external.c), which keeps the       *
+ * elements in fixed-size blocks of a spill file and caches a bounded number of them in memory. Pointers returned    *
+ * by LSQ_DereferenceIterator and LSQ_PeekIterator stay valid only until the next call that reads or writes          *
+ * elements of the sequence, because any block access may evict the block they point into. The backend also          *
+ * provides linear_sequence_span.h. LSQ_GetSpan returns the rest of the block holding the element of the iterator    *
+ * and marks the block dirty, LSQ_PeekSpan the same without marking it; the span is valid under the same rule, and   *
+ * LSQ_ShiftPosition does not access blocks, so a scan that alternates the two handles a block per call. The header  *
+ * expects linear_sequence.h to be included first.                                                                   */
+
+typedef struct
+{
+	/* Memory for cached blocks in bytes. Zero selects the default of 4 MB */
+	size_t pool_size;
+	/* Blocks read in advance when a sequential scan misses the cache. Zero selects the default of 8, a negative *
+	 * value disables read-ahead                                                                                 */
+	int read_ahead_blocks;
+	/* Directory of the spill file, which is unlinked right after creation and vanishes with the sequence. NULL *
+	 * selects TMPDIR or /tmp                                                                                    */
+	const char * directory;
+} LSQ_ExternalOptionsT;
+
+typedef struct
+{
+	/* Block accesses served from memory and those that had to read the block */
+	unsigned long long hits;
+	unsigned long long misses;
+	/* Blocks read from and written back to the spill file */
+	unsigned long long blocks_read;
+	unsigned long long blocks_written;
+	/* Blocks among blocks_read that were read ahead of a sequential scan */
+	unsigned long long blocks_read_ahead;
+} LSQ_ExternalStatsT;
+
+/* Function that creates an empty sequence with the given options, NULL selects the defaults. Returns *
+ * LSQ_HandleInvalid if the spill file cannot be created                                              */
+extern LSQ_HandleT LSQ_CreateExternalSequence(const LSQ_ExternalOptionsT * options);
+/* Function that returns a read-only pointer to the element of the iterator, or NULL if the iterator is not *
+ * dereferencable. Unlike LSQ_DereferenceIterator it does not mark the block dirty, so a read-only scan does *
+ * not write the blocks back when they are evicted                                                          */
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator);
+
+/* Function that copies the cache statistics of the sequence into stats */
+extern void LSQ_GetExternalStats(LSQ_HandleT handle, LSQ_ExternalStatsT * stats);
+/* Function that resets the cache statistics */
+extern void LSQ_ResetExternalStats(LSQ_HandleT handle);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef LINEAR_SEQUENCE_HEAP_H
+#define LINEAR_SEQUENCE_HEAP_H
+
+/* Min-heap functions for linear_sequence_dyn_arrays.c. The heap is the sequence itself: its elements are kept in *
+ * heap order, so the front element is the minimum, and the buffer grows and shrinks by the growth policy. The    *
+ * heap is binary by default; a 4-ary heap is shallower and compares the children of a node within one cache line, *
+ * which makes pops cheaper on large heaps. The sequence functions may be used on a heap, but only the heap        *
+ * functions keep the heap order. The header expects linear_sequence.h to be included first.                      */
+
+/* Handle of an element pushed by LSQ_HeapPushEntry. A handle stays valid until its element is popped or erased, *
+ * or until the sequence is modified by a function outside this header, which invalidates all handles           */
+typedef int LSQ_HeapEntryT;
+
+#define LSQ_HeapEntryInvalid (-1)
+
+/* Function that sets the number of children per node, 2 or more, and restores the heap order for it in O(n) */
+extern void LSQ_SetHeapArity(LSQ_HandleT handle, int arity);
+/* Function that appends count elements and restores the heap order of the whole sequence in O(n). With count *
+ * zero it turns the current contents into a heap                                                              */
+extern void LSQ_HeapBuild(LSQ_HandleT handle, const LSQ_BaseTypeT * elements, LSQ_IntegerIndexT count);
+/* Function that inserts an element in O(log n) */
+extern void LSQ_HeapPush(LSQ_HandleT handle, LSQ_BaseTypeT element);
+/* Function that inserts an element and returns its handle, or LSQ_HeapEntryInvalid if memory ran out */
+extern LSQ_HeapEntryT LSQ_HeapPushEntry(LSQ_HandleT handle, LSQ_BaseTypeT element);
+/* Function that returns a pointer to the minimal element, or NULL for an empty heap */
+extern const LSQ_BaseTypeT* LSQ_HeapPeek(LSQ_HandleT handle);
+/* Function that removes the minimal element and stores it in element unless it is NULL. Returns 0 if the heap *
+ * is empty                                                                                                     */
+extern int LSQ_HeapPop(LSQ_HandleT handle, LSQ_BaseTypeT * element);
+/* Function that replaces the element of entry by a smaller one. A larger element is accepted too and moved down */
+extern void LSQ_HeapDecreaseKey(LSQ_HandleT handle, LSQ_HeapEntryT entry, LSQ_BaseTypeT element);
+/* Function that removes the element of entry */
+extern void LSQ_HeapEraseEntry(LSQ_HandleT handle, LSQ_HeapEntryT entry);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef LINEAR_SEQUENCE_LAZY_DELETE_H
+#define LINEAR_SEQUENCE_LAZY_DELETE_H
+
+/* Lazy deletion for linear_sequence_dyn_arrays.c. Deleted elements only get a tombstone bit, and indices are *
+ * mapped to slots by counting tombstones in O(log n). The buffer is compacted in one pass once the share of   *
+ * dead slots exceeds the configured ratio, before an insertion anywhere except the rear, and before the       *
+ * buffer is reallocated. The header expects linear_sequence.h to be included first.                          */
+
+/* Function that enables lazy deletion with the given dead slot ratio, or disables it and compacts the buffer *
+ * for a ratio of zero. A ratio of 1 or more leaves compaction to insertions and LSQ_CompactSequence          */
+extern void LSQ_SetLazyDelete(LSQ_HandleT handle, double dead_ratio);
+/* Function that removes the slots of lazily deleted elements and shrinks the buffer by the growth policy */
+extern void LSQ_CompactSequence(LSQ_HandleT handle);
+
+#endif
@@ -2,6 +2,8 @@
 #include <string.h>
 #include <stdlib.h>
 #include "linear_sequence.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_span.h"
 
 #define isHandleInvalid(handle)(handle == LSQ_HandleInvalid)
 
@@ -17,21 +19,25 @@ typedef struct
 	ListNodePtrT before_first;
 	ListNodePtrT past_rear;
 	int size;
+	const LSQ_AllocatorT * allocator;
 } ListDataT, * ListDataPtrT;
 
 typedef struct 
 {
 	ListDataPtrT list_data;
 	ListNodePtrT node;
+	const LSQ_AllocatorT * allocator;
 } IteratorT;
 
 static LSQ_IteratorT createIterator(LSQ_HandleT handle, ListNodePtrT node)
 {
-	IteratorT * iterator = (IteratorT *)malloc(sizeof(IteratorT));
+	IteratorT * iterator = NULL;
 	if(isHandleInvalid(handle)) 
 		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(((ListDataPtrT)handle)->allocator, sizeof(IteratorT));
 	if isHandleInvalid(iterator) 
 		return LSQ_HandleInvalid;
+	iterator->allocator = ((ListDataPtrT)handle)->allocator;
 	iterator->list_data = (ListDataPtrT)handle;
 	iterator->node = node;
 	return iterator;
@@ -39,14 +45,20 @@ static LSQ_IteratorT createIterator(LSQ_HandleT handle, ListNodePtrT node)
 
 extern LSQ_HandleT LSQ_CreateSequence(void) 
 {
-	ListDataPtrT list_data = (ListDataPtrT)malloc(sizeof(ListDataT));
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	ListDataPtrT list_data = (ListDataPtrT)lsqAllocate(allocator, sizeof(ListDataT));
 	if isHandleInvalid(list_data)
 		return LSQ_HandleInvalid;
 	list_data->size = 0;
-	list_data->before_first = (ListNodePtrT)malloc(sizeof(ListNodeT));
+	list_data->allocator = allocator;
+	list_data->before_first = (ListNodePtrT)lsqAllocate(allocator, sizeof(ListNodeT));
 	if isHandleInvalid(list_data->before_first)
 		return LSQ_HandleInvalid;
-	list_data->past_rear = (ListNodePtrT)malloc(sizeof(ListNodeT));
+	list_data->past_rear = (ListNodePtrT)lsqAllocate(allocator, sizeof(ListNodeT));
 	if isHandleInvalid(list_data->before_first)
 		return LSQ_HandleInvalid;
 	list_data->before_first->next = list_data->past_rear;
@@ -60,16 +72,16 @@ extern void LSQ_DestroySequence(LSQ_HandleT handle)
 {
 	ListDataPtrT list_data = (ListDataPtrT)handle;
 	ListNodePtrT tmp_node = NULL;
-	if isHandleInvalid(handle)
+	if (isHandleInvalid(handle) || lsqReleasesInBulk(list_data->allocator))
 		return;
 	tmp_node = list_data->before_first;
 	while (tmp_node->next != NULL)
 	{
 		tmp_node = tmp_node->next;
-		free(tmp_node->prev);
+		lsqDeallocate(list_data->allocator, tmp_node->prev, sizeof(ListNodeT));
 	}
-	free(tmp_node);
-	free(list_data);
+	lsqDeallocate(list_data->allocator, tmp_node, sizeof(ListNodeT));
+	lsqDeallocate(list_data->allocator, list_data, sizeof(ListDataT));
 }
 
 extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
@@ -139,7 +151,7 @@ extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
 {
 	if (isHandleInvalid(iterator))  
 		return;
-	free(iterator);
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
 }
 
 extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
@@ -207,7 +219,7 @@ extern void LSQ_InsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT n
 	ListNodePtrT node = NULL;
     if (isHandleInvalid(iterator))
         return;
-	node = (ListNodePtrT)malloc(sizeof(ListNodeT));
+	node = (ListNodePtrT)lsqAllocate(tmp_iterator->list_data->allocator, sizeof(ListNodeT));
 	if isHandleInvalid(node)
 		return;
 	node->next = tmp_iterator->node;
@@ -245,5 +257,18 @@ extern void LSQ_DeleteGivenElement(LSQ_IteratorT iterator)
     tmp_iterator->node->prev->next = tmp_iterator->node->next;
     tmp_iterator->node->next->prev = tmp_iterator->node->prev;
     tmp_iterator->node = cur_node->next;
-    free(cur_node);
-}
\ No newline at end of file
+    lsqDeallocate(tmp_iterator->list_data->allocator, cur_node, sizeof(ListNodeT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSpan(LSQ_IteratorT iterator, LSQ_BaseTypeT ** span)
+{
+	if (isHandleInvalid(span))
+		return 0;
+	*span = LSQ_DereferenceIterator(iterator);
+	return (*span == NULL) ? 0 : 1;
+}
+
+extern LSQ_IntegerIndexT LSQ_PeekSpan(LSQ_IteratorT iterator, const LSQ_BaseTypeT ** span)
+{
+	return LSQ_GetSpan(iterator, (LSQ_BaseTypeT **)span);
+}
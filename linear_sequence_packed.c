@@ -0,0 +1,688 @@
+#include <string.h>
+#include <stdlib.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "linear_sequence.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_packed.h"
+#include "linear_sequence_span.h"
+
+/* Packed sequence: the elements are sealed into blocks of PACKED_BLOCK_LENGTH values, each stored in the fewest bits *
+ * that hold either its values minus their minimum (frame of reference) or its successive differences minus their   *
+ * minimum (delta), whichever is smaller. The bits are laid out in four interleaved lanes, element j in lane j % 4,  *
+ * so one SSE2 shift and mask unpacks four consecutive elements. A directory entry per block records where its bits *
+ * start in the stream, so the block of an index is found by a division. New elements collect in an uncompressed   *
+ * rear buffer that is sealed when full. Iterators decode the whole block they are in once and then read the copy.  *
+ * The iterator that last handed out a writable pointer into its copy is the writer of the sequence; the next call  *
+ * that reads or changes the blocks, or the destruction of the writer, first encodes a changed copy again in place  *
+ * of the block, moving the stream after it if the width changed.                                                   */
+
+#define IS_HANDLE_INVALID(handle)(handle == LSQ_HandleInvalid)
+#define PACKED_BLOCK_LENGTH 128
+#define PACKED_LANES 4
+#define PACKED_BLOCK_SHIFT 7
+/* Largest block, all values 32 bits wide */
+#define PACKED_MAX_BLOCK_WORDS (PACKED_LANES * 32)
+
+typedef char PackedBaseTypeCheckT[(sizeof(LSQ_BaseTypeT) == sizeof(unsigned int)) ? 1 : -1];
+
+typedef enum
+{
+	BEFOREFIRST,
+	DEREFERENCABLE,
+	PASTREAR,
+} IteratorStateT;
+
+typedef struct
+{
+	/* First word of the block in the stream; the block takes PACKED_LANES * width words */
+	unsigned int offset;
+	/* Value added to every decoded value, for delta blocks after the running sum */
+	unsigned int base;
+	/* Value added to every decoded difference of a delta block */
+	unsigned int reference;
+	unsigned char width;
+	unsigned char is_delta;
+} PackedBlockT;
+
+struct IteratorStruct;
+
+typedef struct
+{
+	unsigned int * stream;
+	size_t stream_size;
+	size_t stream_capacity;
+	PackedBlockT * blocks;
+	int block_count;
+	int block_capacity;
+	LSQ_BaseTypeT tail[PACKED_BLOCK_LENGTH];
+	int tail_count;
+	/* Incremented by every change that re-encodes blocks */
+	unsigned int version;
+	/* Iterator whose decoded block may hold writes that are not stored yet, or NULL */
+	struct IteratorStruct * writer;
+	const LSQ_AllocatorT * allocator;
+} PackedDataT;
+
+typedef struct IteratorStruct
+{
+	PackedDataT * packed_data;
+	IteratorStateT state;
+	LSQ_IntegerIndexT index;
+	/* Block decoded into values, or -1, valid while version matches */
+	int block;
+	unsigned int version;
+	LSQ_BaseTypeT values[PACKED_BLOCK_LENGTH];
+	/* Non-zero while the iterator is the writer of the sequence */
+	int writing;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static int bitWidth(unsigned int value);
+
+static void packValues(const unsigned int * values, int width, unsigned int * words);
+
+static void decodeBlock(const PackedDataT * packed_data, int block_index, LSQ_BaseTypeT * values);
+
+static int encodeBlock(const LSQ_BaseTypeT * values, PackedBlockT * block, unsigned int * words);
+
+static int reserveStream(PackedDataT * packed_data, size_t words);
+
+static int sealTail(PackedDataT * packed_data);
+
+static int resealBlock(PackedDataT * packed_data, int block_index, const LSQ_BaseTypeT * values);
+
+static void storeWrites(PackedDataT * packed_data);
+
+static LSQ_BaseTypeT * iteratorElement(IteratorT * iter, int for_writing);
+
+static int spanLength(const IteratorT * iter);
+
+static void unsealLastBlock(PackedDataT * packed_data);
+
+static int appendElement(PackedDataT * packed_data, LSQ_BaseTypeT value);
+
+static void rewriteFrom(PackedDataT * packed_data, int index, int deleted, const LSQ_BaseTypeT * inserted);
+
+static int sealedSize(const PackedDataT * packed_data);
+
+static LSQ_IteratorT createIterator(LSQ_HandleT handle);
+
+
+static int bitWidth(unsigned int value)
+{
+	return (value == 0) ? 0 : 32 - __builtin_clz(value);
+}
+
+/* Stores PACKED_BLOCK_LENGTH values below 2^width; value j takes bits (j / 4) * width on of lane j % 4 */
+static void packValues(const unsigned int * values, int width, unsigned int * words)
+{
+	int j, bit, word, shift;
+	memset(words, 0, PACKED_LANES * width * sizeof(unsigned int));
+	for (j = 0; j < PACKED_BLOCK_LENGTH && width > 0; j++)
+	{
+		bit = (j / PACKED_LANES) * width;
+		word = (bit / 32) * PACKED_LANES + j % PACKED_LANES;
+		shift = bit % 32;
+		words[word] |= values[j] << shift;
+		if (shift + width > 32)
+			words[word + PACKED_LANES] |= values[j] >> (32 - shift);
+	}
+}
+
+static void decodeBlock(const PackedDataT * packed_data, int block_index, LSQ_BaseTypeT * values)
+{
+	const PackedBlockT * block = packed_data->blocks + block_index;
+	const unsigned int * words = packed_data->stream + block->offset;
+	int width = block->width, shift = 0, word = 0, k;
+#ifdef __SSE2__
+	__m128i current = (width > 0) ? _mm_loadu_si128((const __m128i *)words) : _mm_setzero_si128();
+	__m128i mask = _mm_set1_epi32((width == 32) ? -1 : (int)((1u << width) - 1));
+	__m128i reference = _mm_set1_epi32((int)block->reference), sum = _mm_set1_epi32((int)block->base), value;
+	for (k = 0; k < PACKED_BLOCK_LENGTH / PACKED_LANES; k++)
+	{
+		value = _mm_srl_epi32(current, _mm_cvtsi32_si128(shift));
+		shift += width;
+		if (shift >= 32)
+		{
+			shift -= 32;
+			if (++word < width)
+				current = _mm_loadu_si128((const __m128i *)words + word);
+			if (shift > 0)
+				value = _mm_or_si128(value, _mm_sll_epi32(current, _mm_cvtsi32_si128(width - shift)));
+		}
+		value = _mm_and_si128(value, mask);
+		if (block->is_delta)
+		{
+			/* Running sum of the four differences, carried on from the previous four */
+			value = _mm_add_epi32(value, reference);
+			value = _mm_add_epi32(value, _mm_slli_si128(value, 4));
+			value = _mm_add_epi32(value, _mm_slli_si128(value, 8));
+			value = _mm_add_epi32(value, sum);
+			sum = _mm_shuffle_epi32(value, _MM_SHUFFLE(3, 3, 3, 3));
+		}
+		else
+			value = _mm_add_epi32(value, sum);
+		_mm_storeu_si128((__m128i *)values + k, value);
+	}
+#else
+	unsigned int mask = (width == 32) ? ~0u : (1u << width) - 1, sum = block->base, value;
+	int lane, j;
+	for (k = 0; k < PACKED_BLOCK_LENGTH / PACKED_LANES; k++)
+	{
+		for (lane = 0; lane < PACKED_LANES; lane++)
+		{
+			j = k * PACKED_LANES + lane;
+			value = (width > 0) ? words[word * PACKED_LANES + lane] >> shift : 0;
+			if (shift + width > 32)
+				value |= words[(word + 1) * PACKED_LANES + lane] << (32 - shift);
+			value &= mask;
+			if (block->is_delta)
+			{
+				sum += value + block->reference;
+				value = sum;
+			}
+			else
+				value += block->base;
+			values[j] = (LSQ_BaseTypeT)value;
+		}
+		shift += width;
+		word += shift / 32;
+		shift %= 32;
+	}
+#endif
+}
+
+/* Chooses the encoding of PACKED_BLOCK_LENGTH values, fills in the block except its offset and stores the packed *
+ * values in words. Returns the number of words, at most PACKED_MAX_BLOCK_WORDS                                   */
+static int encodeBlock(const LSQ_BaseTypeT * values, PackedBlockT * block, unsigned int * words)
+{
+	unsigned int packed[PACKED_BLOCK_LENGTH], previous;
+	LSQ_BaseTypeT min_value = values[0], max_value = values[0];
+	int min_delta = 0, max_delta = 0, delta, j, width, delta_width, is_delta;
+	for (j = 1; j < PACKED_BLOCK_LENGTH; j++)
+	{
+		min_value = (values[j] < min_value) ? values[j] : min_value;
+		max_value = (values[j] > max_value) ? values[j] : max_value;
+		delta = (int)((unsigned int)values[j] - (unsigned int)values[j - 1]);
+		min_delta = (j == 1 || delta < min_delta) ? delta : min_delta;
+		max_delta = (j == 1 || delta > max_delta) ? delta : max_delta;
+	}
+	width = bitWidth((unsigned int)max_value - (unsigned int)min_value);
+	delta_width = bitWidth((unsigned int)max_delta - (unsigned int)min_delta);
+	is_delta = delta_width < width;
+	if (is_delta)
+		width = delta_width;
+	block->width = (unsigned char)width;
+	block->is_delta = (unsigned char)is_delta;
+	if (block->is_delta)
+	{
+		/* The first difference is zero, so base starts the running sum one reference below the first value */
+		block->reference = (unsigned int)min_delta;
+		block->base = (unsigned int)values[0] - block->reference;
+		packed[0] = 0;
+		for (j = 1, previous = (unsigned int)values[0]; j < PACKED_BLOCK_LENGTH; previous = (unsigned int)values[j++])
+			packed[j] = (unsigned int)values[j] - previous - block->reference;
+	}
+	else
+	{
+		block->reference = 0;
+		block->base = (unsigned int)min_value;
+		for (j = 0; j < PACKED_BLOCK_LENGTH; j++)
+			packed[j] = (unsigned int)values[j] - block->base;
+	}
+	packValues(packed, width, words);
+	return PACKED_LANES * width;
+}
+
+/* Makes room for the stream to hold words words. Returns 0 if allocation failed */
+static int reserveStream(PackedDataT * packed_data, size_t words)
+{
+	unsigned int * stream = NULL;
+	size_t capacity = packed_data->stream_capacity;
+	while (capacity < words)
+		capacity *= 2;
+	if (capacity == packed_data->stream_capacity)
+		return 1;
+	stream = (unsigned int *)lsqReallocate(packed_data->allocator, packed_data->stream,
+		packed_data->stream_capacity * sizeof(unsigned int), capacity * sizeof(unsigned int));
+	if (stream == NULL)
+		return 0;
+	packed_data->stream = stream;
+	packed_data->stream_capacity = capacity;
+	return 1;
+}
+
+/* Encodes the full rear buffer as a new block */
+static int sealTail(PackedDataT * packed_data)
+{
+	unsigned int words[PACKED_MAX_BLOCK_WORDS];
+	PackedBlockT encoded, * blocks = NULL;
+	int word_count = encodeBlock(packed_data->tail, &encoded, words);
+	if (packed_data->block_count == packed_data->block_capacity)
+	{
+		blocks = (PackedBlockT *)lsqReallocate(packed_data->allocator, packed_data->blocks,
+			packed_data->block_capacity * sizeof(PackedBlockT), 2 * packed_data->block_capacity * sizeof(PackedBlockT));
+		if (blocks == NULL)
+			return 0;
+		packed_data->blocks = blocks;
+		packed_data->block_capacity *= 2;
+	}
+	if (!reserveStream(packed_data, packed_data->stream_size + word_count))
+		return 0;
+	encoded.offset = (unsigned int)packed_data->stream_size;
+	memcpy(packed_data->stream + packed_data->stream_size, words, word_count * sizeof(unsigned int));
+	packed_data->blocks[packed_data->block_count] = encoded;
+	packed_data->stream_size += word_count;
+	packed_data->block_count++;
+	packed_data->tail_count = 0;
+	return 1;
+}
+
+/* Encodes values in place of a sealed block, moving the rest of the stream when the width changes. Returns 0 and *
+ * leaves the block as it was if the stream could not grow                                                       */
+static int resealBlock(PackedDataT * packed_data, int block_index, const LSQ_BaseTypeT * values)
+{
+	unsigned int words[PACKED_MAX_BLOCK_WORDS];
+	PackedBlockT encoded, * block = packed_data->blocks + block_index;
+	int word_count = encodeBlock(values, &encoded, words), old_count = PACKED_LANES * block->width, i;
+	size_t rest = block->offset + old_count;
+	if (word_count > old_count && !reserveStream(packed_data, packed_data->stream_size + word_count - old_count))
+		return 0;
+	if (word_count != old_count)
+	{
+		memmove(packed_data->stream + block->offset + word_count, packed_data->stream + rest,
+				(packed_data->stream_size - rest) * sizeof(unsigned int));
+		packed_data->stream_size = packed_data->stream_size + word_count - old_count;
+		for (i = block_index + 1; i < packed_data->block_count; i++)
+			packed_data->blocks[i].offset = packed_data->blocks[i].offset + word_count - old_count;
+	}
+	encoded.offset = block->offset;
+	memcpy(packed_data->stream + encoded.offset, words, word_count * sizeof(unsigned int));
+	*block = encoded;
+	packed_data->version++;
+	return 1;
+}
+
+/* Stores the decoded block of the writer if it differs from the block, unless a modification has re-encoded the *
+ * block since it was decoded. The writer keeps its copy, which then matches the block                            */
+static void storeWrites(PackedDataT * packed_data)
+{
+	IteratorT * writer = packed_data->writer;
+	LSQ_BaseTypeT stored[PACKED_BLOCK_LENGTH];
+	if (writer == NULL)
+		return;
+	packed_data->writer = NULL;
+	writer->writing = 0;
+	if (writer->version != packed_data->version)
+		return;
+	/* Decoding is much cheaper than encoding, and than moving the stream when the width changes */
+	decodeBlock(packed_data, writer->block, stored);
+	if (memcmp(stored, writer->values, sizeof(stored)) != 0 && resealBlock(packed_data, writer->block, writer->values))
+		writer->version = packed_data->version;
+}
+
+/* Returns a pointer to the element of a dereferencable iterator, in the rear buffer or in the decoded copy of its *
+ * block, which makes the iterator the writer if the pointer is for writing                                        */
+static LSQ_BaseTypeT * iteratorElement(IteratorT * iter, int for_writing)
+{
+	PackedDataT * packed_data = iter->packed_data;
+	int block_index = iter->index >> PACKED_BLOCK_SHIFT;
+	if (packed_data->writer != iter)
+		storeWrites(packed_data);
+	if (block_index >= packed_data->block_count)
+		return packed_data->tail + (iter->index - sealedSize(packed_data));
+	if (iter->block != block_index || iter->version != packed_data->version)
+	{
+		storeWrites(packed_data);
+		decodeBlock(packed_data, block_index, iter->values);
+		iter->block = block_index;
+		iter->version = packed_data->version;
+	}
+	if (for_writing)
+	{
+		packed_data->writer = iter;
+		iter->writing = 1;
+	}
+	return iter->values + (iter->index & (PACKED_BLOCK_LENGTH - 1));
+}
+
+/* Number of elements from the one of a dereferencable iterator to the end of its block or of the rear buffer */
+static int spanLength(const IteratorT * iter)
+{
+	if ((iter->index >> PACKED_BLOCK_SHIFT) >= iter->packed_data->block_count)
+		return LSQ_GetSize(iter->packed_data) - iter->index;
+	return PACKED_BLOCK_LENGTH - (iter->index & (PACKED_BLOCK_LENGTH - 1));
+}
+
+/* Moves the last block back into the empty rear buffer */
+static void unsealLastBlock(PackedDataT * packed_data)
+{
+	packed_data->block_count--;
+	decodeBlock(packed_data, packed_data->block_count, packed_data->tail);
+	packed_data->stream_size = packed_data->blocks[packed_data->block_count].offset;
+	packed_data->tail_count = PACKED_BLOCK_LENGTH;
+	packed_data->version++;
+}
+
+static int appendElement(PackedDataT * packed_data, LSQ_BaseTypeT value)
+{
+	packed_data->tail[packed_data->tail_count++] = value;
+	if (packed_data->tail_count < PACKED_BLOCK_LENGTH)
+		return 1;
+	packed_data->version++;
+	if (sealTail(packed_data))
+		return 1;
+	packed_data->tail_count--;
+	return 0;
+}
+
+/* Re-encodes the sequence from index on after deleting one element there or inserting *inserted before it */
+static void rewriteFrom(PackedDataT * packed_data, int index, int deleted, const LSQ_BaseTypeT * inserted)
+{
+	int first_block = index >> PACKED_BLOCK_SHIFT, count, capacity, i, from;
+	LSQ_BaseTypeT * elements = NULL;
+	if (first_block >= packed_data->block_count)
+	{
+		/* Only the rear buffer changes */
+		from = index - sealedSize(packed_data);
+		if (deleted)
+		{
+			memmove(packed_data->tail + from, packed_data->tail + from + 1,
+					(packed_data->tail_count - from - 1) * sizeof(LSQ_BaseTypeT));
+			packed_data->tail_count--;
+			return;
+		}
+		memmove(packed_data->tail + from + 1, packed_data->tail + from,
+				(packed_data->tail_count - from) * sizeof(LSQ_BaseTypeT));
+		packed_data->tail[from] = *inserted;
+		packed_data->tail_count++;
+		if (packed_data->tail_count == PACKED_BLOCK_LENGTH && !sealTail(packed_data))
+			packed_data->tail_count--;
+		packed_data->version++;
+		return;
+	}
+	count = sealedSize(packed_data) + packed_data->tail_count - first_block * PACKED_BLOCK_LENGTH;
+	capacity = count + 1;
+	elements = (LSQ_BaseTypeT *)lsqAllocate(packed_data->allocator, capacity * sizeof(LSQ_BaseTypeT));
+	if (elements == NULL)
+		return;
+	for (i = first_block; i < packed_data->block_count; i++)
+		decodeBlock(packed_data, i, elements + (i - first_block) * PACKED_BLOCK_LENGTH);
+	memcpy(elements + (packed_data->block_count - first_block) * PACKED_BLOCK_LENGTH, packed_data->tail,
+		   packed_data->tail_count * sizeof(LSQ_BaseTypeT));
+	from = index - first_block * PACKED_BLOCK_LENGTH;
+	if (deleted)
+		memmove(elements + from, elements + from + 1, (count - from - 1) * sizeof(LSQ_BaseTypeT));
+	else
+	{
+		memmove(elements + from + 1, elements + from, (count - from) * sizeof(LSQ_BaseTypeT));
+		elements[from] = *inserted;
+	}
+	count += deleted ? -1 : 1;
+	packed_data->stream_size = packed_data->blocks[first_block].offset;
+	packed_data->block_count = first_block;
+	packed_data->tail_count = 0;
+	packed_data->version++;
+	for (i = 0; i < count; i++)
+		appendElement(packed_data, elements[i]);
+	lsqDeallocate(packed_data->allocator, elements, capacity * sizeof(LSQ_BaseTypeT));
+}
+
+static int sealedSize(const PackedDataT * packed_data)
+{
+	return packed_data->block_count * PACKED_BLOCK_LENGTH;
+}
+
+static LSQ_IteratorT createIterator(LSQ_HandleT handle)
+{
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(((PackedDataT *)handle)->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = ((PackedDataT *)handle)->allocator;
+	iterator->packed_data = (PackedDataT *)handle;
+	iterator->block = -1;
+	iterator->version = 0;
+	iterator->writing = 0;
+	return iterator;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	PackedDataT * packed_data = (PackedDataT *)lsqAllocate(allocator, sizeof(PackedDataT));
+	if (packed_data == NULL)
+		return LSQ_HandleInvalid;
+	packed_data->allocator = allocator;
+	packed_data->stream_size = 0;
+	packed_data->stream_capacity = PACKED_LANES * 32;
+	packed_data->block_count = 0;
+	packed_data->block_capacity = 1;
+	packed_data->tail_count = 0;
+	packed_data->version = 0;
+	packed_data->writer = NULL;
+	packed_data->stream = (unsigned int *)lsqAllocate(allocator, packed_data->stream_capacity * sizeof(unsigned int));
+	packed_data->blocks = (PackedBlockT *)lsqAllocate(allocator, sizeof(PackedBlockT));
+	if (packed_data->stream == NULL || packed_data->blocks == NULL)
+	{
+		LSQ_DestroySequence(packed_data);
+		return LSQ_HandleInvalid;
+	}
+	return packed_data;
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	PackedDataT * packed_data = (PackedDataT *)handle;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	/* The writer may outlive the sequence and must not store its block then */
+	if (packed_data->writer != NULL)
+		packed_data->writer->writing = 0;
+	if (lsqReleasesInBulk(packed_data->allocator))
+		return;
+	lsqDeallocate(packed_data->allocator, packed_data->stream, packed_data->stream_capacity * sizeof(unsigned int));
+	lsqDeallocate(packed_data->allocator, packed_data->blocks, packed_data->block_capacity * sizeof(PackedBlockT));
+	lsqDeallocate(packed_data->allocator, packed_data, sizeof(PackedDataT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return (IS_HANDLE_INVALID(handle)) ? -1 : sealedSize((PackedDataT *)handle) + ((PackedDataT *)handle)->tail_count;
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == DEREFERENCABLE));
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == PASTREAR));
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == BEFOREFIRST));
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator) || iter->index >= LSQ_GetSize(iter->packed_data))
+		return NULL;
+	return iteratorElement(iter, 1);
+}
+
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator) || iter->index >= LSQ_GetSize(iter->packed_data))
+		return NULL;
+	return iteratorElement(iter, 0);
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSpan(LSQ_IteratorT iterator, LSQ_BaseTypeT ** span)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(span))
+		return 0;
+	*span = LSQ_DereferenceIterator(iterator);
+	return (*span == NULL) ? 0 : spanLength(iter);
+}
+
+extern LSQ_IntegerIndexT LSQ_PeekSpan(LSQ_IteratorT iterator, const LSQ_BaseTypeT ** span)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(span))
+		return 0;
+	*span = LSQ_PeekIterator(iterator);
+	return (*span == NULL) ? 0 : spanLength(iter);
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	IteratorT * iter = NULL;
+	if IS_HANDLE_INVALID(handle)
+		return LSQ_HandleInvalid;
+	iter = (IteratorT *)createIterator(handle);
+	if (iter == NULL)
+		return LSQ_HandleInvalid;
+	iter->index = 0;
+	LSQ_ShiftPosition(iter, index);
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	return LSQ_GetElementByIndex(handle, 0);
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? LSQ_HandleInvalid : LSQ_GetElementByIndex(handle, LSQ_GetSize(handle));
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	if (((IteratorT *)iterator)->writing)
+		storeWrites(((IteratorT *)iterator)->packed_data);
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	LSQ_ShiftPosition(iterator, 1);
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	LSQ_ShiftPosition(iterator, -1);
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	IteratorT * iter = NULL;
+	int size;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter = (IteratorT *)iterator;
+	size = LSQ_GetSize(iter->packed_data);
+	iter->index += shift;
+	iter->state = DEREFERENCABLE;
+	if (iter->index >= size)
+	{
+		iter->state = PASTREAR;
+		iter->index = size;
+	}
+	if (iter->index < 0)
+	{
+		iter->state = BEFOREFIRST;
+		iter->index = -1;
+	}
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	LSQ_ShiftPosition(iterator, pos - ((IteratorT *)iterator)->index);
+}
+
+extern void LSQ_InsertFrontElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	storeWrites((PackedDataT *)handle);
+	rewriteFrom((PackedDataT *)handle, 0, 0, &element);
+}
+
+extern void LSQ_InsertRearElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	storeWrites((PackedDataT *)handle);
+	appendElement((PackedDataT *)handle, element);
+}
+
+extern void LSQ_InsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT newElement)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || LSQ_IsIteratorBeforeFirst(iterator))
+		return;
+	storeWrites(iter->packed_data);
+	if (iter->index == LSQ_GetSize(iter->packed_data))
+		appendElement(iter->packed_data, newElement);
+	else
+		rewriteFrom(iter->packed_data, iter->index, 0, &newElement);
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	if (IS_HANDLE_INVALID(handle) || LSQ_GetSize(handle) == 0)
+		return;
+	storeWrites((PackedDataT *)handle);
+	rewriteFrom((PackedDataT *)handle, 0, 1, NULL);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	PackedDataT * packed_data = (PackedDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || LSQ_GetSize(handle) == 0)
+		return;
+	storeWrites(packed_data);
+	if (packed_data->tail_count == 0)
+		unsealLastBlock(packed_data);
+	packed_data->tail_count--;
+}
+
+extern void LSQ_DeleteGivenElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator) || iter->index >= LSQ_GetSize(iter->packed_data))
+		return;
+	storeWrites(iter->packed_data);
+	rewriteFrom(iter->packed_data, iter->index, 1, NULL);
+	if (iter->index >= LSQ_GetSize(iter->packed_data))
+		iter->state = PASTREAR;
+}
+
+extern size_t LSQ_GetPackedSize(LSQ_HandleT handle)
+{
+	PackedDataT * packed_data = (PackedDataT *)handle;
+	if (IS_HANDLE_INVALID(handle))
+		return 0;
+	storeWrites(packed_data);
+	return packed_data->stream_size * sizeof(unsigned int) + packed_data->block_count * sizeof(PackedBlockT) +
+		packed_data->tail_count * sizeof(LSQ_BaseTypeT);
+}
@@ -0,0 +1,22 @@
+#ifndef LINEAR_SEQUENCE_PACKED_H
+#define LINEAR_SEQUENCE_PACKED_H
+
+/* Compressed backend for integer sequences (linear_sequence_packed.c), meant for sorted or slowly varying values   *
+ * such as timestamps and identifiers that are mostly appended and read. LSQ_BaseTypeT must be a 32-bit integer.    *
+ * Appending and deleting at the rear are amortised O(1), other insertions and deletions re-encode the sequence     *
+ * from the affected position on. LSQ_DereferenceIterator and LSQ_GetSpan of linear_sequence_span.h return          *
+ * pointers into a decoded copy of the block of 128 elements that holds the element. Writes through them are        *
+ * stored by encoding the copy again when the sequence is next read or changed through its handle or another        *
+ * iterator, or when the iterator is destroyed, and the pointers stay valid until then or until the iterator is     *
+ * dereferenced in another block. A write that widens the block moves the encoded stream after it, and is lost if   *
+ * the stream cannot grow. LSQ_PeekSpan returns a read-only span that does not make the block be encoded again.     *
+ * The header expects linear_sequence.h to be included first.                                                       */
+
+/* Function that returns the number of bytes used by the encoded elements, their block directory and the rear *
+ * buffer, which is what the sequence needs besides its handle                                                 */
+extern size_t LSQ_GetPackedSize(LSQ_HandleT handle);
+/* Function that returns a read-only pointer to the element of the iterator, or NULL if the iterator is not *
+ * dereferencable. Unlike LSQ_DereferenceIterator it does not make the block be compared and encoded again  */
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator);
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "linear_sequence.h"
+#include "linear_sequence_pages.h"
+
+#define PAGES_DEFAULT_THRESHOLD (1 << 20)
+#define PAGES_HUGE_PAGE_SIZE (2 << 20)
+#define IS_HANDLE_INVALID(handle)(handle == LSQ_HandleInvalid)
+
+typedef struct
+{
+	LSQ_AllocatorT allocator;
+	size_t threshold;
+	/* Mapping lengths and addresses are multiples of the granularity, a page or a huge page */
+	size_t granularity;
+	int huge_pages;
+	/* Updated atomically, the rest of the allocator does not change after creation */
+	size_t mapped_size;
+} PageAllocatorT;
+
+static size_t mappingLength(const PageAllocatorT * pages, size_t size);
+
+static void * mapAligned(const PageAllocatorT * pages, size_t length);
+
+static void adviseMapping(const PageAllocatorT * pages, void * ptr, size_t length);
+
+static void * resizeMapping(PageAllocatorT * pages, void * ptr, size_t old_length, size_t new_length);
+
+static void * pagesAllocate(void * context, size_t size);
+
+static void * pagesReallocate(void * context, void * ptr, size_t old_size, size_t new_size);
+
+static void pagesDeallocate(void * context, void * ptr, size_t size);
+
+
+static size_t mappingLength(const PageAllocatorT * pages, size_t size)
+{
+	return (size + pages->granularity - 1) & ~(pages->granularity - 1);
+}
+
+/* Maps length bytes at an address aligned to the granularity by mapping a larger range and trimming both ends */
+static void * mapAligned(const PageAllocatorT * pages, size_t length)
+{
+	size_t slack = (pages->granularity > (size_t)sysconf(_SC_PAGESIZE)) ? pages->granularity : 0;
+	char * raw = (char *)mmap(NULL, length + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	char * aligned = NULL;
+	if (raw == MAP_FAILED)
+		return NULL;
+	if (slack == 0)
+		return raw;
+	aligned = (char *)(((uintptr_t)raw + slack - 1) & ~(uintptr_t)(slack - 1));
+	if (aligned > raw)
+		munmap(raw, aligned - raw);
+	if (aligned + length < raw + length + slack)
+		munmap(aligned + length, raw + slack - aligned);
+	return aligned;
+}
+
+static void adviseMapping(const PageAllocatorT * pages, void * ptr, size_t length)
+{
+	if (pages->huge_pages)
+		madvise(ptr, length, MADV_HUGEPAGE);
+}
+
+/* Grows a mapping in place if the following addresses are free, otherwise moves its pages to a fresh aligned range *
+ * without copying them. Shrinking unmaps the tail, which returns its pages to the system                           */
+static void * resizeMapping(PageAllocatorT * pages, void * ptr, size_t old_length, size_t new_length)
+{
+	void * new_ptr = NULL, * target = NULL;
+	if (new_length < old_length)
+		munmap((char *)ptr + new_length, old_length - new_length);
+	else if (new_length > old_length)
+	{
+		new_ptr = mremap(ptr, old_length, new_length, 0);
+		if (new_ptr == MAP_FAILED)
+		{
+			target = mapAligned(pages, new_length);
+			if (target == NULL)
+				return NULL;
+			new_ptr = mremap(ptr, old_length, new_length, MREMAP_MAYMOVE | MREMAP_FIXED, target);
+			if (new_ptr == MAP_FAILED)
+			{
+				munmap(target, new_length);
+				return NULL;
+			}
+		}
+		ptr = new_ptr;
+		adviseMapping(pages, ptr, new_length);
+	}
+	if (new_length > old_length)
+		__atomic_add_fetch(&pages->mapped_size, new_length - old_length, __ATOMIC_RELAXED);
+	else
+		__atomic_sub_fetch(&pages->mapped_size, old_length - new_length, __ATOMIC_RELAXED);
+	return ptr;
+}
+
+static void * pagesAllocate(void * context, size_t size)
+{
+	PageAllocatorT * pages = (PageAllocatorT *)context;
+	void * ptr = NULL;
+	if (size < pages->threshold)
+		return malloc(size);
+	size = mappingLength(pages, size);
+	ptr = mapAligned(pages, size);
+	if (ptr == NULL)
+		return NULL;
+	adviseMapping(pages, ptr, size);
+	__atomic_add_fetch(&pages->mapped_size, size, __ATOMIC_RELAXED);
+	return ptr;
+}
+
+static void * pagesReallocate(void * context, void * ptr, size_t old_size, size_t new_size)
+{
+	PageAllocatorT * pages = (PageAllocatorT *)context;
+	void * new_ptr = NULL;
+	if (ptr == NULL)
+		return pagesAllocate(context, new_size);
+	if (old_size < pages->threshold && new_size < pages->threshold)
+		return realloc(ptr, new_size);
+	if (old_size >= pages->threshold && new_size >= pages->threshold)
+		return resizeMapping(pages, ptr, mappingLength(pages, old_size), mappingLength(pages, new_size));
+	new_ptr = pagesAllocate(context, new_size);
+	if (new_ptr == NULL)
+		return NULL;
+	memcpy(new_ptr, ptr, old_size < new_size ? old_size : new_size);
+	pagesDeallocate(context, ptr, old_size);
+	return new_ptr;
+}
+
+static void pagesDeallocate(void * context, void * ptr, size_t size)
+{
+	PageAllocatorT * pages = (PageAllocatorT *)context;
+	if (size < pages->threshold)
+	{
+		free(ptr);
+		return;
+	}
+	size = mappingLength(pages, size);
+	munmap(ptr, size);
+	__atomic_sub_fetch(&pages->mapped_size, size, __ATOMIC_RELAXED);
+}
+
+extern LSQ_PageAllocatorT LSQ_CreatePageAllocator(const LSQ_PageAllocatorOptionsT * options)
+{
+	PageAllocatorT * pages = (PageAllocatorT *)malloc(sizeof(PageAllocatorT));
+	if (pages == NULL)
+		return LSQ_PageAllocatorInvalid;
+	pages->threshold = (options == NULL || options->mapping_threshold == 0) ? PAGES_DEFAULT_THRESHOLD :
+		options->mapping_threshold;
+	pages->huge_pages = options != NULL && options->huge_pages;
+	pages->granularity = pages->huge_pages ? PAGES_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+	pages->mapped_size = 0;
+	pages->allocator.allocate = pagesAllocate;
+	pages->allocator.reallocate = pagesReallocate;
+	pages->allocator.deallocate = pagesDeallocate;
+	pages->allocator.context = pages;
+	pages->allocator.releases_in_bulk = 0;
+	return pages;
+}
+
+extern void LSQ_DestroyPageAllocator(LSQ_PageAllocatorT allocator)
+{
+	free(allocator);
+}
+
+extern const LSQ_AllocatorT * LSQ_GetPageAllocator(LSQ_PageAllocatorT allocator)
+{
+	return IS_HANDLE_INVALID(allocator) ? NULL : &((PageAllocatorT *)allocator)->allocator;
+}
+
+extern size_t LSQ_GetMappedSize(LSQ_PageAllocatorT allocator)
+{
+	PageAllocatorT * pages = (PageAllocatorT *)allocator;
+	return IS_HANDLE_INVALID(allocator) ? 0 : __atomic_load_n(&pages->mapped_size, __ATOMIC_RELAXED);
+}
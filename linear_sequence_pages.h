@@ -0,0 +1,32 @@
+#ifndef LINEAR_SEQUENCE_PAGES_H
+#define LINEAR_SEQUENCE_PAGES_H
+
+#include "linear_sequence_allocator.h"
+
+/* Allocator for very large element buffers on Linux. Buffers above a threshold are mapped straight from the       *
+ * system: they grow in place or are moved by remapping their pages instead of copying them, can be backed by       *
+ * transparent huge pages to cut TLB misses, and give the freed pages back to the system when they shrink. Smaller *
+ * allocations such as handles and iterators come from malloc. The allocator may be shared by threads.              */
+typedef void * LSQ_PageAllocatorT;
+
+#define LSQ_PageAllocatorInvalid NULL
+
+typedef struct
+{
+	/* Allocations of at least this many bytes are mapped. Zero selects the default of one megabyte */
+	size_t mapping_threshold;
+	/* Non-zero to align mapped buffers to huge pages and ask the kernel to back them with transparent huge pages */
+	int huge_pages;
+} LSQ_PageAllocatorOptionsT;
+
+/* Function that creates a page allocator. NULL options select the defaults */
+extern LSQ_PageAllocatorT LSQ_CreatePageAllocator(const LSQ_PageAllocatorOptionsT * options);
+/* Function that destroys the page allocator. Containers using it must be destroyed first */
+extern void LSQ_DestroyPageAllocator(LSQ_PageAllocatorT allocator);
+
+/* Function that returns the allocator table for LSQ_CreateSequenceWithAllocator */
+extern const LSQ_AllocatorT * LSQ_GetPageAllocator(LSQ_PageAllocatorT allocator);
+/* Function that returns the number of bytes currently mapped by the allocator */
+extern size_t LSQ_GetMappedSize(LSQ_PageAllocatorT allocator);
+
+#endif
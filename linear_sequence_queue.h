@@ -0,0 +1,34 @@
+#ifndef LINEAR_SEQUENCE_QUEUE_H
+#define LINEAR_SEQUENCE_QUEUE_H
+
+/* Bounded concurrent queue mode for linear_sequence_dyn_arrays.c. The element buffer becomes a ring of a power  *
+ * of two slots that producers and consumers on different threads use without locks. The single-producer mode is *
+ * wait-free and moves a batch with one atomic store; the multi-producer mode is lock-free, claims batches with   *
+ * one compare-and-swap and keeps a sequence number per slot. In queue mode only the functions of this header and *
+ * LSQ_GetSize, which is approximate under concurrent use, may be called; LSQ_StartQueueMode and                  *
+ * LSQ_StopQueueMode must not run concurrently with anything else on the handle. The header expects                *
+ * linear_sequence.h to be included first.                                                                        */
+
+typedef enum
+{
+	/* One producer thread and one consumer thread */
+	LSQ_QUEUE_SPSC,
+	/* Any number of producer and consumer threads */
+	LSQ_QUEUE_MPMC,
+} LSQ_QueueModeT;
+
+/* Function that turns the sequence into a queue of at least capacity slots, rounded up to a power of two, which *
+ * starts with the current elements front first. Returns 0 if memory ran out or the handle already is a queue    */
+extern int LSQ_StartQueueMode(LSQ_HandleT handle, LSQ_IntegerIndexT capacity, LSQ_QueueModeT mode);
+/* Function that turns the queue back into a sequence of the queued elements, front first */
+extern void LSQ_StopQueueMode(LSQ_HandleT handle);
+/* Function that appends an element at the rear. Returns 0 if the queue is full */
+extern int LSQ_TryEnqueue(LSQ_HandleT handle, LSQ_BaseTypeT element);
+/* Function that removes the front element into element. Returns 0 if the queue is empty */
+extern int LSQ_TryDequeue(LSQ_HandleT handle, LSQ_BaseTypeT * element);
+/* Function that appends up to count elements in order and returns how many fitted */
+extern LSQ_IntegerIndexT LSQ_EnqueueBatch(LSQ_HandleT handle, const LSQ_BaseTypeT * elements, LSQ_IntegerIndexT count);
+/* Function that removes up to count front elements into elements and returns how many were removed */
+extern LSQ_IntegerIndexT LSQ_DequeueBatch(LSQ_HandleT handle, LSQ_BaseTypeT * elements, LSQ_IntegerIndexT count);
+
+#endif
@@ -0,0 +1,226 @@
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "linear_sequence.h"
+#include "linear_sequence_queue.h"
+
+/* Multi-threaded stress test for the queue mode of linear_sequence_dyn_arrays.c. Producers enqueue numbered items *
+ * in batches and consumers dequeue them in batches; every consumer checks that the items of each producer reach   *
+ * it in order, and at the end every item must have been dequeued exactly once. The queue starts from a sequence   *
+ * whose elements must come out first; after the threaded part it is filled past its wrap-around point and turned  *
+ * back into a sequence, which must hold the queued elements front first. Build it with a sanitizer:               *
+ *     cc -O1 -g -fsanitize=thread -pthread linear_sequence_queue_stress.c linear_sequence_dyn_arrays.c -o stress  *
+ *     cc -O1 -g -fsanitize=address -pthread linear_sequence_queue_stress.c linear_sequence_dyn_arrays.c -o stress *
+ * Usage: stress [spsc | mpmc] [producers] [consumers] [items per producer] [batch] [capacity]                     *
+ * SPSC mode takes exactly one producer and one consumer. The exit status is 0 if no check failed.                 */
+
+#define STRESS_MAX_BATCH 256
+
+typedef struct
+{
+	int thread_id;
+	int items;
+	int batch;
+	long long errors;
+} StressArgsT;
+
+static LSQ_HandleT queue_handle = LSQ_HandleInvalid;
+static int producers = 0;
+static long long total_items = 0;
+static long long dequeued_items = 0;
+/* Number of times each item was dequeued, indexed by the item */
+static unsigned char * dequeue_counts = NULL;
+
+static double elapsedSeconds(const struct timespec * start, const struct timespec * finish)
+{
+	return (finish->tv_sec - start->tv_sec) + (finish->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Item number i of a producer is i * producers plus the producer number */
+static void * runProducer(void * arg)
+{
+	StressArgsT * args = (StressArgsT *)arg;
+	LSQ_BaseTypeT items[STRESS_MAX_BATCH];
+	LSQ_IntegerIndexT count, done;
+	int i, j;
+	for (i = 0; i < args->items; i += count)
+	{
+		count = (args->items - i < args->batch) ? args->items - i : args->batch;
+		for (j = 0; j < count; j++)
+			items[j] = (i + j) * producers + args->thread_id;
+		for (done = 0; done < count;)
+		{
+			LSQ_IntegerIndexT enqueued = (count - done == 1) ? LSQ_TryEnqueue(queue_handle, items[done]) :
+				LSQ_EnqueueBatch(queue_handle, items + done, count - done);
+			done += enqueued;
+			if (enqueued == 0)
+				sched_yield();
+		}
+	}
+	return NULL;
+}
+
+static void * runConsumer(void * arg)
+{
+	StressArgsT * args = (StressArgsT *)arg;
+	LSQ_BaseTypeT items[STRESS_MAX_BATCH];
+	LSQ_IntegerIndexT count;
+	int * last_seen = (int *)malloc(producers * sizeof(int));
+	int i, producer;
+	if (last_seen == NULL)
+	{
+		args->errors++;
+		return NULL;
+	}
+	for (i = 0; i < producers; i++)
+		last_seen[i] = -1;
+	while (__atomic_load_n(&dequeued_items, __ATOMIC_RELAXED) < total_items)
+	{
+		count = (args->batch == 1) ? LSQ_TryDequeue(queue_handle, items) :
+			LSQ_DequeueBatch(queue_handle, items, args->batch);
+		if (count == 0)
+		{
+			sched_yield();
+			continue;
+		}
+		for (i = 0; i < count; i++)
+		{
+			if (items[i] < 0 || items[i] >= total_items)
+			{
+				if (args->errors++ < 10)
+					fprintf(stderr, "consumer %d: item %d was never enqueued\n", args->thread_id, items[i]);
+				continue;
+			}
+			producer = items[i] % producers;
+			if (items[i] / producers <= last_seen[producer] && args->errors++ < 10)
+				fprintf(stderr, "consumer %d: item %d of producer %d after item %d\n", args->thread_id,
+					items[i] / producers, producer, last_seen[producer]);
+			last_seen[producer] = items[i] / producers;
+			if (__atomic_fetch_add(&dequeue_counts[items[i]], 1, __ATOMIC_RELAXED) != 0 && args->errors++ < 10)
+				fprintf(stderr, "consumer %d: item %d dequeued twice\n", args->thread_id, items[i]);
+		}
+		__atomic_add_fetch(&dequeued_items, count, __ATOMIC_RELAXED);
+	}
+	free(last_seen);
+	return NULL;
+}
+
+/* Fills the empty queue of capacity slots past its wrap-around point from a single thread, stops the queue mode *
+ * and checks the sequence                                                                                       */
+static long long checkWrapAndStop(LSQ_IntegerIndexT capacity)
+{
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_BaseTypeT item = 0;
+	long long errors = 0;
+	int i, size;
+	for (i = 0; i < capacity / 2; i++)
+		errors += !LSQ_TryEnqueue(queue_handle, i);
+	for (i = 0; i < capacity / 2; i++)
+		errors += !LSQ_TryDequeue(queue_handle, &item) || item != i;
+	for (i = 0; i < capacity - 1; i++)
+		errors += !LSQ_TryEnqueue(queue_handle, capacity + i);
+	if (errors != 0)
+		fprintf(stderr, "single-threaded enqueue or dequeue failed\n");
+	size = LSQ_GetSize(queue_handle);
+	LSQ_StopQueueMode(queue_handle);
+	if (size != capacity - 1 || LSQ_GetSize(queue_handle) != size)
+	{
+		fprintf(stderr, "queue of %d elements became a sequence of %d\n", size, LSQ_GetSize(queue_handle));
+		return errors + 1;
+	}
+	iterator = LSQ_GetFrontElement(queue_handle);
+	for (i = 0; i < size && LSQ_IsIteratorDereferencable(iterator); i++)
+	{
+		if (*LSQ_DereferenceIterator(iterator) != capacity + i && errors++ < 10)
+			fprintf(stderr, "sequence element %d is %d after stopping the queue\n", i, *LSQ_DereferenceIterator(iterator));
+		LSQ_AdvanceOneElement(iterator);
+	}
+	LSQ_DestroyIterator(iterator);
+	return errors;
+}
+
+int main(int argc, char ** argv)
+{
+	LSQ_QueueModeT mode = (argc > 1 && strcmp(argv[1], "spsc") == 0) ? LSQ_QUEUE_SPSC : LSQ_QUEUE_MPMC;
+	int consumers = (argc > 3) ? atoi(argv[3]) : (mode == LSQ_QUEUE_SPSC) ? 1 : 4;
+	int items = (argc > 4) ? atoi(argv[4]) : 1000000;
+	int batch = (argc > 5) ? atoi(argv[5]) : 16;
+	int capacity = (argc > 6) ? atoi(argv[6]) : 1024;
+	pthread_t * thread_ids = NULL;
+	StressArgsT * args = NULL;
+	struct timespec start, finish;
+	LSQ_BaseTypeT item = 0;
+	long long errors = 0, i;
+	int threads, slots = 1;
+
+	producers = (argc > 2) ? atoi(argv[2]) : (mode == LSQ_QUEUE_SPSC) ? 1 : 4;
+	threads = producers + consumers;
+	if (producers < 1 || consumers < 1 || items < 1 || batch < 1 || batch > STRESS_MAX_BATCH || capacity < 2 ||
+		capacity > (1 << 24) || (mode == LSQ_QUEUE_SPSC && threads != 2) || (long long)items * producers > 0x7fffffff)
+	{
+		fprintf(stderr, "usage: %s [spsc | mpmc] [producers] [consumers] [items per producer] [batch] [capacity]\n",
+			argv[0]);
+		return 1;
+	}
+	/* The queue rounds its capacity up to a power of two; the wrap-around check needs the exact number of slots */
+	while (slots < capacity)
+		slots <<= 1;
+	total_items = (long long)items * producers;
+	queue_handle = LSQ_CreateSequence();
+	dequeue_counts = (unsigned char *)calloc(total_items, 1);
+	thread_ids = (pthread_t *)malloc(threads * sizeof(pthread_t));
+	args = (StressArgsT *)malloc(threads * sizeof(StressArgsT));
+	if (queue_handle == LSQ_HandleInvalid || dequeue_counts == NULL || thread_ids == NULL || args == NULL)
+		return 1;
+
+	/* The elements of the sequence come out of the queue first */
+	for (i = 0; i < 5; i++)
+		LSQ_InsertRearElement(queue_handle, -1 - (int)i);
+	if (!LSQ_StartQueueMode(queue_handle, slots, mode))
+		return 1;
+	for (i = 0; i < 5; i++)
+		errors += !LSQ_TryDequeue(queue_handle, &item) || item != -1 - i;
+	errors += LSQ_TryDequeue(queue_handle, &item);
+	if (errors != 0)
+		fprintf(stderr, "the queue did not start with the elements of the sequence\n");
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < threads; i++)
+	{
+		args[i].thread_id = (i < producers) ? (int)i : (int)i - producers;
+		args[i].items = items;
+		args[i].batch = batch;
+		args[i].errors = 0;
+		pthread_create(&thread_ids[i], NULL, (i < producers) ? runProducer : runConsumer, &args[i]);
+	}
+	for (i = 0; i < threads; i++)
+	{
+		pthread_join(thread_ids[i], NULL);
+		errors += args[i].errors;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+
+	for (i = 0; i < total_items; i++)
+	{
+		if (dequeue_counts[i] != 1 && errors++ < 10)
+			fprintf(stderr, "item %lld was dequeued %d times\n", i, dequeue_counts[i]);
+	}
+	if (LSQ_TryDequeue(queue_handle, &item))
+	{
+		fprintf(stderr, "the queue holds item %d after all were dequeued\n", item);
+		errors++;
+	}
+	errors += checkWrapAndStop(slots);
+
+	printf("%s, producers %d, consumers %d, batch %d, items %lld, %.0f items/s, errors %lld\n",
+		mode == LSQ_QUEUE_SPSC ? "spsc" : "mpmc", producers, consumers, batch, total_items,
+		total_items / elapsedSeconds(&start, &finish), errors);
+	LSQ_DestroySequence(queue_handle);
+	free(dequeue_counts);
+	free(thread_ids);
+	free(args);
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#ifdef LSQ_TRACE_ASSOC
+#include "linear_sequence_assoc.h"
+#else
+#include "linear_sequence.h"
+#endif
+#include "linear_sequence_trace.h"
+
+/* Replays a trace written by linear_sequence_trace.c against the backend the driver is linked with, as fast as *
+ * possible, and prints latency percentiles per operation. Build it once per backend:                            *
+ *     cc -O2 linear_sequence_replay.c linear_sequence_rope.c -o replay_rope                                    *
+ *     cc -O2 -DLSQ_TRACE_ASSOC linear_sequence_replay.c avl_tree.c -o replay_avl_tree                          *
+ * Usage: replay trace_file                                                                                      *
+ * Every call is timed separately, so latencies include about one clock read. Records on objects created while  *
+ * tracing was off are skipped.                                                                                  */
+
+#define REPLAY_BATCH_RECORDS 4096
+
+typedef struct
+{
+	unsigned int * samples;
+	size_t count;
+	size_t capacity;
+} LatencyListT;
+
+static const char * operation_names[LSQ_TRACE_OPERATION_COUNT] =
+{
+	"CreateSequence", "DestroySequence", "GetSize", "DereferenceIterator", "GetIteratorKey",
+	"GetElementByIndex", "GetFrontElement", "GetPastRearElement", "DestroyIterator",
+	"AdvanceOneElement", "RewindOneElement", "ShiftPosition", "SetPosition", "InsertElement",
+	"InsertFrontElement", "InsertRearElement", "InsertElementBeforeGiven", "DeleteFrontElement",
+	"DeleteRearElement", "DeleteElement", "DeleteGivenElement",
+};
+
+static LatencyListT latencies[LSQ_TRACE_OPERATION_COUNT];
+static void ** objects = NULL;
+static size_t object_capacity = 0;
+static long long checksum = 0;
+
+static unsigned long long currentTimestamp(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+}
+
+static int compareSamples(const void * first, const void * second)
+{
+	unsigned int a = *(const unsigned int *)first, b = *(const unsigned int *)second;
+	return (a > b) - (a < b);
+}
+
+static void addSample(LatencyListT * list, unsigned long long sample)
+{
+	unsigned int * samples = NULL;
+	if (list->count == list->capacity)
+	{
+		samples = (unsigned int *)realloc(list->samples, (list->capacity * 2 + 64) * sizeof(unsigned int));
+		if (samples == NULL)
+			return;
+		list->samples = samples;
+		list->capacity = list->capacity * 2 + 64;
+	}
+	list->samples[list->count++] = (sample > 0xFFFFFFFFull) ? 0xFFFFFFFFu : (unsigned int)sample;
+}
+
+static void * findObject(unsigned int id)
+{
+	return (id < object_capacity) ? objects[id] : NULL;
+}
+
+static void storeObject(unsigned int id, void * object)
+{
+	void ** grown = NULL;
+	size_t capacity = object_capacity;
+	if (id == 0)
+		return;
+	if (id >= object_capacity)
+	{
+		while (capacity <= id)
+			capacity = capacity * 2 + 64;
+		grown = (void **)realloc(objects, capacity * sizeof(void *));
+		if (grown == NULL)
+			return;
+		memset(grown + object_capacity, 0, (capacity - object_capacity) * sizeof(void *));
+		objects = grown;
+		object_capacity = capacity;
+	}
+	objects[id] = object;
+}
+
+/* Performs one call and returns 0 if it refers to an unknown object */
+static int replayRecord(const LSQ_TraceRecordT * record)
+{
+	void * object = findObject(record->object);
+	LSQ_BaseTypeT * value = NULL;
+	if (object == NULL && record->operation != LSQ_TRACE_CREATE_SEQUENCE)
+		return 0;
+	switch (record->operation)
+	{
+	case LSQ_TRACE_CREATE_SEQUENCE:
+		storeObject(record->result, LSQ_CreateSequence());
+		break;
+	case LSQ_TRACE_DESTROY_SEQUENCE:
+		LSQ_DestroySequence(object);
+		storeObject(record->object, NULL);
+		break;
+	case LSQ_TRACE_GET_SIZE:
+		checksum += LSQ_GetSize(object);
+		break;
+	case LSQ_TRACE_DEREFERENCE_ITERATOR:
+		value = LSQ_DereferenceIterator(object);
+		if (value != NULL)
+			checksum += *value;
+		break;
+	case LSQ_TRACE_GET_ELEMENT_BY_INDEX:
+		storeObject(record->result, LSQ_GetElementByIndex(object, record->argument));
+		break;
+	case LSQ_TRACE_GET_FRONT_ELEMENT:
+		storeObject(record->result, LSQ_GetFrontElement(object));
+		break;
+	case LSQ_TRACE_GET_PAST_REAR_ELEMENT:
+		storeObject(record->result, LSQ_GetPastRearElement(object));
+		break;
+	case LSQ_TRACE_DESTROY_ITERATOR:
+		LSQ_DestroyIterator(object);
+		storeObject(record->object, NULL);
+		break;
+	case LSQ_TRACE_ADVANCE_ONE_ELEMENT:
+		LSQ_AdvanceOneElement(object);
+		break;
+	case LSQ_TRACE_REWIND_ONE_ELEMENT:
+		LSQ_RewindOneElement(object);
+		break;
+	case LSQ_TRACE_SHIFT_POSITION:
+		LSQ_ShiftPosition(object, record->argument);
+		break;
+	case LSQ_TRACE_SET_POSITION:
+		LSQ_SetPosition(object, record->argument);
+		break;
+	case LSQ_TRACE_DELETE_FRONT_ELEMENT:
+		LSQ_DeleteFrontElement(object);
+		break;
+	case LSQ_TRACE_DELETE_REAR_ELEMENT:
+		LSQ_DeleteRearElement(object);
+		break;
+#ifdef LSQ_TRACE_ASSOC
+	case LSQ_TRACE_GET_ITERATOR_KEY:
+		if (LSQ_IsIteratorDereferencable(object))
+			checksum += LSQ_GetIteratorKey(object);
+		break;
+	case LSQ_TRACE_INSERT_ELEMENT:
+		LSQ_InsertElement(object, record->argument, (LSQ_BaseTypeT)record->value);
+		break;
+	case LSQ_TRACE_DELETE_ELEMENT:
+		LSQ_DeleteElement(object, record->argument);
+		break;
+#else
+	case LSQ_TRACE_INSERT_FRONT_ELEMENT:
+		LSQ_InsertFrontElement(object, (LSQ_BaseTypeT)record->value);
+		break;
+	case LSQ_TRACE_INSERT_REAR_ELEMENT:
+		LSQ_InsertRearElement(object, (LSQ_BaseTypeT)record->value);
+		break;
+	case LSQ_TRACE_INSERT_ELEMENT_BEFORE_GIVEN:
+		LSQ_InsertElementBeforeGiven(object, (LSQ_BaseTypeT)record->value);
+		break;
+	case LSQ_TRACE_DELETE_GIVEN_ELEMENT:
+		LSQ_DeleteGivenElement(object);
+		break;
+#endif
+	default:
+		return 0;
+	}
+	return 1;
+}
+
+static void printPercentiles(void)
+{
+	static const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+	LatencyListT * list = NULL;
+	size_t i, j;
+	printf("%-26s %10s %8s %8s %8s %8s %10s\n", "operation", "calls", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns");
+	for (i = 0; i < LSQ_TRACE_OPERATION_COUNT; i++)
+	{
+		list = &latencies[i];
+		if (list->count == 0)
+			continue;
+		qsort(list->samples, list->count, sizeof(unsigned int), compareSamples);
+		printf("%-26s %10lu", operation_names[i], (unsigned long)list->count);
+		for (j = 0; j < sizeof(percentiles) / sizeof(percentiles[0]); j++)
+			printf(" %8u", list->samples[(size_t)(percentiles[j] * (list->count - 1))]);
+		printf(" %10u\n", list->samples[list->count - 1]);
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	LSQ_TraceHeaderT header;
+	LSQ_TraceRecordT * records = NULL;
+	FILE * trace_file = NULL;
+	unsigned long long start, finish, total = 0;
+	size_t count, i, replayed = 0, skipped = 0;
+#ifdef LSQ_TRACE_ASSOC
+	unsigned int is_associative = 1;
+#else
+	unsigned int is_associative = 0;
+#endif
+
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: %s trace_file\n", argv[0]);
+		return 1;
+	}
+	trace_file = fopen(argv[1], "rb");
+	if (trace_file == NULL || fread(&header, sizeof(header), 1, trace_file) != 1 ||
+		memcmp(header.magic, "LSQT", 4) != 0 || header.version != LSQ_TRACE_VERSION ||
+		header.record_size != sizeof(LSQ_TraceRecordT))
+	{
+		fprintf(stderr, "%s: not a version %d trace file\n", argv[1], LSQ_TRACE_VERSION);
+		return 1;
+	}
+	if (header.is_associative != is_associative)
+	{
+		fprintf(stderr, "%s: trace of the %s API, rebuild the driver %s LSQ_TRACE_ASSOC\n", argv[1],
+			header.is_associative ? "associative" : "sequence", header.is_associative ? "with" : "without");
+		return 1;
+	}
+	records = (LSQ_TraceRecordT *)malloc(REPLAY_BATCH_RECORDS * sizeof(LSQ_TraceRecordT));
+	if (records == NULL)
+		return 1;
+
+	while ((count = fread(records, sizeof(LSQ_TraceRecordT), REPLAY_BATCH_RECORDS, trace_file)) > 0)
+	{
+		for (i = 0; i < count; i++)
+		{
+			start = currentTimestamp();
+			if (!replayRecord(&records[i]))
+			{
+				skipped++;
+				continue;
+			}
+			finish = currentTimestamp();
+			addSample(&latencies[records[i].operation], finish - start);
+			total += finish - start;
+			replayed++;
+		}
+	}
+	fclose(trace_file);
+
+	printPercentiles();
+	printf("replayed %lu calls in %.3f s, skipped %lu, checksum %lld\n",
+		(unsigned long)replayed, total / 1e9, (unsigned long)skipped, checksum);
+	for (i = 0; i < LSQ_TRACE_OPERATION_COUNT; i++)
+		free(latencies[i].samples);
+	free(objects);
+	free(records);
+	return 0;
+}
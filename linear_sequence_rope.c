@@ -0,0 +1,519 @@
+#include <string.h>
+#include <stdlib.h>
+#include "linear_sequence.h"
+#include "linear_sequence_allocator.h"
+#include "linear_sequence_rope.h"
+#include "linear_sequence_span.h"
+
+/* Rope: a treap with implicit keys whose nodes hold chunks of up to ROPE_CHUNK_CAPACITY elements. Each node   *
+ * stores the number of elements in its subtree, so positions are found by descending from the root, and      *
+ * indexed access, insertion and deletion take O(log n) expected time. A full chunk is split in two before an  *
+ * insertion and an emptied chunk is unlinked. Iterators hold an index plus a cached chunk, so sequential      *
+ * access touches the tree once per chunk; the cache is dropped whenever the tree changes.                     */
+
+#define IS_HANDLE_INVALID(handle)(handle == LSQ_HandleInvalid)
+#define ROPE_CHUNK_CAPACITY 64
+#define ROPE_SEED 2463534242u
+
+typedef enum
+{
+	BEFOREFIRST,
+	DEREFERENCABLE,
+	PASTREAR,
+} IteratorStateT;
+
+typedef struct RopeNodeStruct
+{
+	struct RopeNodeStruct * l_child;
+	struct RopeNodeStruct * r_child;
+	unsigned int priority;
+	/* Number of elements in the subtree and in this node's chunk */
+	int size;
+	int count;
+	LSQ_BaseTypeT data[ROPE_CHUNK_CAPACITY];
+} RopeNodeT;
+
+typedef struct
+{
+	RopeNodeT * root;
+	unsigned int seed;
+	/* Incremented by every change of the tree shape or chunk contents */
+	unsigned int version;
+	const LSQ_AllocatorT * allocator;
+} RopeDataT;
+
+typedef struct
+{
+	RopeDataT * rope_data;
+	IteratorStateT state;
+	LSQ_IntegerIndexT index;
+	RopeNodeT * chunk;
+	LSQ_IntegerIndexT chunk_start;
+	unsigned int version;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static __inline int subtreeSize(const RopeNodeT * node);
+static __inline void updateSize(RopeNodeT * node);
+static unsigned int nextPriority(RopeDataT * rope_data);
+static RopeNodeT * createNode(RopeDataT * rope_data);
+static void destroySubtree(RopeDataT * rope_data, RopeNodeT * node);
+static RopeNodeT * mergeTrees(RopeNodeT * left, RopeNodeT * right);
+static void splitTree(RopeNodeT * node, int index, RopeNodeT ** left, RopeNodeT ** right, RopeNodeT ** spare);
+static int splitAt(RopeDataT * rope_data, int index, RopeNodeT ** left, RopeNodeT ** right);
+static RopeNodeT * findChunk(RopeNodeT * node, int index, int * chunk_start);
+static int insertIntoChunk(RopeNodeT * node, int index, LSQ_BaseTypeT value);
+static void eraseFromChunk(RopeDataT * rope_data, RopeNodeT ** node_ptr, int index);
+static LSQ_IteratorT createIterator(LSQ_HandleT handle);
+
+static __inline int subtreeSize(const RopeNodeT * node)
+{
+	return (node == NULL) ? 0 : node->size;
+}
+
+static __inline void updateSize(RopeNodeT * node)
+{
+	node->size = subtreeSize(node->l_child) + node->count + subtreeSize(node->r_child);
+}
+
+static unsigned int nextPriority(RopeDataT * rope_data)
+{
+	unsigned int x = rope_data->seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rope_data->seed = x;
+	return x;
+}
+
+static RopeNodeT * createNode(RopeDataT * rope_data)
+{
+	RopeNodeT * node = (RopeNodeT *)lsqAllocate(rope_data->allocator, sizeof(RopeNodeT));
+	if (node == NULL)
+		return NULL;
+	node->l_child = NULL;
+	node->r_child = NULL;
+	node->priority = nextPriority(rope_data);
+	node->size = 0;
+	node->count = 0;
+	return node;
+}
+
+static void destroySubtree(RopeDataT * rope_data, RopeNodeT * node)
+{
+	RopeNodeT * right = NULL;
+	while (node != NULL)
+	{
+		destroySubtree(rope_data, node->l_child);
+		right = node->r_child;
+		lsqDeallocate(rope_data->allocator, node, sizeof(RopeNodeT));
+		node = right;
+	}
+}
+
+/* Concatenates two treaps, every element of left goes before every element of right */
+static RopeNodeT * mergeTrees(RopeNodeT * left, RopeNodeT * right)
+{
+	if (left == NULL)
+		return right;
+	if (right == NULL)
+		return left;
+	if (left->priority >= right->priority)
+	{
+		left->r_child = mergeTrees(left->r_child, right);
+		updateSize(left);
+		return left;
+	}
+	right->l_child = mergeTrees(left, right->l_child);
+	updateSize(right);
+	return right;
+}
+
+/* Splits the treap into the first index elements and the rest. A chunk that straddles the index is cut, *
+ * moving its tail into *spare, which is set to NULL once used.                                           */
+static void splitTree(RopeNodeT * node, int index, RopeNodeT ** left, RopeNodeT ** right, RopeNodeT ** spare)
+{
+	RopeNodeT * tail = NULL;
+	int l_size, offset;
+	if (node == NULL)
+	{
+		*left = *right = NULL;
+		return;
+	}
+	l_size = subtreeSize(node->l_child);
+	if (index <= l_size)
+	{
+		splitTree(node->l_child, index, left, &node->l_child, spare);
+		updateSize(node);
+		*right = node;
+		return;
+	}
+	if (index >= l_size + node->count)
+	{
+		splitTree(node->r_child, index - l_size - node->count, &node->r_child, right, spare);
+		updateSize(node);
+		*left = node;
+		return;
+	}
+	offset = index - l_size;
+	tail = *spare;
+	*spare = NULL;
+	tail->count = node->count - offset;
+	memcpy(tail->data, node->data + offset, tail->count * sizeof(LSQ_BaseTypeT));
+	updateSize(tail);
+	node->count = offset;
+	*right = mergeTrees(tail, node->r_child);
+	node->r_child = NULL;
+	updateSize(node);
+	*left = node;
+}
+
+/* Splits the whole rope at index. Returns 0 without changes if the chunk to be cut cannot be allocated */
+static int splitAt(RopeDataT * rope_data, int index, RopeNodeT ** left, RopeNodeT ** right)
+{
+	RopeNodeT * spare = createNode(rope_data);
+	if (spare == NULL)
+		return 0;
+	splitTree(rope_data->root, index, left, right, &spare);
+	if (spare != NULL)
+		lsqDeallocate(rope_data->allocator, spare, sizeof(RopeNodeT));
+	rope_data->root = NULL;
+	rope_data->version++;
+	return 1;
+}
+
+/* Returns the node whose chunk holds the element at index and the index of the first element of that chunk */
+static RopeNodeT * findChunk(RopeNodeT * node, int index, int * chunk_start)
+{
+	int l_size;
+	*chunk_start = 0;
+	while (node != NULL)
+	{
+		l_size = subtreeSize(node->l_child);
+		if (index < l_size)
+		{
+			node = node->l_child;
+			continue;
+		}
+		index -= l_size;
+		*chunk_start += l_size;
+		if (index < node->count)
+			return node;
+		index -= node->count;
+		*chunk_start += node->count;
+		node = node->r_child;
+	}
+	return NULL;
+}
+
+/* Inserts the value before the element at index, or at the end for index == size. An index on a chunk       *
+ * boundary may go to either neighbouring chunk, a full one is avoided. Returns 0 without changes if both are *
+ * full                                                                                                       */
+static int insertIntoChunk(RopeNodeT * node, int index, LSQ_BaseTypeT value)
+{
+	int l_size = subtreeSize(node->l_child), is_full = node->count == ROPE_CHUNK_CAPACITY, inserted;
+	if (index < l_size || (index == l_size && is_full && node->l_child != NULL))
+		inserted = insertIntoChunk(node->l_child, index, value);
+	else if (index > l_size + node->count || (index == l_size + node->count && is_full && node->r_child != NULL))
+		inserted = insertIntoChunk(node->r_child, index - l_size - node->count, value);
+	else if (is_full)
+		inserted = 0;
+	else
+	{
+		index -= l_size;
+		memmove(node->data + index + 1, node->data + index, (node->count - index) * sizeof(LSQ_BaseTypeT));
+		node->data[index] = value;
+		node->count++;
+		inserted = 1;
+	}
+	if (inserted)
+		node->size++;
+	return inserted;
+}
+
+static void eraseFromChunk(RopeDataT * rope_data, RopeNodeT ** node_ptr, int index)
+{
+	RopeNodeT * node = *node_ptr;
+	int l_size = subtreeSize(node->l_child);
+	node->size--;
+	if (index < l_size)
+	{
+		eraseFromChunk(rope_data, &node->l_child, index);
+		return;
+	}
+	index -= l_size;
+	if (index >= node->count)
+	{
+		eraseFromChunk(rope_data, &node->r_child, index - node->count);
+		return;
+	}
+	memmove(node->data + index, node->data + index + 1, (node->count - index - 1) * sizeof(LSQ_BaseTypeT));
+	node->count--;
+	if (node->count > 0)
+		return;
+	*node_ptr = mergeTrees(node->l_child, node->r_child);
+	lsqDeallocate(rope_data->allocator, node, sizeof(RopeNodeT));
+}
+
+static LSQ_IteratorT createIterator(LSQ_HandleT handle)
+{
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(((RopeDataT *)handle)->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = ((RopeDataT *)handle)->allocator;
+	iterator->rope_data = (RopeDataT *)handle;
+	iterator->chunk = NULL;
+	iterator->chunk_start = 0;
+	iterator->version = 0;
+	return iterator;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	RopeDataT * rope_data = (RopeDataT *)lsqAllocate(allocator, sizeof(RopeDataT));
+	if (rope_data == NULL)
+		return LSQ_HandleInvalid;
+	rope_data->allocator = allocator;
+	rope_data->root = NULL;
+	rope_data->seed = ROPE_SEED;
+	rope_data->version = 0;
+	return rope_data;
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	RopeDataT * rope_data = (RopeDataT *)handle;
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(rope_data->allocator))
+		return;
+	destroySubtree(rope_data, rope_data->root);
+	lsqDeallocate(rope_data->allocator, rope_data, sizeof(RopeDataT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return (IS_HANDLE_INVALID(handle)) ? -1 : subtreeSize(((RopeDataT *)handle)->root);
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == DEREFERENCABLE));
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == PASTREAR));
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	return (!IS_HANDLE_INVALID(iterator) && (((IteratorT *)iterator)->state == BEFOREFIRST));
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	int is_cache_valid;
+	if (!LSQ_IsIteratorDereferencable(iterator) || iter->index >= LSQ_GetSize(iter->rope_data))
+		return LSQ_HandleInvalid;
+	is_cache_valid = iter->chunk != NULL && iter->version == iter->rope_data->version &&
+		iter->index >= iter->chunk_start && iter->index < iter->chunk_start + iter->chunk->count;
+	if (!is_cache_valid)
+	{
+		iter->chunk = findChunk(iter->rope_data->root, iter->index, &iter->chunk_start);
+		iter->version = iter->rope_data->version;
+	}
+	return iter->chunk->data + (iter->index - iter->chunk_start);
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	IteratorT * iter = NULL;
+	if IS_HANDLE_INVALID(handle)
+		return LSQ_HandleInvalid;
+	iter = (IteratorT *)createIterator(handle);
+	if (iter == NULL)
+		return LSQ_HandleInvalid;
+	iter->index = 0;
+	LSQ_ShiftPosition(iter, index);
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	return LSQ_GetElementByIndex(handle, 0);
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? LSQ_HandleInvalid : LSQ_GetElementByIndex(handle, LSQ_GetSize(handle));
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	LSQ_ShiftPosition(iterator, 1);
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	LSQ_ShiftPosition(iterator, -1);
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	IteratorT * iter = NULL;
+	int size;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter = (IteratorT *)iterator;
+	size = LSQ_GetSize(iter->rope_data);
+	iter->index += shift;
+	iter->state = DEREFERENCABLE;
+	if (iter->index >= size)
+	{
+		iter->state = PASTREAR;
+		iter->index = size;
+	}
+	if (iter->index < 0)
+	{
+		iter->state = BEFOREFIRST;
+		iter->index = -1;
+	}
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	LSQ_ShiftPosition(iterator, pos - ((IteratorT *)iterator)->index);
+}
+
+extern void LSQ_InsertFrontElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	LSQ_IteratorT iterator = LSQ_GetElementByIndex(handle, 0);
+	LSQ_InsertElementBeforeGiven(iterator, element);
+	LSQ_DestroyIterator(iterator);
+}
+
+extern void LSQ_InsertRearElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	LSQ_IteratorT iterator = LSQ_GetPastRearElement(handle);
+	LSQ_InsertElementBeforeGiven(iterator, element);
+	LSQ_DestroyIterator(iterator);
+}
+
+extern void LSQ_InsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT newElement)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	RopeDataT * rope_data = NULL;
+	RopeNodeT * chunk = NULL, * left = NULL, * right = NULL;
+	int index, chunk_start;
+	if (IS_HANDLE_INVALID(iterator) || LSQ_IsIteratorBeforeFirst(iterator))
+		return;
+	rope_data = iter->rope_data;
+	index = iter->index;
+	rope_data->version++;
+	if (rope_data->root == NULL)
+	{
+		rope_data->root = createNode(rope_data);
+		if (rope_data->root == NULL)
+			return;
+	}
+	if (insertIntoChunk(rope_data->root, index, newElement))
+		return;
+	/* The target chunk is full: cut it in half and retry, one of the halves now has room */
+	chunk = findChunk(rope_data->root, (index < LSQ_GetSize(rope_data)) ? index : index - 1, &chunk_start);
+	if (!splitAt(rope_data, chunk_start + chunk->count / 2, &left, &right))
+		return;
+	rope_data->root = mergeTrees(left, right);
+	insertIntoChunk(rope_data->root, index, newElement);
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	LSQ_IteratorT iterator = LSQ_GetFrontElement(handle);
+	LSQ_DeleteGivenElement(iterator);
+	LSQ_DestroyIterator(iterator);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	LSQ_IteratorT iterator = LSQ_GetPastRearElement(handle);
+	LSQ_RewindOneElement(iterator);
+	LSQ_DeleteGivenElement(iterator);
+	LSQ_DestroyIterator(iterator);
+}
+
+extern void LSQ_DeleteGivenElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator) || iter->index >= LSQ_GetSize(iter->rope_data))
+		return;
+	iter->rope_data->version++;
+	eraseFromChunk(iter->rope_data, &iter->rope_data->root, iter->index);
+	if (iter->index >= LSQ_GetSize(iter->rope_data))
+		iter->state = PASTREAR;
+}
+
+extern LSQ_HandleT LSQ_SplitSequence(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	RopeDataT * rope_data = (RopeDataT *)handle, * tail = NULL;
+	RopeNodeT * left = NULL, * right = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	tail = (RopeDataT *)LSQ_CreateSequenceWithAllocator(rope_data->allocator);
+	if (tail == NULL)
+		return LSQ_HandleInvalid;
+	if (index < 0)
+		index = 0;
+	if (index >= LSQ_GetSize(handle))
+		return tail;
+	if (!splitAt(rope_data, index, &left, &right))
+	{
+		LSQ_DestroySequence(tail);
+		return LSQ_HandleInvalid;
+	}
+	rope_data->root = left;
+	tail->root = right;
+	tail->seed = nextPriority(rope_data);
+	return tail;
+}
+
+extern void LSQ_ConcatenateSequences(LSQ_HandleT handle, LSQ_HandleT other)
+{
+	RopeDataT * rope_data = (RopeDataT *)handle, * other_data = (RopeDataT *)other;
+	if (IS_HANDLE_INVALID(handle) || IS_HANDLE_INVALID(other) || handle == other)
+		return;
+	rope_data->root = mergeTrees(rope_data->root, other_data->root);
+	other_data->root = NULL;
+	rope_data->version++;
+	other_data->version++;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSpan(LSQ_IteratorT iterator, LSQ_BaseTypeT ** span)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(span))
+		return 0;
+	*span = LSQ_DereferenceIterator(iterator);
+	return (*span == NULL) ? 0 : iter->chunk_start + iter->chunk->count - iter->index;
+}
+
+extern LSQ_IntegerIndexT LSQ_PeekSpan(LSQ_IteratorT iterator, const LSQ_BaseTypeT ** span)
+{
+	return LSQ_GetSpan(iterator, (LSQ_BaseTypeT **)span);
+}
@@ -0,0 +1,15 @@
+#ifndef LINEAR_SEQUENCE_ROPE_H
+#define LINEAR_SEQUENCE_ROPE_H
+
+/* Whole-sequence operations of the rope backend (linear_sequence_rope.c). The header expects linear_sequence.h *
+ * to be included first. Both functions take O(log n) and invalidate the cached positions of iterators, which   *
+ * keep their indices.                                                                                           */
+
+/* Function that moves the elements from index onwards into a new sequence and returns it. The new sequence *
+ * uses the allocator of the original one                                                                     */
+extern LSQ_HandleT LSQ_SplitSequence(LSQ_HandleT handle, LSQ_IntegerIndexT index);
+/* Function that moves all elements of other to the end of handle and leaves other empty. Other must still be *
+ * destroyed, and both sequences must use the same allocator                                                  */
+extern void LSQ_ConcatenateSequences(LSQ_HandleT handle, LSQ_HandleT other);
+
+#endif
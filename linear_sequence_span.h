@@ -0,0 +1,15 @@
+#ifndef LINEAR_SEQUENCE_SPAN_H
+#define LINEAR_SEQUENCE_SPAN_H
+
+/* Bulk access to the storage of the sequence backends. The header expects linear_sequence.h to be included first */
+
+/* Function that stores in span a pointer to the element the iterator points to and returns the number of elements  *
+ * from there on that are contiguous in memory: the rest of the buffer for arrays, the current chunk for the rope and *
+ * one element for lists. Returns 0 and stores NULL for an iterator that is not dereferencable. The elements may be  *
+ * read and written in place until the sequence is modified; LSQ_ShiftPosition moves the iterator past the span.     */
+extern LSQ_IntegerIndexT LSQ_GetSpan(LSQ_IteratorT iterator, LSQ_BaseTypeT ** span);
+/* Function like LSQ_GetSpan that stores a read-only span. It does not unshare a clone of linear_sequence_dyn_arrays.c *
+ * or mark the block as written in linear_sequence_external.c and linear_sequence_packed.c                            */
+extern LSQ_IntegerIndexT LSQ_PeekSpan(LSQ_IteratorT iterator, const LSQ_BaseTypeT ** span);
+
+#endif
@@ -0,0 +1,319 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <time.h>
+#define LSQ_TRACE_IMPLEMENTATION
+#ifdef LSQ_TRACE_ASSOC
+#include "linear_sequence_assoc.h"
+#else
+#include "linear_sequence.h"
+#endif
+#include "linear_sequence_trace.h"
+
+/* Records are collected in a buffer and written in blocks. Live handles and iterators are mapped to their *
+ * trace numbers by a linear probing table keyed by address, so a reused address gets a new number.         */
+
+#define TRACE_BUFFER_RECORDS 4096
+#define OBJECT_TABLE_MIN_CAPACITY 64
+#define OBJECT_HASH_MULTIPLIER 11400714819323198485ull
+
+typedef struct
+{
+	const void * object;
+	unsigned int id;
+} ObjectSlotT;
+
+static FILE * trace_file = NULL;
+static LSQ_TraceRecordT trace_buffer[TRACE_BUFFER_RECORDS];
+static int buffered_records = 0;
+static unsigned long long last_timestamp = 0;
+
+static ObjectSlotT * object_slots = NULL;
+static size_t object_capacity = 0;
+static size_t object_count = 0;
+static unsigned int next_object_id = 1;
+
+static unsigned long long currentTimestamp(void);
+static void flushTrace(void);
+static size_t objectHome(const void * object);
+static int growObjectTable(void);
+static unsigned int findObject(const void * object);
+static unsigned int registerObject(const void * object);
+static void forgetObject(const void * object);
+static void traceCall(LSQ_TraceOperationT operation, const void * object, const void * result, int argument, int value);
+
+static unsigned long long currentTimestamp(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ull + (unsigned long long)now.tv_nsec;
+}
+
+static void flushTrace(void)
+{
+	if (buffered_records > 0)
+		fwrite(trace_buffer, sizeof(LSQ_TraceRecordT), (size_t)buffered_records, trace_file);
+	buffered_records = 0;
+}
+
+static size_t objectHome(const void * object)
+{
+	return (size_t)(((uintptr_t)object * OBJECT_HASH_MULTIPLIER) >> 32) & (object_capacity - 1);
+}
+
+static int growObjectTable(void)
+{
+	ObjectSlotT * old_slots = object_slots;
+	size_t old_capacity = object_capacity, i, slot;
+	size_t capacity = (old_capacity == 0) ? OBJECT_TABLE_MIN_CAPACITY : old_capacity * 2;
+	ObjectSlotT * slots = (ObjectSlotT *)calloc(capacity, sizeof(ObjectSlotT));
+	if (slots == NULL)
+		return 0;
+	object_slots = slots;
+	object_capacity = capacity;
+	for (i = 0; i < old_capacity; i++)
+	{
+		if (old_slots[i].object == NULL)
+			continue;
+		for (slot = objectHome(old_slots[i].object); object_slots[slot].object != NULL; slot = (slot + 1) & (capacity - 1))
+			;
+		object_slots[slot] = old_slots[i];
+	}
+	free(old_slots);
+	return 1;
+}
+
+static unsigned int findObject(const void * object)
+{
+	size_t slot;
+	if (object == NULL || object_capacity == 0)
+		return 0;
+	for (slot = objectHome(object); object_slots[slot].object != NULL; slot = (slot + 1) & (object_capacity - 1))
+		if (object_slots[slot].object == object)
+			return object_slots[slot].id;
+	return 0;
+}
+
+static unsigned int registerObject(const void * object)
+{
+	size_t slot;
+	if (object == NULL || ((object_count + 1) * 2 > object_capacity && !growObjectTable()))
+		return 0;
+	forgetObject(object);
+	for (slot = objectHome(object); object_slots[slot].object != NULL; slot = (slot + 1) & (object_capacity - 1))
+		;
+	object_slots[slot].object = object;
+	object_slots[slot].id = next_object_id;
+	object_count++;
+	return next_object_id++;
+}
+
+/* Backward-shift deletion keeps the probe sequences unbroken without tombstones */
+static void forgetObject(const void * object)
+{
+	size_t slot, next, home, mask = object_capacity - 1;
+	if (object == NULL || object_capacity == 0)
+		return;
+	for (slot = objectHome(object); object_slots[slot].object != object; slot = (slot + 1) & mask)
+		if (object_slots[slot].object == NULL)
+			return;
+	for (next = (slot + 1) & mask; object_slots[next].object != NULL; next = (next + 1) & mask)
+	{
+		home = objectHome(object_slots[next].object);
+		if (((next - home) & mask) < ((next - slot) & mask))
+			continue;
+		object_slots[slot] = object_slots[next];
+		slot = next;
+	}
+	object_slots[slot].object = NULL;
+	object_count--;
+}
+
+static void traceCall(LSQ_TraceOperationT operation, const void * object, const void * result, int argument, int value)
+{
+	LSQ_TraceRecordT * record = NULL;
+	unsigned long long timestamp, delta;
+	if (trace_file == NULL)
+		return;
+	timestamp = currentTimestamp();
+	delta = timestamp - last_timestamp;
+	last_timestamp = timestamp;
+	record = &trace_buffer[buffered_records];
+	record->time_delta = (delta > UINT_MAX) ? UINT_MAX : (unsigned int)delta;
+	record->operation = (unsigned int)operation;
+	record->object = findObject(object);
+	record->result = registerObject(result);
+	record->argument = argument;
+	record->value = value;
+	if (++buffered_records == TRACE_BUFFER_RECORDS)
+		flushTrace();
+}
+
+extern int LSQ_StartTrace(const char * path)
+{
+	LSQ_TraceHeaderT header;
+	if (trace_file != NULL)
+		LSQ_StopTrace();
+	trace_file = fopen(path, "wb");
+	if (trace_file == NULL)
+		return 0;
+	memcpy(header.magic, "LSQT", 4);
+	header.version = LSQ_TRACE_VERSION;
+#ifdef LSQ_TRACE_ASSOC
+	header.is_associative = 1;
+#else
+	header.is_associative = 0;
+#endif
+	header.record_size = sizeof(LSQ_TraceRecordT);
+	fwrite(&header, sizeof(header), 1, trace_file);
+	last_timestamp = currentTimestamp();
+	return 1;
+}
+
+extern void LSQ_StopTrace(void)
+{
+	if (trace_file == NULL)
+		return;
+	flushTrace();
+	fclose(trace_file);
+	trace_file = NULL;
+	free(object_slots);
+	object_slots = NULL;
+	object_capacity = object_count = 0;
+}
+
+extern LSQ_HandleT LSQ_TraceCreateSequence(void)
+{
+	LSQ_HandleT handle = LSQ_CreateSequence();
+	traceCall(LSQ_TRACE_CREATE_SEQUENCE, NULL, handle, 0, 0);
+	return handle;
+}
+
+extern void LSQ_TraceDestroySequence(LSQ_HandleT handle)
+{
+	traceCall(LSQ_TRACE_DESTROY_SEQUENCE, handle, NULL, 0, 0);
+	forgetObject(handle);
+	LSQ_DestroySequence(handle);
+}
+
+extern LSQ_IntegerIndexT LSQ_TraceGetSize(LSQ_HandleT handle)
+{
+	traceCall(LSQ_TRACE_GET_SIZE, handle, NULL, 0, 0);
+	return LSQ_GetSize(handle);
+}
+
+extern LSQ_BaseTypeT* LSQ_TraceDereferenceIterator(LSQ_IteratorT iterator)
+{
+	traceCall(LSQ_TRACE_DEREFERENCE_ITERATOR, iterator, NULL, 0, 0);
+	return LSQ_DereferenceIterator(iterator);
+}
+
+extern LSQ_IteratorT LSQ_TraceGetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	LSQ_IteratorT iterator = LSQ_GetElementByIndex(handle, index);
+	traceCall(LSQ_TRACE_GET_ELEMENT_BY_INDEX, handle, iterator, index, 0);
+	return iterator;
+}
+
+extern LSQ_IteratorT LSQ_TraceGetFrontElement(LSQ_HandleT handle)
+{
+	LSQ_IteratorT iterator = LSQ_GetFrontElement(handle);
+	traceCall(LSQ_TRACE_GET_FRONT_ELEMENT, handle, iterator, 0, 0);
+	return iterator;
+}
+
+extern LSQ_IteratorT LSQ_TraceGetPastRearElement(LSQ_HandleT handle)
+{
+	LSQ_IteratorT iterator = LSQ_GetPastRearElement(handle);
+	traceCall(LSQ_TRACE_GET_PAST_REAR_ELEMENT, handle, iterator, 0, 0);
+	return iterator;
+}
+
+extern void LSQ_TraceDestroyIterator(LSQ_IteratorT iterator)
+{
+	traceCall(LSQ_TRACE_DESTROY_ITERATOR, iterator, NULL, 0, 0);
+	forgetObject(iterator);
+	LSQ_DestroyIterator(iterator);
+}
+
+extern void LSQ_TraceAdvanceOneElement(LSQ_IteratorT iterator)
+{
+	traceCall(LSQ_TRACE_ADVANCE_ONE_ELEMENT, iterator, NULL, 0, 0);
+	LSQ_AdvanceOneElement(iterator);
+}
+
+extern void LSQ_TraceRewindOneElement(LSQ_IteratorT iterator)
+{
+	traceCall(LSQ_TRACE_REWIND_ONE_ELEMENT, iterator, NULL, 0, 0);
+	LSQ_RewindOneElement(iterator);
+}
+
+extern void LSQ_TraceShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	traceCall(LSQ_TRACE_SHIFT_POSITION, iterator, NULL, shift, 0);
+	LSQ_ShiftPosition(iterator, shift);
+}
+
+extern void LSQ_TraceSetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	traceCall(LSQ_TRACE_SET_POSITION, iterator, NULL, pos, 0);
+	LSQ_SetPosition(iterator, pos);
+}
+
+extern void LSQ_TraceDeleteFrontElement(LSQ_HandleT handle)
+{
+	traceCall(LSQ_TRACE_DELETE_FRONT_ELEMENT, handle, NULL, 0, 0);
+	LSQ_DeleteFrontElement(handle);
+}
+
+extern void LSQ_TraceDeleteRearElement(LSQ_HandleT handle)
+{
+	traceCall(LSQ_TRACE_DELETE_REAR_ELEMENT, handle, NULL, 0, 0);
+	LSQ_DeleteRearElement(handle);
+}
+
+#ifdef LSQ_TRACE_ASSOC
+extern LSQ_IntegerIndexT LSQ_TraceGetIteratorKey(LSQ_IteratorT iterator)
+{
+	traceCall(LSQ_TRACE_GET_ITERATOR_KEY, iterator, NULL, 0, 0);
+	return LSQ_GetIteratorKey(iterator);
+}
+
+extern void LSQ_TraceInsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	traceCall(LSQ_TRACE_INSERT_ELEMENT, handle, NULL, key, (int)value);
+	LSQ_InsertElement(handle, key, value);
+}
+
+extern void LSQ_TraceDeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key)
+{
+	traceCall(LSQ_TRACE_DELETE_ELEMENT, handle, NULL, key, 0);
+	LSQ_DeleteElement(handle, key);
+}
+#else
+extern void LSQ_TraceInsertFrontElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	traceCall(LSQ_TRACE_INSERT_FRONT_ELEMENT, handle, NULL, 0, (int)element);
+	LSQ_InsertFrontElement(handle, element);
+}
+
+extern void LSQ_TraceInsertRearElement(LSQ_HandleT handle, LSQ_BaseTypeT element)
+{
+	traceCall(LSQ_TRACE_INSERT_REAR_ELEMENT, handle, NULL, 0, (int)element);
+	LSQ_InsertRearElement(handle, element);
+}
+
+extern void LSQ_TraceInsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT newElement)
+{
+	traceCall(LSQ_TRACE_INSERT_ELEMENT_BEFORE_GIVEN, iterator, NULL, 0, (int)newElement);
+	LSQ_InsertElementBeforeGiven(iterator, newElement);
+}
+
+extern void LSQ_TraceDeleteGivenElement(LSQ_IteratorT iterator)
+{
+	traceCall(LSQ_TRACE_DELETE_GIVEN_ELEMENT, iterator, NULL, 0, 0);
+	LSQ_DeleteGivenElement(iterator);
+}
+#endif
@@ -0,0 +1,120 @@
+#ifndef LINEAR_SEQUENCE_TRACE_H
+#define LINEAR_SEQUENCE_TRACE_H
+
+/* Call tracing for the LSQ API. A program compiled with LSQ_TRACE and including this header after linear_sequence.h *
+ * or linear_sequence_assoc.h has its LSQ_* calls routed through linear_sequence_trace.c, which writes one record    *
+ * per call to the trace file between LSQ_StartTrace and LSQ_StopTrace. linear_sequence_trace.c is built with        *
+ * LSQ_TRACE_ASSOC for the associative API. The iterator state predicates and the extension headers are not traced.  *
+ * Tracing is not thread safe. Traces are replayed against any backend by linear_sequence_replay.c.                  */
+
+#define LSQ_TRACE_VERSION 1
+
+typedef enum
+{
+	LSQ_TRACE_CREATE_SEQUENCE,
+	LSQ_TRACE_DESTROY_SEQUENCE,
+	LSQ_TRACE_GET_SIZE,
+	LSQ_TRACE_DEREFERENCE_ITERATOR,
+	LSQ_TRACE_GET_ITERATOR_KEY,
+	LSQ_TRACE_GET_ELEMENT_BY_INDEX,
+	LSQ_TRACE_GET_FRONT_ELEMENT,
+	LSQ_TRACE_GET_PAST_REAR_ELEMENT,
+	LSQ_TRACE_DESTROY_ITERATOR,
+	LSQ_TRACE_ADVANCE_ONE_ELEMENT,
+	LSQ_TRACE_REWIND_ONE_ELEMENT,
+	LSQ_TRACE_SHIFT_POSITION,
+	LSQ_TRACE_SET_POSITION,
+	LSQ_TRACE_INSERT_ELEMENT,
+	LSQ_TRACE_INSERT_FRONT_ELEMENT,
+	LSQ_TRACE_INSERT_REAR_ELEMENT,
+	LSQ_TRACE_INSERT_ELEMENT_BEFORE_GIVEN,
+	LSQ_TRACE_DELETE_FRONT_ELEMENT,
+	LSQ_TRACE_DELETE_REAR_ELEMENT,
+	LSQ_TRACE_DELETE_ELEMENT,
+	LSQ_TRACE_DELETE_GIVEN_ELEMENT,
+	LSQ_TRACE_OPERATION_COUNT,
+} LSQ_TraceOperationT;
+
+/* The trace file is one header followed by records */
+typedef struct
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int is_associative;
+	unsigned int record_size;
+} LSQ_TraceHeaderT;
+
+/* Handles and iterators are identified by numbers given in creation order, zero marks an object created *
+ * while tracing was off                                                                                  */
+typedef struct
+{
+	/* Nanoseconds since the previous record, saturated */
+	unsigned int time_delta;
+	unsigned int operation;
+	/* Handle or iterator the call operates on */
+	unsigned int object;
+	/* Handle or iterator the call returned */
+	unsigned int result;
+	/* Key, index, shift or position */
+	int argument;
+	int value;
+} LSQ_TraceRecordT;
+
+/* Function that starts writing calls to the file at path. Returns 0 if the file cannot be created */
+extern int LSQ_StartTrace(const char * path);
+/* Function that flushes and closes the trace file */
+extern void LSQ_StopTrace(void);
+
+extern LSQ_HandleT LSQ_TraceCreateSequence(void);
+extern void LSQ_TraceDestroySequence(LSQ_HandleT handle);
+extern LSQ_IntegerIndexT LSQ_TraceGetSize(LSQ_HandleT handle);
+extern LSQ_BaseTypeT* LSQ_TraceDereferenceIterator(LSQ_IteratorT iterator);
+extern LSQ_IteratorT LSQ_TraceGetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index);
+extern LSQ_IteratorT LSQ_TraceGetFrontElement(LSQ_HandleT handle);
+extern LSQ_IteratorT LSQ_TraceGetPastRearElement(LSQ_HandleT handle);
+extern void LSQ_TraceDestroyIterator(LSQ_IteratorT iterator);
+extern void LSQ_TraceAdvanceOneElement(LSQ_IteratorT iterator);
+extern void LSQ_TraceRewindOneElement(LSQ_IteratorT iterator);
+extern void LSQ_TraceShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift);
+extern void LSQ_TraceSetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos);
+extern void LSQ_TraceDeleteFrontElement(LSQ_HandleT handle);
+extern void LSQ_TraceDeleteRearElement(LSQ_HandleT handle);
+#ifdef LSQ_TRACE_ASSOC
+extern LSQ_IntegerIndexT LSQ_TraceGetIteratorKey(LSQ_IteratorT iterator);
+extern void LSQ_TraceInsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+extern void LSQ_TraceDeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key);
+#else
+extern void LSQ_TraceInsertFrontElement(LSQ_HandleT handle, LSQ_BaseTypeT element);
+extern void LSQ_TraceInsertRearElement(LSQ_HandleT handle, LSQ_BaseTypeT element);
+extern void LSQ_TraceInsertElementBeforeGiven(LSQ_IteratorT iterator, LSQ_BaseTypeT newElement);
+extern void LSQ_TraceDeleteGivenElement(LSQ_IteratorT iterator);
+#endif
+
+#if defined(LSQ_TRACE) && !defined(LSQ_TRACE_IMPLEMENTATION)
+#define LSQ_CreateSequence() LSQ_TraceCreateSequence()
+#define LSQ_DestroySequence(handle) LSQ_TraceDestroySequence(handle)
+#define LSQ_GetSize(handle) LSQ_TraceGetSize(handle)
+#define LSQ_DereferenceIterator(iterator) LSQ_TraceDereferenceIterator(iterator)
+#define LSQ_GetElementByIndex(handle, index) LSQ_TraceGetElementByIndex(handle, index)
+#define LSQ_GetFrontElement(handle) LSQ_TraceGetFrontElement(handle)
+#define LSQ_GetPastRearElement(handle) LSQ_TraceGetPastRearElement(handle)
+#define LSQ_DestroyIterator(iterator) LSQ_TraceDestroyIterator(iterator)
+#define LSQ_AdvanceOneElement(iterator) LSQ_TraceAdvanceOneElement(iterator)
+#define LSQ_RewindOneElement(iterator) LSQ_TraceRewindOneElement(iterator)
+#define LSQ_ShiftPosition(iterator, shift) LSQ_TraceShiftPosition(iterator, shift)
+#define LSQ_SetPosition(iterator, pos) LSQ_TraceSetPosition(iterator, pos)
+#define LSQ_DeleteFrontElement(handle) LSQ_TraceDeleteFrontElement(handle)
+#define LSQ_DeleteRearElement(handle) LSQ_TraceDeleteRearElement(handle)
+#ifdef LSQ_TRACE_ASSOC
+#define LSQ_GetIteratorKey(iterator) LSQ_TraceGetIteratorKey(iterator)
+#define LSQ_InsertElement(handle, key, value) LSQ_TraceInsertElement(handle, key, value)
+#define LSQ_DeleteElement(handle, key) LSQ_TraceDeleteElement(handle, key)
+#else
+#define LSQ_InsertFrontElement(handle, element) LSQ_TraceInsertFrontElement(handle, element)
+#define LSQ_InsertRearElement(handle, element) LSQ_TraceInsertRearElement(handle, element)
+#define LSQ_InsertElementBeforeGiven(iterator, element) LSQ_TraceInsertElementBeforeGiven(iterator, element)
+#define LSQ_DeleteGivenElement(iterator) LSQ_TraceDeleteGivenElement(iterator)
+#endif
+#endif
+
+#endif
@@ -0,0 +1,103 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include "linear_sequence.hpp"
+
+/* Per-element cost of traversing a sequence through linear_sequence.hpp, compared with a raw array and with the C *
+ * API. Build it against a backend that provides linear_sequence_span.h, compiled as C:                            *
+ *     cc -O2 -c linear_sequence_dyn_arrays.c                                                                      *
+ *     c++ -O2 linear_sequence_wrapper_bench.cpp linear_sequence_dyn_arrays.o -o bench_wrapper                     *
+ * Usage: bench [elements] [passes]                                                                                *
+ * Every traversal sums the elements: a loop over a std::vector, for_each_span, a range-for over the iterators and *
+ * LSQ_GetElementByIndex with LSQ_DereferenceIterator for each index. The last one runs a tenth of the passes.     */
+
+namespace
+{
+
+double elapsedSeconds(const timespec & start, const timespec & finish)
+{
+	return (finish.tv_sec - start.tv_sec) + (finish.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+long long sumArray(const std::vector<LSQ_BaseTypeT> & array)
+{
+	const LSQ_BaseTypeT * data = array.data();
+	long long sum = 0;
+	for (std::size_t i = 0; i < array.size(); i++)
+		sum += data[i];
+	return sum;
+}
+
+long long sumSpans(const lsq::sequence & sequence)
+{
+	long long sum = 0;
+	sequence.for_each_span([&sum](const LSQ_BaseTypeT * span, LSQ_IntegerIndexT count) {
+		long long span_sum = 0;
+		for (LSQ_IntegerIndexT i = 0; i < count; i++)
+			span_sum += span[i];
+		sum += span_sum;
+	});
+	return sum;
+}
+
+long long sumRange(const lsq::sequence & sequence)
+{
+	long long sum = 0;
+	for (LSQ_BaseTypeT element : sequence)
+		sum += element;
+	return sum;
+}
+
+long long sumByIndex(const lsq::sequence & sequence)
+{
+	long long sum = 0;
+	for (LSQ_IntegerIndexT i = 0; i < sequence.size(); i++)
+	{
+		LSQ_IteratorT iterator = LSQ_GetElementByIndex(sequence.handle(), i);
+		sum += *LSQ_DereferenceIterator(iterator);
+		LSQ_DestroyIterator(iterator);
+	}
+	return sum;
+}
+
+/* Runs passes traversals and prints the time per element */
+template <typename Container>
+void measure(const char * name, long long (*traverse)(const Container &), const Container & container,
+			 long long elements, int passes)
+{
+	timespec start, finish;
+	long long sum = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (int pass = 0; pass < passes; pass++)
+		sum += traverse(container);
+	clock_gettime(CLOCK_MONOTONIC, &finish);
+	std::printf("%-16s %.2f ns per element, checksum %lld\n", name,
+		elapsedSeconds(start, finish) * 1e9 / (elements * passes), sum);
+}
+
+}
+
+int main(int argc, char ** argv)
+{
+	int elements = (argc > 1) ? std::atoi(argv[1]) : 1 << 22;
+	int passes = (argc > 2) ? std::atoi(argv[2]) : 50;
+
+	if (elements < 1 || passes < 10)
+	{
+		std::fprintf(stderr, "usage: %s [elements] [passes of at least 10]\n", argv[0]);
+		return 1;
+	}
+	lsq::sequence sequence;
+	std::vector<LSQ_BaseTypeT> array;
+	for (int i = 0; i < elements; i++)
+	{
+		sequence.push_back(i & 1023);
+		array.push_back(i & 1023);
+	}
+	measure("raw array", sumArray, array, elements, passes);
+	measure("for_each_span", sumSpans, sequence, elements, passes);
+	measure("range-for", sumRange, sequence, elements, passes);
+	measure("C API by index", sumByIndex, sequence, elements, passes / 10);
+	return 0;
+}
@@ -0,0 +1,568 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "linear_sequence_assoc.h"
+#include "linear_sequence_allocator.h"
+#include "assoc_array_snapshot.h"
+#include "linear_sequence_clone.h"
+
+/* Persistent AVL tree: nodes are immutable once shared and carry reference counts, updates copy the path from the   *
+ * root. LSQ_CreateSnapshot is O(1), and an update allocates O(log n) nodes only when the path is shared. Nodes      *
+ * have no parent pointers; iterators keep the path on a stack and pin the version they were created on, so they     *
+ * stay valid across later updates of the handle. LSQ_DereferenceIterator is an update too: it copies the shared     *
+ * nodes on the iterator's path into the handle, and returns NULL for an iterator pinned to an older version or if   *
+ * the copies cannot be allocated; LSQ_PeekIterator reads any version without copying. Reference counts are atomic:  *
+ * versions may be read and released from different threads as long as each handle is used by one thread at a time.  *
+ * An update first reserves the nodes its path copy may need, at most h + 2 for an insertion and 3(h + 1) for a      *
+ * deletion in a tree of height h, and leaves the version unchanged if they cannot be allocated. Unused reserved     *
+ * nodes stay with the handle for its next update.                                                                   */
+
+#define IS_HANDLE_INVALID(handle)        ((handle) == LSQ_HandleInvalid)
+#define TREE_MAX_HEIGHT 48
+
+typedef enum
+{
+	IST_BEFORE_FIRST,
+	IST_DEREFERENCABLE,
+	IST_PAST_REAR,
+} IteratorStateT;
+
+typedef struct TreeNodeStruct
+{
+	struct TreeNodeStruct * l_child;
+	struct TreeNodeStruct * r_child;
+	int ref_count;
+	int height;
+	LSQ_IntegerIndexT key;
+	LSQ_BaseTypeT value;
+} TreeNodeT;
+
+typedef struct
+{
+	TreeNodeT * root;
+	int size;
+	const LSQ_AllocatorT * allocator;
+	/* Nodes allocated ahead for path copies, chained through l_child */
+	TreeNodeT * reserve;
+	int reserve_count;
+} PersistentTreeT;
+
+typedef struct
+{
+	PersistentTreeT * tree;
+	TreeNodeT * root;
+	TreeNodeT * path[TREE_MAX_HEIGHT];
+	int depth;
+	IteratorStateT state;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static __inline int treeHeight(const TreeNodeT * root);
+static __inline int nodeBalanceFlag(const TreeNodeT * node);
+static __inline void fixTreeHeight(TreeNodeT * root);
+static __inline TreeNodeT * acquireNode(TreeNodeT * node);
+static void releaseNode(const LSQ_AllocatorT * allocator, TreeNodeT * node);
+static int reserveNodes(PersistentTreeT * tree, int count);
+static TreeNodeT * takeNode(PersistentTreeT * tree);
+static TreeNodeT * createNode(PersistentTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+static TreeNodeT * makeWritable(PersistentTreeT * tree, TreeNodeT * node);
+static TreeNodeT * smallLeftRotate(PersistentTreeT * tree, TreeNodeT * root);
+static TreeNodeT * smallRightRotate(PersistentTreeT * tree, TreeNodeT * root);
+static TreeNodeT * restoreBalance(PersistentTreeT * tree, TreeNodeT * node);
+static TreeNodeT * findNode(TreeNodeT * root, LSQ_IntegerIndexT key);
+static TreeNodeT * insertNode(PersistentTreeT * tree, TreeNodeT * node, LSQ_IntegerIndexT key, LSQ_BaseTypeT value);
+static TreeNodeT * removeMinimum(PersistentTreeT * tree, TreeNodeT * node, TreeNodeT * target);
+static TreeNodeT * deleteNode(PersistentTreeT * tree, TreeNodeT * node, LSQ_IntegerIndexT key);
+static void pushLeftSpine(IteratorT * iter, TreeNodeT * node);
+static void pushRightSpine(IteratorT * iter, TreeNodeT * node);
+static int makePathWritable(IteratorT * iter);
+static IteratorT * createIterator(LSQ_HandleT handle);
+
+static __inline int treeHeight(const TreeNodeT * root)
+{
+	return root != NULL ? root->height : -1;
+}
+
+static __inline int nodeBalanceFlag(const TreeNodeT * node)
+{
+	assert(node != NULL);
+	return treeHeight(node->l_child) - treeHeight(node->r_child);
+}
+
+static __inline void fixTreeHeight(TreeNodeT * root)
+{
+	int l_height = treeHeight(root->l_child), r_height = treeHeight(root->r_child);
+	root->height = 1 + (l_height > r_height ? l_height : r_height);
+}
+
+static __inline TreeNodeT * acquireNode(TreeNodeT * node)
+{
+	if (node != NULL)
+		__atomic_add_fetch(&node->ref_count, 1, __ATOMIC_RELAXED);
+	return node;
+}
+
+static void releaseNode(const LSQ_AllocatorT * allocator, TreeNodeT * node)
+{
+	TreeNodeT * right = NULL;
+	while (node != NULL && __atomic_sub_fetch(&node->ref_count, 1, __ATOMIC_ACQ_REL) == 0)
+	{
+		releaseNode(allocator, node->l_child);
+		right = node->r_child;
+		lsqDeallocate(allocator, node, sizeof(TreeNodeT));
+		node = right;
+	}
+}
+
+/* Tops the reserve up to count nodes. Returns 0 if allocation failed, keeping the nodes allocated so far */
+static int reserveNodes(PersistentTreeT * tree, int count)
+{
+	TreeNodeT * node = NULL;
+	while (tree->reserve_count < count)
+	{
+		node = (TreeNodeT *)lsqAllocate(tree->allocator, sizeof(TreeNodeT));
+		if (node == NULL)
+			return 0;
+		node->l_child = tree->reserve;
+		tree->reserve = node;
+		tree->reserve_count++;
+	}
+	return 1;
+}
+
+static TreeNodeT * takeNode(PersistentTreeT * tree)
+{
+	TreeNodeT * node = tree->reserve;
+	assert(node != NULL);
+	tree->reserve = node->l_child;
+	tree->reserve_count--;
+	return node;
+}
+
+static TreeNodeT * createNode(PersistentTreeT * tree, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	TreeNodeT * node = takeNode(tree);
+	node->l_child = NULL;
+	node->r_child = NULL;
+	node->ref_count = 1;
+	node->height = 0;
+	node->key = key;
+	node->value = value;
+	return node;
+}
+
+/* Returns a node the caller may modify in place. A node referenced only by the caller is returned as is; *
+ * a shared node is copied, the copy takes references to the children, and the caller's reference to the  *
+ * original is dropped.                                                                                     */
+static TreeNodeT * makeWritable(PersistentTreeT * tree, TreeNodeT * node)
+{
+	TreeNodeT * copy = NULL;
+	if (__atomic_load_n(&node->ref_count, __ATOMIC_ACQUIRE) == 1)
+		return node;
+	copy = takeNode(tree);
+	*copy = *node;
+	copy->ref_count = 1;
+	acquireNode(copy->l_child);
+	acquireNode(copy->r_child);
+	releaseNode(tree->allocator, node);
+	return copy;
+}
+
+/* Rotations take a writable root and return the new writable root of the subtree */
+static TreeNodeT * smallLeftRotate(PersistentTreeT * tree, TreeNodeT * root)
+{
+	TreeNodeT * node = makeWritable(tree, root->r_child);
+	root->r_child = node->l_child;
+	node->l_child = root;
+	fixTreeHeight(root);
+	fixTreeHeight(node);
+	return node;
+}
+
+static TreeNodeT * smallRightRotate(PersistentTreeT * tree, TreeNodeT * root)
+{
+	TreeNodeT * node = makeWritable(tree, root->l_child);
+	root->l_child = node->r_child;
+	node->r_child = root;
+	fixTreeHeight(root);
+	fixTreeHeight(node);
+	return node;
+}
+
+static TreeNodeT * restoreBalance(PersistentTreeT * tree, TreeNodeT * node)
+{
+	int node_balance;
+	fixTreeHeight(node);
+	node_balance = nodeBalanceFlag(node);
+	if (node_balance == -2)
+	{
+		if (nodeBalanceFlag(node->r_child) > 0)
+			node->r_child = smallRightRotate(tree, makeWritable(tree, node->r_child));
+		return smallLeftRotate(tree, node);
+	}
+	if (node_balance == 2)
+	{
+		if (nodeBalanceFlag(node->l_child) < 0)
+			node->l_child = smallLeftRotate(tree, makeWritable(tree, node->l_child));
+		return smallRightRotate(tree, node);
+	}
+	return node;
+}
+
+static TreeNodeT * findNode(TreeNodeT * root, LSQ_IntegerIndexT key)
+{
+	while ((root != NULL) && (root->key != key))
+		root = (key > root->key) ? root->r_child : root->l_child;
+	return root;
+}
+
+/* Consumes the caller's reference to node and returns the writable root of the updated subtree */
+static TreeNodeT * insertNode(PersistentTreeT * tree, TreeNodeT * node, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	if (node == NULL)
+	{
+		node = createNode(tree, key, value);
+		tree->size++;
+		return node;
+	}
+	node = makeWritable(tree, node);
+	if (key < node->key)
+		node->l_child = insertNode(tree, node->l_child, key, value);
+	else if (key > node->key)
+		node->r_child = insertNode(tree, node->r_child, key, value);
+	else
+	{
+		node->value = value;
+		return node;
+	}
+	return restoreBalance(tree, node);
+}
+
+/* Unlinks the minimum of the subtree, moving its key and value into target */
+static TreeNodeT * removeMinimum(PersistentTreeT * tree, TreeNodeT * node, TreeNodeT * target)
+{
+	TreeNodeT * right = NULL;
+	node = makeWritable(tree, node);
+	if (node->l_child == NULL)
+	{
+		target->key = node->key;
+		target->value = node->value;
+		right = node->r_child;
+		node->r_child = NULL;
+		releaseNode(tree->allocator, node);
+		tree->size--;
+		return right;
+	}
+	node->l_child = removeMinimum(tree, node->l_child, target);
+	return restoreBalance(tree, node);
+}
+
+/* The key must be present. Consumes the caller's reference to node like insertNode */
+static TreeNodeT * deleteNode(PersistentTreeT * tree, TreeNodeT * node, LSQ_IntegerIndexT key)
+{
+	TreeNodeT * child = NULL;
+	node = makeWritable(tree, node);
+	if (key < node->key)
+		node->l_child = deleteNode(tree, node->l_child, key);
+	else if (key > node->key)
+		node->r_child = deleteNode(tree, node->r_child, key);
+	else if (node->l_child != NULL && node->r_child != NULL)
+		node->r_child = removeMinimum(tree, node->r_child, node);
+	else
+	{
+		child = (node->l_child != NULL) ? node->l_child : node->r_child;
+		node->l_child = NULL;
+		node->r_child = NULL;
+		releaseNode(tree->allocator, node);
+		tree->size--;
+		return child;
+	}
+	return restoreBalance(tree, node);
+}
+
+static void pushLeftSpine(IteratorT * iter, TreeNodeT * node)
+{
+	for (; node != NULL; node = node->l_child)
+		iter->path[iter->depth++] = node;
+}
+
+static void pushRightSpine(IteratorT * iter, TreeNodeT * node)
+{
+	for (; node != NULL; node = node->r_child)
+		iter->path[iter->depth++] = node;
+}
+
+/* Copies the shared nodes on the path of an iterator pinned to the current version, so that the element can be *
+ * written without changing other versions, and repoints the handle and the iterator to the copies              */
+static int makePathWritable(IteratorT * iter)
+{
+	PersistentTreeT * tree = iter->tree;
+	TreeNodeT * node = NULL, * parent = NULL;
+	int i;
+	if (!reserveNodes(tree, iter->depth))
+		return 0;
+	/* The handle keeps the root alive; without the iterator's reference an unshared root is not copied */
+	releaseNode(tree->allocator, iter->root);
+	for (i = 0; i < iter->depth; i++)
+	{
+		node = makeWritable(tree, iter->path[i]);
+		if (parent == NULL)
+			tree->root = node;
+		else if (parent->l_child == iter->path[i])
+			parent->l_child = node;
+		else
+			parent->r_child = node;
+		iter->path[i] = node;
+		parent = node;
+	}
+	iter->root = acquireNode(tree->root);
+	return 1;
+}
+
+static IteratorT * createIterator(LSQ_HandleT handle)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)handle;
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(tree->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = tree->allocator;
+	iterator->tree = tree;
+	iterator->root = acquireNode(tree->root);
+	iterator->depth = 0;
+	iterator->state = IST_PAST_REAR;
+	return iterator;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)lsqAllocate(allocator, sizeof(PersistentTreeT));
+	if (tree == NULL)
+		return LSQ_HandleInvalid;
+	tree->allocator = allocator;
+	tree->size = 0;
+	tree->root = NULL;
+	tree->reserve = NULL;
+	tree->reserve_count = 0;
+	return tree;
+}
+
+extern LSQ_HandleT LSQ_CreateSnapshot(LSQ_HandleT handle)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)handle, * snapshot = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	snapshot = (PersistentTreeT *)LSQ_CreateSequenceWithAllocator(tree->allocator);
+	if (snapshot == NULL)
+		return LSQ_HandleInvalid;
+	snapshot->root = acquireNode(tree->root);
+	snapshot->size = tree->size;
+	return snapshot;
+}
+
+extern LSQ_HandleT LSQ_CloneSequence(LSQ_HandleT handle)
+{
+	return LSQ_CreateSnapshot(handle);
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(tree->allocator))
+		return;
+	releaseNode(tree->allocator, tree->root);
+	while (tree->reserve_count > 0)
+		lsqDeallocate(tree->allocator, takeNode(tree), sizeof(TreeNodeT));
+	lsqDeallocate(tree->allocator, tree, sizeof(PersistentTreeT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? -1 : ((PersistentTreeT *)handle)->size;
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_DEREFERENCABLE;
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_PAST_REAR;
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_BEFORE_FIRST;
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (!LSQ_IsIteratorDereferencable(iterator) || iter->root != iter->tree->root || !makePathWritable(iter))
+		return NULL;
+	return &iter->path[iter->depth - 1]->value;
+}
+
+extern const LSQ_BaseTypeT* LSQ_PeekIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !LSQ_IsIteratorDereferencable(iterator) ? NULL :
+		&iter->path[iter->depth - 1]->value;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetIteratorKey(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	assert(LSQ_IsIteratorDereferencable(iterator));
+	return iter->path[iter->depth - 1]->key;
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	IteratorT * iter = createIterator(handle);
+	TreeNodeT * node = NULL;
+	if (iter == NULL)
+		return LSQ_HandleInvalid;
+	for (node = iter->root; node != NULL; node = (index > node->key) ? node->r_child : node->l_child)
+	{
+		iter->path[iter->depth++] = node;
+		if (node->key == index)
+		{
+			iter->state = IST_DEREFERENCABLE;
+			return iter;
+		}
+	}
+	iter->depth = 0;
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	IteratorT * iter = createIterator(handle);
+	if (iter == NULL)
+		return LSQ_HandleInvalid;
+	pushLeftSpine(iter, iter->root);
+	iter->state = (iter->depth > 0) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	return createIterator(handle);
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	releaseNode(iter->allocator, iter->root);
+	lsqDeallocate(iter->allocator, iter, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	TreeNodeT * child = NULL;
+	if (IS_HANDLE_INVALID(iterator) || iter->root == NULL || iter->state == IST_PAST_REAR)
+		return;
+	if (iter->state == IST_BEFORE_FIRST)
+		pushLeftSpine(iter, iter->root);
+	else if (iter->path[iter->depth - 1]->r_child != NULL)
+		pushLeftSpine(iter, iter->path[iter->depth - 1]->r_child);
+	else
+	{
+		do
+			child = iter->path[--iter->depth];
+		while (iter->depth > 0 && iter->path[iter->depth - 1]->r_child == child);
+	}
+	iter->state = (iter->depth > 0) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	TreeNodeT * child = NULL;
+	if (IS_HANDLE_INVALID(iterator) || iter->root == NULL || iter->state == IST_BEFORE_FIRST)
+		return;
+	if (iter->state == IST_PAST_REAR)
+		pushRightSpine(iter, iter->root);
+	else if (iter->path[iter->depth - 1]->l_child != NULL)
+		pushRightSpine(iter, iter->path[iter->depth - 1]->l_child);
+	else
+	{
+		do
+			child = iter->path[--iter->depth];
+		while (iter->depth > 0 && iter->path[iter->depth - 1]->l_child == child);
+	}
+	iter->state = (iter->depth > 0) ? IST_DEREFERENCABLE : IST_BEFORE_FIRST;
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	for(; shift > 0; shift--)
+		LSQ_AdvanceOneElement(iterator);
+	for(; shift < 0; shift++)
+		LSQ_RewindOneElement(iterator);
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter->depth = 0;
+	iter->state = IST_BEFORE_FIRST;
+	LSQ_ShiftPosition(iterator, pos + 1);
+}
+
+extern void LSQ_InsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || !reserveNodes(tree, treeHeight(tree->root) + 2))
+        return;
+	tree->root = insertNode(tree, tree->root, key, value);
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)handle;
+	TreeNodeT * node = NULL;
+	if (IS_HANDLE_INVALID(handle) || tree->root == NULL)
+		return;
+	for (node = tree->root; node->l_child != NULL; node = node->l_child)
+		;
+	LSQ_DeleteElement(handle, node->key);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)handle;
+	TreeNodeT * node = NULL;
+	if (IS_HANDLE_INVALID(handle) || tree->root == NULL)
+		return;
+	for (node = tree->root; node->r_child != NULL; node = node->r_child)
+		;
+	LSQ_DeleteElement(handle, node->key);
+}
+
+extern void LSQ_DeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key)
+{
+	PersistentTreeT * tree = (PersistentTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || findNode(tree->root, key) == NULL ||
+		!reserveNodes(tree, 3 * (treeHeight(tree->root) + 1)))
+		return;
+	tree->root = deleteNode(tree, tree->root, key);
+}
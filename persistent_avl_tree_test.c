@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "linear_sequence_assoc.h"
+#include "assoc_array_snapshot.h"
+#include "linear_sequence_clone.h"
+
+/* Snapshot isolation test for persistent_avl_tree.c. Values written through LSQ_DereferenceIterator must reach     *
+ * only the handle the iterator was created on: the test takes snapshots of a map, writes through iterators of the *
+ * map and of the snapshots in random order, keeps a private copy of every version and compares each version with  *
+ * its copy. It also checks that an iterator created before the last update of its handle cannot write, and that a *
+ * dereference of an unshared path copies nothing. Build it with a sanitizer:                                      *
+ *     cc -O1 -g -fsanitize=address persistent_avl_tree_test.c persistent_avl_tree.c -o test_persistent            *
+ * Usage: test [keys] [versions] [writes]                                                                          *
+ * The exit status is 0 if no check failed.                                                                        */
+
+static long long errors = 0;
+
+static unsigned int nextRandom(unsigned int * state)
+{
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static void reportError(const char * message, int version, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	if (errors++ < 10)
+		fprintf(stderr, "%s, version %d, key %d, value %d\n", message, version, key, value);
+}
+
+/* Writes value to key through an iterator of handle, which must succeed */
+static void writeThroughIterator(LSQ_HandleT handle, int version, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	LSQ_IteratorT iterator = LSQ_GetElementByIndex(handle, key);
+	LSQ_BaseTypeT * element = LSQ_DereferenceIterator(iterator);
+	if (element == NULL)
+		reportError("dereference of a current iterator failed", version, key, value);
+	else
+		*element = value;
+	LSQ_DestroyIterator(iterator);
+}
+
+/* Compares a version with its copy, which holds the value of key i at index i */
+static void checkVersion(LSQ_HandleT handle, int version, const LSQ_BaseTypeT * expected, int keys)
+{
+	LSQ_IteratorT iterator = LSQ_GetFrontElement(handle);
+	int key;
+	for (key = 0; key < keys; key++, LSQ_AdvanceOneElement(iterator))
+	{
+		if (!LSQ_IsIteratorDereferencable(iterator) || LSQ_GetIteratorKey(iterator) != key)
+		{
+			reportError("key is missing", version, key, expected[key]);
+			break;
+		}
+		if (*LSQ_PeekIterator(iterator) != expected[key])
+			reportError("value differs", version, key, *LSQ_PeekIterator(iterator));
+	}
+	LSQ_DestroyIterator(iterator);
+}
+
+/* A value written through an iterator of the map must not show in a snapshot taken before the write */
+static void checkSingleWrite(void)
+{
+	LSQ_HandleT map = LSQ_CreateSequence(), snapshot = LSQ_HandleInvalid;
+	LSQ_IteratorT iterator = LSQ_HandleInvalid;
+	LSQ_InsertElement(map, 1, 10);
+	snapshot = LSQ_CreateSnapshot(map);
+	writeThroughIterator(map, 0, 1, 99);
+	iterator = LSQ_GetElementByIndex(snapshot, 1);
+	if (!LSQ_IsIteratorDereferencable(iterator) || *LSQ_PeekIterator(iterator) != 10)
+		reportError("write through the map changed the snapshot", 1, 1, 99);
+	LSQ_DestroyIterator(iterator);
+	iterator = LSQ_GetElementByIndex(map, 1);
+	if (!LSQ_IsIteratorDereferencable(iterator) || *LSQ_PeekIterator(iterator) != 99)
+		reportError("write through the map was lost", 0, 1, 10);
+	LSQ_DestroyIterator(iterator);
+	LSQ_DestroySequence(snapshot);
+	LSQ_DestroySequence(map);
+}
+
+/* An iterator pinned to an older version reads it but cannot write; a current one writes without copying an *
+ * unshared path                                                                                             */
+static void checkStaleIterator(void)
+{
+	LSQ_HandleT map = LSQ_CreateSequence();
+	LSQ_IteratorT stale = LSQ_HandleInvalid, current = LSQ_HandleInvalid;
+	const LSQ_BaseTypeT * before = NULL;
+	int key;
+	for (key = 0; key < 100; key++)
+		LSQ_InsertElement(map, key, key);
+	stale = LSQ_GetElementByIndex(map, 50);
+	LSQ_InsertElement(map, 50, 500);
+	if (LSQ_DereferenceIterator(stale) != NULL)
+		reportError("iterator of an older version can write", 0, 50, *LSQ_PeekIterator(stale));
+	if (*LSQ_PeekIterator(stale) != 50)
+		reportError("iterator of an older version lost its value", 0, 50, *LSQ_PeekIterator(stale));
+	LSQ_DestroyIterator(stale);
+
+	current = LSQ_GetElementByIndex(map, 70);
+	before = LSQ_PeekIterator(current);
+	if (LSQ_DereferenceIterator(current) != before)
+		reportError("dereference copied an unshared path", 0, 70, *before);
+	LSQ_DestroyIterator(current);
+	LSQ_DestroySequence(map);
+}
+
+int main(int argc, char ** argv)
+{
+	int keys = (argc > 1) ? atoi(argv[1]) : 1000;
+	int versions = (argc > 2) ? atoi(argv[2]) : 8;
+	int writes = (argc > 3) ? atoi(argv[3]) : 100000;
+	unsigned int seed = 2463534242u;
+	LSQ_HandleT * handles = NULL;
+	LSQ_BaseTypeT * expected = NULL;
+	LSQ_IntegerIndexT key;
+	LSQ_BaseTypeT value;
+	int i, version, target;
+
+	if (keys < 1 || versions < 1 || writes < 0)
+	{
+		fprintf(stderr, "usage: %s [keys] [versions] [writes]\n", argv[0]);
+		return 1;
+	}
+	checkSingleWrite();
+	checkStaleIterator();
+
+	handles = (LSQ_HandleT *)malloc(versions * sizeof(LSQ_HandleT));
+	expected = (LSQ_BaseTypeT *)malloc((long long)versions * keys * sizeof(LSQ_BaseTypeT));
+	if (handles == NULL || expected == NULL)
+		return 1;
+	handles[0] = LSQ_CreateSequence();
+	for (key = 0; key < keys; key++)
+	{
+		LSQ_InsertElement(handles[0], key, key);
+		expected[key] = key;
+	}
+	/* Every version starts as a snapshot of a random older one, and writes to any of them follow */
+	for (version = 1; version < versions; version++)
+	{
+		i = (int)(nextRandom(&seed) % (unsigned int)version);
+		handles[version] = LSQ_CreateSnapshot(handles[i]);
+		for (key = 0; key < keys; key++)
+			expected[version * keys + key] = expected[i * keys + key];
+		for (i = 0; i < writes / versions; i++)
+		{
+			target = (int)(nextRandom(&seed) % (unsigned int)(version + 1));
+			key = (LSQ_IntegerIndexT)(nextRandom(&seed) % (unsigned int)keys);
+			value = (LSQ_BaseTypeT)(nextRandom(&seed) % (1u << 30));
+			writeThroughIterator(handles[target], target, key, value);
+			expected[target * keys + key] = value;
+		}
+	}
+	for (version = 0; version < versions; version++)
+		checkVersion(handles[version], version, expected + version * keys, keys);
+
+	printf("keys %d, versions %d, writes %d, errors %lld\n", keys, versions, writes, errors);
+	for (version = 0; version < versions; version++)
+		LSQ_DestroySequence(handles[version]);
+	free(handles);
+	free(expected);
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,653 @@
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include "linear_sequence_assoc.h"
+#include "linear_sequence_allocator.h"
+
+/* Ordered associative array on a fixed-depth radix tree over the 32 key bits, split into four 8-bit digits.      *
+ * Lookups visit exactly four nodes whatever the size. The three upper levels are inner nodes that start sparse   *
+ * (up to 16 sorted digits) and switch to a 256-entry table when they fill up. The last level is a leaf holding a *
+ * 256-bit presence bitmap and the values of the present keys packed in key order, so keys themselves are never  *
+ * stored: a fully dense leaf costs about 4 bytes per key. The layout pays off for dense or clustered keys;       *
+ * for keys scattered over the whole int range every key ends up in its own leaf and avl_tree.c or hash_map.c    *
+ * is the better choice. Iterators remember a key rather than a node, so they remain ordered across updates,      *
+ * but dereferencing an iterator whose element was deleted returns NULL.                                          */
+
+#define IS_HANDLE_INVALID(handle)        ((handle) == LSQ_HandleInvalid)
+
+#define RADIX_LEVELS 4
+#define RADIX_DIGIT_BITS 8
+#define RADIX_FANOUT (1 << RADIX_DIGIT_BITS)
+#define RADIX_SIGN_FLIP 0x80000000u
+#define RADIX_MAX_BITS 0xFFFFFFFFu
+/* A sparse node becomes full when it needs more children, a full node becomes sparse at the shrink limit */
+#define SPARSE_NODE_CAPACITY 16
+#define SPARSE_NODE_SHRINK_LIMIT 8
+#define LEAF_MIN_CAPACITY 4
+#define LEAF_WORDS (RADIX_FANOUT / 64)
+
+typedef enum
+{
+	IST_BEFORE_FIRST,
+	IST_DEREFERENCABLE,
+	IST_PAST_REAR,
+} IteratorStateT;
+
+typedef enum
+{
+	NK_SPARSE,
+	NK_FULL,
+} NodeKindT;
+
+typedef struct
+{
+	NodeKindT kind;
+	int count;
+	/* Sorted digits of the children of a sparse node, unused in a full node */
+	unsigned char digits[SPARSE_NODE_CAPACITY];
+	/* A sparse node keeps count children in digit order, a full node is indexed by the digit */
+	void * children[];
+} InnerNodeT;
+
+typedef struct
+{
+	unsigned long long bitmap[LEAF_WORDS];
+	int count;
+	int capacity;
+	LSQ_BaseTypeT values[];
+} LeafNodeT;
+
+typedef struct
+{
+	InnerNodeT * root;
+	int size;
+	const LSQ_AllocatorT * allocator;
+} RadixTreeT;
+
+typedef struct
+{
+	RadixTreeT * tree;
+	/* Key of the element with the sign bit flipped, so that unsigned order matches key order */
+	unsigned int bits;
+	IteratorStateT state;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static __inline unsigned int keyBits(LSQ_IntegerIndexT key);
+static __inline LSQ_IntegerIndexT bitsKey(unsigned int bits);
+static __inline int digitShift(int level);
+static __inline int keyDigit(unsigned int bits, int level);
+static __inline size_t innerNodeBytes(NodeKindT kind);
+static __inline size_t leafNodeBytes(int capacity);
+static __inline int leafBit(const LeafNodeT * leaf, int digit);
+static __inline int leafRank(const LeafNodeT * leaf, int digit);
+static InnerNodeT * createInnerNode(RadixTreeT * tree);
+static LeafNodeT * createLeafNode(RadixTreeT * tree);
+static void destroySubtree(RadixTreeT * tree, void * node, int level);
+static void ** findChild(InnerNodeT * node, int digit);
+static int addChild(RadixTreeT * tree, InnerNodeT ** node_ptr, int digit, void * child);
+static void removeChild(RadixTreeT * tree, InnerNodeT ** node_ptr, int digit);
+static void * childNeighbour(const InnerNodeT * node, int digit, int direction, int * child_digit);
+static int leafNeighbour(const LeafNodeT * leaf, int digit, int direction);
+static int findNeighbour(const void * node, int level, unsigned int bits, int bounded, int direction,
+	unsigned int prefix, unsigned int * found);
+static int findKey(const RadixTreeT * tree, unsigned int bits, int direction, unsigned int * found);
+static LSQ_BaseTypeT * findValue(const RadixTreeT * tree, unsigned int bits);
+static int insertIntoLeaf(RadixTreeT * tree, LeafNodeT ** leaf_ptr, int digit, LSQ_BaseTypeT value);
+static int eraseFromLeaf(RadixTreeT * tree, LeafNodeT ** leaf_ptr, int digit);
+static int eraseKey(RadixTreeT * tree, void ** node_ptr, int level, unsigned int bits);
+static IteratorT * createIterator(LSQ_HandleT handle, unsigned int bits, IteratorStateT state);
+
+static __inline unsigned int keyBits(LSQ_IntegerIndexT key)
+{
+	return (unsigned int)key ^ RADIX_SIGN_FLIP;
+}
+
+static __inline LSQ_IntegerIndexT bitsKey(unsigned int bits)
+{
+	return (LSQ_IntegerIndexT)(bits ^ RADIX_SIGN_FLIP);
+}
+
+static __inline int digitShift(int level)
+{
+	return (RADIX_LEVELS - 1 - level) * RADIX_DIGIT_BITS;
+}
+
+static __inline int keyDigit(unsigned int bits, int level)
+{
+	return (int)((bits >> digitShift(level)) & (RADIX_FANOUT - 1));
+}
+
+static __inline size_t innerNodeBytes(NodeKindT kind)
+{
+	return offsetof(InnerNodeT, children) + (kind == NK_FULL ? RADIX_FANOUT : SPARSE_NODE_CAPACITY) * sizeof(void *);
+}
+
+static __inline size_t leafNodeBytes(int capacity)
+{
+	return offsetof(LeafNodeT, values) + capacity * sizeof(LSQ_BaseTypeT);
+}
+
+static __inline int leafBit(const LeafNodeT * leaf, int digit)
+{
+	return (int)((leaf->bitmap[digit >> 6] >> (digit & 63)) & 1);
+}
+
+/* Number of present digits below the given one, i.e. the position of its value */
+static __inline int leafRank(const LeafNodeT * leaf, int digit)
+{
+	int word, rank = 0;
+	for (word = 0; word < (digit >> 6); word++)
+		rank += __builtin_popcountll(leaf->bitmap[word]);
+	if ((digit & 63) != 0)
+		rank += __builtin_popcountll(leaf->bitmap[word] & ((1ULL << (digit & 63)) - 1));
+	return rank;
+}
+
+static InnerNodeT * createInnerNode(RadixTreeT * tree)
+{
+	InnerNodeT * node = (InnerNodeT *)lsqAllocate(tree->allocator, innerNodeBytes(NK_SPARSE));
+	if (node == NULL)
+		return NULL;
+	node->kind = NK_SPARSE;
+	node->count = 0;
+	return node;
+}
+
+static LeafNodeT * createLeafNode(RadixTreeT * tree)
+{
+	LeafNodeT * leaf = (LeafNodeT *)lsqAllocate(tree->allocator, leafNodeBytes(LEAF_MIN_CAPACITY));
+	if (leaf == NULL)
+		return NULL;
+	memset(leaf->bitmap, 0, sizeof(leaf->bitmap));
+	leaf->count = 0;
+	leaf->capacity = LEAF_MIN_CAPACITY;
+	return leaf;
+}
+
+static void destroySubtree(RadixTreeT * tree, void * node, int level)
+{
+	InnerNodeT * inner = (InnerNodeT *)node;
+	int i;
+	if (node == NULL)
+		return;
+	if (level == RADIX_LEVELS - 1)
+	{
+		lsqDeallocate(tree->allocator, node, leafNodeBytes(((LeafNodeT *)node)->capacity));
+		return;
+	}
+	for (i = 0; i < (inner->kind == NK_FULL ? RADIX_FANOUT : inner->count); i++)
+		destroySubtree(tree, inner->children[i], level + 1);
+	lsqDeallocate(tree->allocator, inner, innerNodeBytes(inner->kind));
+}
+
+/* Returns the location of the child pointer for the digit, or NULL if the node has no such child */
+static void ** findChild(InnerNodeT * node, int digit)
+{
+	int i;
+	if (node->kind == NK_FULL)
+		return (node->children[digit] != NULL) ? &node->children[digit] : NULL;
+	for (i = 0; i < node->count && node->digits[i] <= digit; i++)
+		if (node->digits[i] == digit)
+			return &node->children[i];
+	return NULL;
+}
+
+static int addChild(RadixTreeT * tree, InnerNodeT ** node_ptr, int digit, void * child)
+{
+	InnerNodeT * node = *node_ptr, * full = NULL;
+	int i;
+	if (node->kind == NK_SPARSE && node->count == SPARSE_NODE_CAPACITY)
+	{
+		full = (InnerNodeT *)lsqAllocate(tree->allocator, innerNodeBytes(NK_FULL));
+		if (full == NULL)
+			return 0;
+		full->kind = NK_FULL;
+		full->count = node->count;
+		memset(full->children, 0, RADIX_FANOUT * sizeof(void *));
+		for (i = 0; i < node->count; i++)
+			full->children[node->digits[i]] = node->children[i];
+		lsqDeallocate(tree->allocator, node, innerNodeBytes(NK_SPARSE));
+		*node_ptr = node = full;
+	}
+	node->count++;
+	if (node->kind == NK_FULL)
+	{
+		node->children[digit] = child;
+		return 1;
+	}
+	for (i = node->count - 1; i > 0 && node->digits[i - 1] > digit; i--)
+	{
+		node->digits[i] = node->digits[i - 1];
+		node->children[i] = node->children[i - 1];
+	}
+	node->digits[i] = (unsigned char)digit;
+	node->children[i] = child;
+	return 1;
+}
+
+static void removeChild(RadixTreeT * tree, InnerNodeT ** node_ptr, int digit)
+{
+	InnerNodeT * node = *node_ptr, * sparse = NULL;
+	int i, j;
+	node->count--;
+	if (node->kind == NK_SPARSE)
+	{
+		for (i = 0; node->digits[i] != digit; i++)
+			;
+		for (; i < node->count; i++)
+		{
+			node->digits[i] = node->digits[i + 1];
+			node->children[i] = node->children[i + 1];
+		}
+		return;
+	}
+	node->children[digit] = NULL;
+	if (node->count > SPARSE_NODE_SHRINK_LIMIT)
+		return;
+	sparse = (InnerNodeT *)lsqAllocate(tree->allocator, innerNodeBytes(NK_SPARSE));
+	if (sparse == NULL)
+		return;
+	sparse->kind = NK_SPARSE;
+	sparse->count = node->count;
+	for (i = 0, j = 0; i < RADIX_FANOUT; i++)
+	{
+		if (node->children[i] == NULL)
+			continue;
+		sparse->digits[j] = (unsigned char)i;
+		sparse->children[j++] = node->children[i];
+	}
+	lsqDeallocate(tree->allocator, node, innerNodeBytes(NK_FULL));
+	*node_ptr = sparse;
+}
+
+/* Returns the child with the closest digit not before the given one in the direction (+1 or -1) */
+static void * childNeighbour(const InnerNodeT * node, int digit, int direction, int * child_digit)
+{
+	int i;
+	if (node->kind == NK_FULL)
+	{
+		for (i = digit; i >= 0 && i < RADIX_FANOUT; i += direction)
+		{
+			if (node->children[i] != NULL)
+			{
+				*child_digit = i;
+				return node->children[i];
+			}
+		}
+		return NULL;
+	}
+	if (direction > 0)
+	{
+		for (i = 0; i < node->count && node->digits[i] < digit; i++)
+			;
+		if (i == node->count)
+			return NULL;
+	}
+	else
+	{
+		for (i = node->count - 1; i >= 0 && node->digits[i] > digit; i--)
+			;
+		if (i < 0)
+			return NULL;
+	}
+	*child_digit = node->digits[i];
+	return node->children[i];
+}
+
+/* Returns the closest present digit not before the given one in the direction, or -1 */
+static int leafNeighbour(const LeafNodeT * leaf, int digit, int direction)
+{
+	int word = digit >> 6;
+	unsigned long long mask;
+	if (direction > 0)
+	{
+		for (mask = leaf->bitmap[word] & (~0ULL << (digit & 63)); mask == 0; mask = leaf->bitmap[word])
+			if (++word == LEAF_WORDS)
+				return -1;
+		return (word << 6) + __builtin_ctzll(mask);
+	}
+	for (mask = leaf->bitmap[word] & (~0ULL >> (63 - (digit & 63))); mask == 0; mask = leaf->bitmap[word])
+		if (--word < 0)
+			return -1;
+	return (word << 6) + 63 - __builtin_clzll(mask);
+}
+
+/* Finds the closest key to bits in the direction inside the subtree, bits itself included. When bounded is   *
+ * zero the subtree lies entirely on the far side of bits and its first key in the direction is the answer.   */
+static int findNeighbour(const void * node, int level, unsigned int bits, int bounded, int direction,
+	unsigned int prefix, unsigned int * found)
+{
+	int digit = bounded ? keyDigit(bits, level) : (direction > 0 ? 0 : RADIX_FANOUT - 1), child_digit;
+	const void * child = NULL;
+	if (level == RADIX_LEVELS - 1)
+	{
+		digit = leafNeighbour((const LeafNodeT *)node, digit, direction);
+		if (digit < 0)
+			return 0;
+		*found = prefix | (unsigned int)digit;
+		return 1;
+	}
+	while ((child = childNeighbour((const InnerNodeT *)node, digit, direction, &child_digit)) != NULL)
+	{
+		if (findNeighbour(child, level + 1, bits, bounded && child_digit == digit, direction,
+			prefix | ((unsigned int)child_digit << digitShift(level)), found))
+			return 1;
+		bounded = 0;
+		digit = child_digit + direction;
+		if (digit < 0 || digit >= RADIX_FANOUT)
+			break;
+	}
+	return 0;
+}
+
+static int findKey(const RadixTreeT * tree, unsigned int bits, int direction, unsigned int * found)
+{
+	return tree->root != NULL && findNeighbour(tree->root, 0, bits, 1, direction, 0, found);
+}
+
+static LSQ_BaseTypeT * findValue(const RadixTreeT * tree, unsigned int bits)
+{
+	void * node = tree->root;
+	void ** child = NULL;
+	LeafNodeT * leaf = NULL;
+	int level, digit = keyDigit(bits, RADIX_LEVELS - 1);
+	for (level = 0; level < RADIX_LEVELS - 1; level++)
+	{
+		if (node == NULL || (child = findChild((InnerNodeT *)node, keyDigit(bits, level))) == NULL)
+			return NULL;
+		node = *child;
+	}
+	leaf = (LeafNodeT *)node;
+	return leafBit(leaf, digit) ? &leaf->values[leafRank(leaf, digit)] : NULL;
+}
+
+static int insertIntoLeaf(RadixTreeT * tree, LeafNodeT ** leaf_ptr, int digit, LSQ_BaseTypeT value)
+{
+	LeafNodeT * leaf = *leaf_ptr, * grown = NULL;
+	int rank = leafRank(leaf, digit), new_capacity;
+	if (leafBit(leaf, digit))
+	{
+		leaf->values[rank] = value;
+		return 1;
+	}
+	if (leaf->count == leaf->capacity)
+	{
+		new_capacity = (leaf->capacity * 2 < RADIX_FANOUT) ? leaf->capacity * 2 : RADIX_FANOUT;
+		grown = (LeafNodeT *)lsqReallocate(tree->allocator, leaf, leafNodeBytes(leaf->capacity),
+			leafNodeBytes(new_capacity));
+		if (grown == NULL)
+			return 0;
+		grown->capacity = new_capacity;
+		*leaf_ptr = leaf = grown;
+	}
+	memmove(&leaf->values[rank + 1], &leaf->values[rank], (leaf->count - rank) * sizeof(LSQ_BaseTypeT));
+	leaf->values[rank] = value;
+	leaf->bitmap[digit >> 6] |= 1ULL << (digit & 63);
+	leaf->count++;
+	tree->size++;
+	return 1;
+}
+
+/* Returns 1 if the leaf became empty and was freed */
+static int eraseFromLeaf(RadixTreeT * tree, LeafNodeT ** leaf_ptr, int digit)
+{
+	LeafNodeT * leaf = *leaf_ptr, * shrunk = NULL;
+	int rank;
+	if (!leafBit(leaf, digit))
+		return 0;
+	rank = leafRank(leaf, digit);
+	memmove(&leaf->values[rank], &leaf->values[rank + 1], (leaf->count - rank - 1) * sizeof(LSQ_BaseTypeT));
+	leaf->bitmap[digit >> 6] &= ~(1ULL << (digit & 63));
+	leaf->count--;
+	tree->size--;
+	if (leaf->count == 0)
+	{
+		lsqDeallocate(tree->allocator, leaf, leafNodeBytes(leaf->capacity));
+		*leaf_ptr = NULL;
+		return 1;
+	}
+	if (leaf->capacity > LEAF_MIN_CAPACITY && leaf->count <= leaf->capacity / 4)
+	{
+		shrunk = (LeafNodeT *)lsqReallocate(tree->allocator, leaf, leafNodeBytes(leaf->capacity),
+			leafNodeBytes(leaf->capacity / 2));
+		if (shrunk != NULL)
+		{
+			shrunk->capacity /= 2;
+			*leaf_ptr = shrunk;
+		}
+	}
+	return 0;
+}
+
+/* Returns 1 if the subtree became empty and was freed */
+static int eraseKey(RadixTreeT * tree, void ** node_ptr, int level, unsigned int bits)
+{
+	InnerNodeT ** inner_ptr = (InnerNodeT **)node_ptr;
+	void ** child = NULL;
+	int digit = keyDigit(bits, level);
+	if (level == RADIX_LEVELS - 1)
+		return eraseFromLeaf(tree, (LeafNodeT **)node_ptr, digit);
+	child = findChild(*inner_ptr, digit);
+	if (child == NULL || !eraseKey(tree, child, level + 1, bits))
+		return 0;
+	removeChild(tree, inner_ptr, digit);
+	if ((*inner_ptr)->count > 0)
+		return 0;
+	lsqDeallocate(tree->allocator, *inner_ptr, innerNodeBytes((*inner_ptr)->kind));
+	*inner_ptr = NULL;
+	return 1;
+}
+
+static IteratorT * createIterator(LSQ_HandleT handle, unsigned int bits, IteratorStateT state)
+{
+	RadixTreeT * tree = (RadixTreeT *)handle;
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(tree->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = tree->allocator;
+	iterator->tree = tree;
+	iterator->bits = bits;
+	iterator->state = state;
+	return iterator;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	RadixTreeT * tree = (RadixTreeT *)lsqAllocate(allocator, sizeof(RadixTreeT));
+	if (tree == NULL)
+		return LSQ_HandleInvalid;
+	tree->allocator = allocator;
+	tree->root = NULL;
+	tree->size = 0;
+	return tree;
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	RadixTreeT * tree = (RadixTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(tree->allocator))
+		return;
+	destroySubtree(tree, tree->root, 0);
+	lsqDeallocate(tree->allocator, tree, sizeof(RadixTreeT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? -1 : ((RadixTreeT *)handle)->size;
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_DEREFERENCABLE;
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_PAST_REAR;
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_BEFORE_FIRST;
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !LSQ_IsIteratorDereferencable(iterator) ? NULL : findValue(iter->tree, iter->bits);
+}
+
+extern LSQ_IntegerIndexT LSQ_GetIteratorKey(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	assert(LSQ_IsIteratorDereferencable(iterator));
+	return bitsKey(iter->bits);
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	if (findValue((RadixTreeT *)handle, keyBits(index)) == NULL)
+		return LSQ_GetPastRearElement(handle);
+	return createIterator(handle, keyBits(index), IST_DEREFERENCABLE);
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	IteratorT * iterator = createIterator(handle, 0, IST_BEFORE_FIRST);
+	LSQ_AdvanceOneElement(iterator);
+	return iterator;
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	return createIterator(handle, RADIX_MAX_BITS, IST_PAST_REAR);
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	int has_next;
+	if (IS_HANDLE_INVALID(iterator) || LSQ_IsIteratorPastRear(iterator))
+		return;
+	if (LSQ_IsIteratorBeforeFirst(iterator))
+		has_next = findKey(iter->tree, 0, 1, &iter->bits);
+	else
+		has_next = iter->bits != RADIX_MAX_BITS && findKey(iter->tree, iter->bits + 1, 1, &iter->bits);
+	iter->state = has_next ? IST_DEREFERENCABLE : IST_PAST_REAR;
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	int has_previous;
+	if (IS_HANDLE_INVALID(iterator) || LSQ_IsIteratorBeforeFirst(iterator))
+		return;
+	if (LSQ_IsIteratorPastRear(iterator))
+		has_previous = findKey(iter->tree, RADIX_MAX_BITS, -1, &iter->bits);
+	else
+		has_previous = iter->bits != 0 && findKey(iter->tree, iter->bits - 1, -1, &iter->bits);
+	iter->state = has_previous ? IST_DEREFERENCABLE : IST_BEFORE_FIRST;
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	for(; shift > 0; shift--)
+		LSQ_AdvanceOneElement(iterator);
+	for(; shift < 0; shift++)
+		LSQ_RewindOneElement(iterator);
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter->state = IST_BEFORE_FIRST;
+	LSQ_ShiftPosition(iterator, pos + 1);
+}
+
+extern void LSQ_InsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	RadixTreeT * tree = (RadixTreeT *)handle;
+	unsigned int bits = keyBits(key);
+	void ** node_ptr = NULL, ** child = NULL;
+	void * new_node = NULL;
+	int level, digit;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	if (tree->root == NULL && (tree->root = createInnerNode(tree)) == NULL)
+		return;
+	node_ptr = (void **)&tree->root;
+	for (level = 0; level < RADIX_LEVELS - 1; level++)
+	{
+		digit = keyDigit(bits, level);
+		child = findChild((InnerNodeT *)*node_ptr, digit);
+		if (child == NULL)
+		{
+			if (level < RADIX_LEVELS - 2)
+				new_node = createInnerNode(tree);
+			else
+				new_node = createLeafNode(tree);
+			if (new_node == NULL)
+				return;
+			if (!addChild(tree, (InnerNodeT **)node_ptr, digit, new_node))
+			{
+				destroySubtree(tree, new_node, level + 1);
+				return;
+			}
+			child = findChild((InnerNodeT *)*node_ptr, digit);
+		}
+		node_ptr = child;
+	}
+	insertIntoLeaf(tree, (LeafNodeT **)node_ptr, keyDigit(bits, RADIX_LEVELS - 1), value);
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	RadixTreeT * tree = (RadixTreeT *)handle;
+	unsigned int bits;
+	if (IS_HANDLE_INVALID(handle) || !findKey(tree, 0, 1, &bits))
+		return;
+	eraseKey(tree, (void **)&tree->root, 0, bits);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	RadixTreeT * tree = (RadixTreeT *)handle;
+	unsigned int bits;
+	if (IS_HANDLE_INVALID(handle) || !findKey(tree, RADIX_MAX_BITS, -1, &bits))
+		return;
+	eraseKey(tree, (void **)&tree->root, 0, bits);
+}
+
+extern void LSQ_DeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key)
+{
+	RadixTreeT * tree = (RadixTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || tree->root == NULL)
+		return;
+	eraseKey(tree, (void **)&tree->root, 0, keyBits(key));
+}
@@ -0,0 +1,652 @@
+#include <assert.h>
+#include <sched.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "linear_sequence_assoc.h"
+#include "linear_sequence_allocator.h"
+
+/* Ordered associative array on a concurrent skip list (lazy skip list of Herlihy, Lev, Luchangco and Shavit).      *
+ * LSQ_InsertElement, LSQ_DeleteElement, lookups and iteration may run from any number of threads at once. Lookups   *
+ * and iterators never lock; writers lock only the predecessors of the node they change.                             *
+ * Iteration is weakly consistent: it returns keys in ascending order, skips deleted nodes and may or may not see    *
+ * concurrent inserts. Unlinked nodes are reclaimed with epochs: every operation and every live iterator pins the    *
+ * epoch it started in, so a long-lived iterator delays reclamation until it is destroyed.                           *
+ * Overwriting the value of an existing key is a single atomic store; a value read through LSQ_DereferenceIterator   *
+ * is therefore either the old or the new one. LSQ_DestroySequence must not run concurrently with other calls.       *
+ * Writers call the allocator concurrently, so an allocator passed to LSQ_CreateSequenceWithAllocator must be        *
+ * thread-safe; the arena of linear_sequence_arena.h is not. Running out of memory drops the insertion or makes the  *
+ * lookup return LSQ_HandleInvalid.                                                                                   */
+
+#define IS_HANDLE_INVALID(handle)        ((handle) == LSQ_HandleInvalid)
+
+#define SKIP_LIST_MAX_LEVEL 32
+#define SKIP_LIST_RECLAIM_BATCH 64
+#define SKIP_LIST_EPOCH_COUNT 3
+
+typedef enum
+{
+	IST_BEFORE_FIRST,
+	IST_DEREFERENCABLE,
+	IST_PAST_REAR,
+} IteratorStateT;
+
+typedef struct SkipNodeStruct
+{
+	LSQ_IntegerIndexT key;
+	LSQ_BaseTypeT value;
+	int top_level;
+	int lock;
+	int marked;
+	int fully_linked;
+	struct SkipNodeStruct * retired_next;
+	struct SkipNodeStruct * next[1];
+} SkipNodeT;
+
+typedef struct EpochRecordStruct
+{
+	struct EpochRecordStruct * next;
+	int in_use;
+	int active;
+	unsigned long epoch;
+} EpochRecordT;
+
+typedef struct
+{
+	SkipNodeT * head;
+	int size;
+	unsigned long id;
+	unsigned long global_epoch;
+	EpochRecordT * records;
+	int retire_lock;
+	SkipNodeT * retired[SKIP_LIST_EPOCH_COUNT];
+	int retired_count;
+	const LSQ_AllocatorT * allocator;
+} SkipListT;
+
+typedef struct
+{
+	SkipListT * list;
+	SkipNodeT * node;
+	IteratorStateT state;
+	EpochRecordT * record;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static unsigned long next_list_id = 1;
+static __thread unsigned long cached_list_id = 0;
+static __thread EpochRecordT * cached_record = NULL;
+static __thread unsigned int level_seed = 0;
+
+static __inline void spinLock(int * lock);
+static __inline void spinUnlock(int * lock);
+static __inline SkipNodeT * loadNext(SkipNodeT * node, int level);
+static __inline int isMarked(SkipNodeT * node);
+static int randomLevel(void);
+static __inline size_t nodeSize(int top_level);
+static SkipNodeT * createNode(SkipListT * list, LSQ_IntegerIndexT key, LSQ_BaseTypeT value, int top_level);
+static EpochRecordT * enterEpoch(SkipListT * list);
+static void leaveEpoch(EpochRecordT * record);
+static void retireNode(SkipListT * list, SkipNodeT * node);
+static void tryAdvanceEpoch(SkipListT * list);
+static void freeNodeChain(SkipListT * list, SkipNodeT * node);
+static int findNode(SkipListT * list, LSQ_IntegerIndexT key, SkipNodeT ** preds, SkipNodeT ** succs);
+static void unlockPredecessors(SkipNodeT ** preds, int highest_locked);
+static SkipNodeT * firstLiveNode(SkipNodeT * node);
+static SkipNodeT * lastLiveNodeBefore(SkipListT * list, SkipNodeT * bound);
+static IteratorT * createIterator(LSQ_HandleT handle, SkipNodeT * node, IteratorStateT state);
+
+static __inline void spinLock(int * lock)
+{
+	while (__atomic_exchange_n(lock, 1, __ATOMIC_ACQUIRE))
+		while (__atomic_load_n(lock, __ATOMIC_RELAXED))
+			sched_yield();
+}
+
+static __inline void spinUnlock(int * lock)
+{
+	__atomic_store_n(lock, 0, __ATOMIC_RELEASE);
+}
+
+static __inline SkipNodeT * loadNext(SkipNodeT * node, int level)
+{
+	return __atomic_load_n(&node->next[level], __ATOMIC_ACQUIRE);
+}
+
+static __inline int isMarked(SkipNodeT * node)
+{
+	return __atomic_load_n(&node->marked, __ATOMIC_ACQUIRE);
+}
+
+static int randomLevel(void)
+{
+	int level = 0;
+	unsigned int x = level_seed;
+	if (x == 0)
+		x = (unsigned int)(size_t)&level_seed ^ 0x9E3779B9u;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	level_seed = x;
+	while ((x & 3) == 0 && level < SKIP_LIST_MAX_LEVEL - 1)
+	{
+		level++;
+		x >>= 2;
+	}
+	return level;
+}
+
+static __inline size_t nodeSize(int top_level)
+{
+	return offsetof(SkipNodeT, next) + (top_level + 1) * sizeof(SkipNodeT *);
+}
+
+static SkipNodeT * createNode(SkipListT * list, LSQ_IntegerIndexT key, LSQ_BaseTypeT value, int top_level)
+{
+	SkipNodeT * node = (SkipNodeT *)lsqAllocate(list->allocator, nodeSize(top_level));
+	if (node == NULL)
+		return NULL;
+	node->key = key;
+	node->value = value;
+	node->top_level = top_level;
+	node->lock = 0;
+	node->marked = 0;
+	node->fully_linked = 0;
+	node->retired_next = NULL;
+	return node;
+}
+
+/* Pins the current epoch for the calling operation or iterator. Records are reused through in_use, *
+ * and each thread first retries the record it took last time from the same list. Returns NULL if a  *
+ * new record cannot be allocated.                                                                   */
+static EpochRecordT * enterEpoch(SkipListT * list)
+{
+	EpochRecordT * record = NULL, * head = NULL;
+	if (cached_list_id == list->id && __atomic_exchange_n(&cached_record->in_use, 1, __ATOMIC_ACQUIRE) == 0)
+		record = cached_record;
+	for (head = __atomic_load_n(&list->records, __ATOMIC_ACQUIRE); record == NULL && head != NULL; head = head->next)
+		if (__atomic_exchange_n(&head->in_use, 1, __ATOMIC_ACQUIRE) == 0)
+			record = head;
+	if (record == NULL)
+	{
+		record = (EpochRecordT *)lsqAllocate(list->allocator, sizeof(EpochRecordT));
+		if (record == NULL)
+			return NULL;
+		record->in_use = 1;
+		record->active = 0;
+		record->epoch = 0;
+		record->next = __atomic_load_n(&list->records, __ATOMIC_RELAXED);
+		while (!__atomic_compare_exchange_n(&list->records, &record->next, record, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+			;
+	}
+	cached_list_id = list->id;
+	cached_record = record;
+	__atomic_store_n(&record->active, 1, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&record->epoch, __atomic_load_n(&list->global_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+	return record;
+}
+
+static void leaveEpoch(EpochRecordT * record)
+{
+	__atomic_store_n(&record->active, 0, __ATOMIC_SEQ_CST);
+	__atomic_store_n(&record->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static void retireNode(SkipListT * list, SkipNodeT * node)
+{
+	unsigned long epoch;
+	spinLock(&list->retire_lock);
+	epoch = __atomic_load_n(&list->global_epoch, __ATOMIC_SEQ_CST);
+	node->retired_next = list->retired[epoch % SKIP_LIST_EPOCH_COUNT];
+	list->retired[epoch % SKIP_LIST_EPOCH_COUNT] = node;
+	if (++list->retired_count >= SKIP_LIST_RECLAIM_BATCH)
+		tryAdvanceEpoch(list);
+	spinUnlock(&list->retire_lock);
+}
+
+/* Called with retire_lock held. Once every active record has seen epoch E the epoch moves to E + 1 and *
+ * nodes retired in E - 1 can no longer be referenced by anyone.                                          */
+static void tryAdvanceEpoch(SkipListT * list)
+{
+	EpochRecordT * record = NULL;
+	SkipNodeT * node = NULL, * next = NULL;
+	unsigned long epoch = __atomic_load_n(&list->global_epoch, __ATOMIC_SEQ_CST);
+	for (record = __atomic_load_n(&list->records, __ATOMIC_ACQUIRE); record != NULL; record = record->next)
+		if (__atomic_load_n(&record->active, __ATOMIC_SEQ_CST) &&
+			__atomic_load_n(&record->epoch, __ATOMIC_SEQ_CST) != epoch)
+			return;
+	__atomic_store_n(&list->global_epoch, epoch + 1, __ATOMIC_SEQ_CST);
+	node = list->retired[(epoch + 2) % SKIP_LIST_EPOCH_COUNT];
+	list->retired[(epoch + 2) % SKIP_LIST_EPOCH_COUNT] = NULL;
+	for (; node != NULL; node = next)
+	{
+		next = node->retired_next;
+		lsqDeallocate(list->allocator, node, nodeSize(node->top_level));
+		list->retired_count--;
+	}
+}
+
+static void freeNodeChain(SkipListT * list, SkipNodeT * node)
+{
+	SkipNodeT * next = NULL;
+	for (; node != NULL; node = next)
+	{
+		next = node->retired_next;
+		lsqDeallocate(list->allocator, node, nodeSize(node->top_level));
+	}
+}
+
+static int findNode(SkipListT * list, LSQ_IntegerIndexT key, SkipNodeT ** preds, SkipNodeT ** succs)
+{
+	int level, found_level = -1;
+	SkipNodeT * pred = list->head, * curr = NULL;
+	for (level = SKIP_LIST_MAX_LEVEL - 1; level >= 0; level--)
+	{
+		curr = loadNext(pred, level);
+		while (curr != NULL && curr->key < key)
+		{
+			pred = curr;
+			curr = loadNext(pred, level);
+		}
+		if (found_level == -1 && curr != NULL && curr->key == key)
+			found_level = level;
+		preds[level] = pred;
+		succs[level] = curr;
+	}
+	return found_level;
+}
+
+static void unlockPredecessors(SkipNodeT ** preds, int highest_locked)
+{
+	int level;
+	for (level = 0; level <= highest_locked; level++)
+		if (level == 0 || preds[level] != preds[level - 1])
+			spinUnlock(&preds[level]->lock);
+}
+
+static SkipNodeT * firstLiveNode(SkipNodeT * node)
+{
+	while (node != NULL && (isMarked(node) || !__atomic_load_n(&node->fully_linked, __ATOMIC_ACQUIRE)))
+		node = loadNext(node, 0);
+	return node;
+}
+
+/* Returns the last live node with a key below bound->key, or the last live node at all if bound is NULL */
+static SkipNodeT * lastLiveNodeBefore(SkipListT * list, SkipNodeT * bound)
+{
+	SkipNodeT * preds[SKIP_LIST_MAX_LEVEL], * succs[SKIP_LIST_MAX_LEVEL];
+	SkipNodeT * pred = list->head, * curr = NULL;
+	int level;
+	if (bound != NULL)
+	{
+		findNode(list, bound->key, preds, succs);
+		pred = preds[0];
+	}
+	else
+	{
+		for (level = SKIP_LIST_MAX_LEVEL - 1; level >= 0; level--)
+			for (curr = loadNext(pred, level); curr != NULL; curr = loadNext(pred, level))
+				pred = curr;
+	}
+	while (pred != list->head && (isMarked(pred) || !__atomic_load_n(&pred->fully_linked, __ATOMIC_ACQUIRE)))
+	{
+		findNode(list, pred->key, preds, succs);
+		pred = preds[0];
+	}
+	return (pred == list->head) ? NULL : pred;
+}
+
+static IteratorT * createIterator(LSQ_HandleT handle, SkipNodeT * node, IteratorStateT state)
+{
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(((SkipListT *)handle)->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = ((SkipListT *)handle)->allocator;
+	iterator->list = (SkipListT *)handle;
+	iterator->node = node;
+	iterator->state = (state == IST_DEREFERENCABLE && node == NULL) ? IST_PAST_REAR : state;
+	iterator->record = NULL;
+	return iterator;
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	SkipListT * list = (SkipListT *)lsqAllocate(allocator, sizeof(SkipListT));
+	int level;
+	if (list == NULL)
+		return LSQ_HandleInvalid;
+	list->allocator = allocator;
+	list->head = createNode(list, 0, 0, SKIP_LIST_MAX_LEVEL - 1);
+	if (list->head == NULL)
+	{
+		lsqDeallocate(allocator, list, sizeof(SkipListT));
+		return LSQ_HandleInvalid;
+	}
+	for (level = 0; level < SKIP_LIST_MAX_LEVEL; level++)
+		list->head->next[level] = NULL;
+	list->head->fully_linked = 1;
+	list->size = 0;
+	list->id = __atomic_fetch_add(&next_list_id, 1, __ATOMIC_RELAXED);
+	list->global_epoch = 0;
+	list->records = NULL;
+	list->retire_lock = 0;
+	for (level = 0; level < SKIP_LIST_EPOCH_COUNT; level++)
+		list->retired[level] = NULL;
+	list->retired_count = 0;
+	return list;
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	SkipListT * list = (SkipListT *)handle;
+	SkipNodeT * node = NULL, * next = NULL;
+	EpochRecordT * record = NULL, * next_record = NULL;
+	int i;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	if (cached_list_id == list->id)
+		cached_list_id = 0;
+	if (lsqReleasesInBulk(list->allocator))
+		return;
+	for (node = list->head; node != NULL; node = next)
+	{
+		next = node->next[0];
+		lsqDeallocate(list->allocator, node, nodeSize(node->top_level));
+	}
+	for (i = 0; i < SKIP_LIST_EPOCH_COUNT; i++)
+		freeNodeChain(list, list->retired[i]);
+	for (record = list->records; record != NULL; record = next_record)
+	{
+		next_record = record->next;
+		lsqDeallocate(list->allocator, record, sizeof(EpochRecordT));
+	}
+	lsqDeallocate(list->allocator, list, sizeof(SkipListT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? -1 : __atomic_load_n(&((SkipListT *)handle)->size, __ATOMIC_RELAXED);
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_DEREFERENCABLE;
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_PAST_REAR;
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_BEFORE_FIRST;
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !LSQ_IsIteratorDereferencable(iterator) ? NULL : &iter->node->value;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetIteratorKey(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	assert(LSQ_IsIteratorDereferencable(iterator));
+	return iter->node->key;
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	SkipListT * list = (SkipListT *)handle;
+	SkipNodeT * preds[SKIP_LIST_MAX_LEVEL], * succs[SKIP_LIST_MAX_LEVEL], * node = NULL;
+	IteratorT * iter = NULL;
+	EpochRecordT * record = NULL;
+	int found_level;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	record = enterEpoch(list);
+	if (record == NULL)
+		return LSQ_HandleInvalid;
+	found_level = findNode(list, index, preds, succs);
+	if (found_level != -1 && __atomic_load_n(&succs[found_level]->fully_linked, __ATOMIC_ACQUIRE) &&
+		!isMarked(succs[found_level]))
+		node = succs[found_level];
+	iter = createIterator(handle, node, IST_DEREFERENCABLE);
+	if (iter == NULL)
+		leaveEpoch(record);
+	else
+		iter->record = record;
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	SkipListT * list = (SkipListT *)handle;
+	IteratorT * iter = NULL;
+	EpochRecordT * record = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	record = enterEpoch(list);
+	if (record == NULL)
+		return LSQ_HandleInvalid;
+	iter = createIterator(handle, firstLiveNode(loadNext(list->head, 0)), IST_DEREFERENCABLE);
+	if (iter == NULL)
+		leaveEpoch(record);
+	else
+		iter->record = record;
+	return iter;
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	IteratorT * iter = NULL;
+	EpochRecordT * record = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	record = enterEpoch((SkipListT *)handle);
+	if (record == NULL)
+		return LSQ_HandleInvalid;
+	iter = createIterator(handle, NULL, IST_PAST_REAR);
+	if (iter == NULL)
+		leaveEpoch(record);
+	else
+		iter->record = record;
+	return iter;
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	leaveEpoch(iter->record);
+	lsqDeallocate(iter->allocator, iter, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || iter->state == IST_PAST_REAR)
+		return;
+	iter->node = firstLiveNode(loadNext(iter->state == IST_BEFORE_FIRST ? iter->list->head : iter->node, 0));
+	iter->state = (iter->node != NULL) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || iter->state == IST_BEFORE_FIRST)
+		return;
+	iter->node = lastLiveNodeBefore(iter->list, iter->state == IST_PAST_REAR ? NULL : iter->node);
+	iter->state = (iter->node != NULL) ? IST_DEREFERENCABLE : IST_BEFORE_FIRST;
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	for(; shift > 0; shift--)
+		LSQ_AdvanceOneElement(iterator);
+	for(; shift < 0; shift++)
+		LSQ_RewindOneElement(iterator);
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter->node = NULL;
+	iter->state = IST_BEFORE_FIRST;
+	LSQ_ShiftPosition(iterator, pos + 1);
+}
+
+extern void LSQ_InsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	SkipListT * list = (SkipListT *)handle;
+	SkipNodeT * preds[SKIP_LIST_MAX_LEVEL], * succs[SKIP_LIST_MAX_LEVEL];
+	SkipNodeT * node = NULL, * pred = NULL, * succ = NULL;
+	EpochRecordT * record = NULL;
+	int top_level, found_level, highest_locked, level, valid;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	top_level = randomLevel();
+	record = enterEpoch(list);
+	if (record == NULL)
+		return;
+	for (;;)
+	{
+		found_level = findNode(list, key, preds, succs);
+		if (found_level != -1)
+		{
+			node = succs[found_level];
+			if (!isMarked(node))
+			{
+				while (!__atomic_load_n(&node->fully_linked, __ATOMIC_ACQUIRE))
+					sched_yield();
+				__atomic_store_n(&node->value, value, __ATOMIC_RELEASE);
+				break;
+			}
+			continue;
+		}
+		highest_locked = -1;
+		valid = 1;
+		for (level = 0; valid && level <= top_level; level++)
+		{
+			pred = preds[level];
+			succ = succs[level];
+			if (level == 0 || pred != preds[level - 1])
+				spinLock(&pred->lock);
+			highest_locked = level;
+			valid = !isMarked(pred) && (succ == NULL || !isMarked(succ)) && loadNext(pred, level) == succ;
+		}
+		if (!valid)
+		{
+			unlockPredecessors(preds, highest_locked);
+			continue;
+		}
+		node = createNode(list, key, value, top_level);
+		if (node == NULL)
+		{
+			unlockPredecessors(preds, highest_locked);
+			break;
+		}
+		for (level = 0; level <= top_level; level++)
+			node->next[level] = succs[level];
+		for (level = 0; level <= top_level; level++)
+			__atomic_store_n(&preds[level]->next[level], node, __ATOMIC_RELEASE);
+		__atomic_store_n(&node->fully_linked, 1, __ATOMIC_RELEASE);
+		unlockPredecessors(preds, highest_locked);
+		__atomic_fetch_add(&list->size, 1, __ATOMIC_RELAXED);
+		break;
+	}
+	leaveEpoch(record);
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	IteratorT * iterator = (IteratorT *)LSQ_GetFrontElement(handle);
+	if (LSQ_IsIteratorDereferencable(iterator))
+		LSQ_DeleteElement(handle, iterator->node->key);
+	LSQ_DestroyIterator(iterator);
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	IteratorT * iterator = (IteratorT *)LSQ_GetPastRearElement(handle);
+	LSQ_RewindOneElement(iterator);
+	if (LSQ_IsIteratorDereferencable(iterator))
+		LSQ_DeleteElement(handle, iterator->node->key);
+	LSQ_DestroyIterator(iterator);
+}
+
+extern void LSQ_DeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key)
+{
+	SkipListT * list = (SkipListT *)handle;
+	SkipNodeT * preds[SKIP_LIST_MAX_LEVEL], * succs[SKIP_LIST_MAX_LEVEL];
+	SkipNodeT * victim = NULL, * pred = NULL;
+	EpochRecordT * record = NULL;
+	int found_level, top_level = -1, highest_locked, level, valid, is_marked = 0;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	record = enterEpoch(list);
+	if (record == NULL)
+		return;
+	for (;;)
+	{
+		found_level = findNode(list, key, preds, succs);
+		if (!is_marked)
+		{
+			if (found_level == -1)
+				break;
+			victim = succs[found_level];
+			if (!__atomic_load_n(&victim->fully_linked, __ATOMIC_ACQUIRE) || victim->top_level != found_level ||
+				isMarked(victim))
+				break;
+			top_level = victim->top_level;
+			spinLock(&victim->lock);
+			if (isMarked(victim))
+			{
+				spinUnlock(&victim->lock);
+				break;
+			}
+			__atomic_store_n(&victim->marked, 1, __ATOMIC_RELEASE);
+			is_marked = 1;
+		}
+		highest_locked = -1;
+		valid = 1;
+		for (level = 0; valid && level <= top_level; level++)
+		{
+			pred = preds[level];
+			if (level == 0 || pred != preds[level - 1])
+				spinLock(&pred->lock);
+			highest_locked = level;
+			valid = !isMarked(pred) && loadNext(pred, level) == victim;
+		}
+		if (!valid)
+		{
+			unlockPredecessors(preds, highest_locked);
+			continue;
+		}
+		for (level = top_level; level >= 0; level--)
+			__atomic_store_n(&preds[level]->next[level], loadNext(victim, level), __ATOMIC_RELEASE);
+		spinUnlock(&victim->lock);
+		unlockPredecessors(preds, highest_locked);
+		__atomic_fetch_sub(&list->size, 1, __ATOMIC_RELAXED);
+		retireNode(list, victim);
+		break;
+	}
+	leaveEpoch(record);
+}
@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "linear_sequence_assoc.h"
+
+/* Multi-threaded stress test for skip_list.c. Every thread inserts, overwrites and deletes only the keys it owns, *
+ * those equal to its number modulo the thread count, and keeps a private copy of them; lookups and scans cover    *
+ * all keys. A thread checks that every value it reads belongs to its key, that scans return ascending keys, and   *
+ * that its own keys are found and scanned exactly as its copy says. After the threads finish, the list must hold  *
+ * the union of the copies. Build it with a sanitizer:                                                             *
+ *     cc -O1 -g -fsanitize=thread -pthread skip_list_stress.c skip_list.c -o stress_skip_list                     *
+ *     cc -O1 -g -fsanitize=address -pthread skip_list_stress.c skip_list.c -o stress_skip_list                    *
+ * Usage: stress [threads] [operations per thread] [key range] [scan length]                                       *
+ * The exit status is 0 if no check failed.                                                                        */
+
+#define STRESS_TAG_BITS 4
+
+typedef struct
+{
+	int thread_id;
+	int threads;
+	int operations;
+	int key_range;
+	int scan_length;
+	/* Value of each key of the thread plus one, 0 if the key is absent, indexed by key / threads */
+	LSQ_BaseTypeT * expected;
+	long long errors;
+} StressArgsT;
+
+static LSQ_HandleT map_handle = LSQ_HandleInvalid;
+
+static unsigned int nextRandom(unsigned int * state)
+{
+	unsigned int x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+static void reportError(StressArgsT * args, const char * message, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	if (args->errors++ < 10)
+		fprintf(stderr, "thread %d: %s, key %d, value %d\n", args->thread_id, message, key, value);
+}
+
+/* Reads the value of an iterator; other threads may overwrite it with an atomic store at the same time */
+static LSQ_BaseTypeT readValue(LSQ_IteratorT iterator)
+{
+	return __atomic_load_n(LSQ_DereferenceIterator(iterator), __ATOMIC_RELAXED);
+}
+
+/* Checks a value read for key: the value of a key is the key shifted left with a tag in the low bits */
+static void checkValue(StressArgsT * args, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	if (value >> STRESS_TAG_BITS != key)
+		reportError(args, "value of another key", key, value);
+}
+
+static void checkLookup(StressArgsT * args, LSQ_IntegerIndexT key)
+{
+	LSQ_IteratorT iterator = LSQ_GetElementByIndex(map_handle, key);
+	LSQ_BaseTypeT value = 0;
+	int owned = key % args->threads == args->thread_id;
+	if (iterator == LSQ_HandleInvalid)
+	{
+		reportError(args, "lookup failed", key, 0);
+		return;
+	}
+	if (LSQ_IsIteratorDereferencable(iterator))
+	{
+		if (LSQ_GetIteratorKey(iterator) != key)
+			reportError(args, "lookup found another key", key, LSQ_GetIteratorKey(iterator));
+		value = readValue(iterator);
+		checkValue(args, key, value);
+		if (owned && value + 1 != args->expected[key / args->threads])
+			reportError(args, "own key has a stale value or should be absent", key, value);
+	}
+	else if (owned && args->expected[key / args->threads] != 0)
+		reportError(args, "own key is missing", key, args->expected[key / args->threads] - 1);
+	LSQ_DestroyIterator(iterator);
+}
+
+/* Scans forward from key; own keys between two scanned keys must be absent */
+static void checkScan(StressArgsT * args, LSQ_IntegerIndexT key)
+{
+	LSQ_IteratorT iterator = LSQ_GetElementByIndex(map_handle, key);
+	LSQ_IntegerIndexT previous = key - 1, current = 0, own = 0;
+	LSQ_BaseTypeT value = 0;
+	int i;
+	if (iterator == LSQ_HandleInvalid)
+	{
+		reportError(args, "scan failed to start", key, 0);
+		return;
+	}
+	if (!LSQ_IsIteratorDereferencable(iterator))
+	{
+		/* An absent key gives no position to scan from */
+		LSQ_DestroyIterator(iterator);
+		checkLookup(args, key);
+		return;
+	}
+	for (i = 0; i < args->scan_length && LSQ_IsIteratorDereferencable(iterator); i++)
+	{
+		current = LSQ_GetIteratorKey(iterator);
+		if (current <= previous)
+			reportError(args, "scan is not ascending", current, previous);
+		value = readValue(iterator);
+		checkValue(args, current, value);
+		own = previous + 1 + (args->thread_id - (previous + 1) % args->threads + args->threads) % args->threads;
+		for (; own < current; own += args->threads)
+			if (args->expected[own / args->threads] != 0)
+				reportError(args, "scan skipped an own key", own, args->expected[own / args->threads] - 1);
+		if (current % args->threads == args->thread_id && args->expected[current / args->threads] == 0)
+			reportError(args, "scan returned a deleted own key", current, value);
+		previous = current;
+		LSQ_AdvanceOneElement(iterator);
+	}
+	LSQ_DestroyIterator(iterator);
+}
+
+static void * runWorker(void * arg)
+{
+	StressArgsT * args = (StressArgsT *)arg;
+	unsigned int seed = 2463534242u + 7919u * (unsigned int)args->thread_id;
+	int own_keys = (args->key_range - args->thread_id + args->threads - 1) / args->threads;
+	int i, op, key;
+	LSQ_BaseTypeT value;
+	for (i = 0; i < args->operations; i++)
+	{
+		op = (int)(nextRandom(&seed) % 100);
+		if (op < 60)
+		{
+			key = args->thread_id + args->threads * (int)(nextRandom(&seed) % (unsigned int)own_keys);
+			if (op < 35)
+			{
+				value = (key << STRESS_TAG_BITS) | (int)(nextRandom(&seed) % (1u << STRESS_TAG_BITS));
+				LSQ_InsertElement(map_handle, key, value);
+				args->expected[key / args->threads] = value + 1;
+			}
+			else
+			{
+				LSQ_DeleteElement(map_handle, key);
+				args->expected[key / args->threads] = 0;
+			}
+		}
+		else if (op < 90)
+			checkLookup(args, (int)(nextRandom(&seed) % (unsigned int)args->key_range));
+		else
+			checkScan(args, (int)(nextRandom(&seed) % (unsigned int)args->key_range));
+	}
+	return NULL;
+}
+
+/* Compares the final contents with the copies of all threads */
+static long long checkContents(StressArgsT * args, int threads, int key_range)
+{
+	LSQ_IteratorT iterator = LSQ_GetFrontElement(map_handle);
+	StressArgsT * owner = NULL;
+	long long errors = 0, count = 0;
+	int key;
+	for (key = 0; key < key_range; key++)
+	{
+		owner = &args[key % threads];
+		if (owner->expected[key / threads] == 0)
+			continue;
+		count++;
+		if (!LSQ_IsIteratorDereferencable(iterator) || LSQ_GetIteratorKey(iterator) != key)
+		{
+			reportError(owner, "key is missing from the final contents", key, owner->expected[key / threads] - 1);
+			errors++;
+			continue;
+		}
+		if (*LSQ_DereferenceIterator(iterator) + 1 != owner->expected[key / threads])
+		{
+			reportError(owner, "final value differs", key, *LSQ_DereferenceIterator(iterator));
+			errors++;
+		}
+		LSQ_AdvanceOneElement(iterator);
+	}
+	if (LSQ_IsIteratorDereferencable(iterator))
+	{
+		fprintf(stderr, "final contents hold an unexpected key %d\n", LSQ_GetIteratorKey(iterator));
+		errors++;
+	}
+	LSQ_DestroyIterator(iterator);
+	if (LSQ_GetSize(map_handle) != count)
+	{
+		fprintf(stderr, "final size %d, expected %lld\n", LSQ_GetSize(map_handle), count);
+		errors++;
+	}
+	return errors;
+}
+
+int main(int argc, char ** argv)
+{
+	int threads = (argc > 1) ? atoi(argv[1]) : 8;
+	int operations = (argc > 2) ? atoi(argv[2]) : 200000;
+	int key_range = (argc > 3) ? atoi(argv[3]) : 10000;
+	int scan_length = (argc > 4) ? atoi(argv[4]) : 50;
+	pthread_t * thread_ids = NULL;
+	StressArgsT * args = NULL;
+	long long errors = 0;
+	int i;
+
+	if (threads < 1 || operations < 1 || key_range < threads || key_range >= (1 << (30 - STRESS_TAG_BITS)))
+	{
+		fprintf(stderr, "usage: %s [threads] [operations] [key range] [scan length]\n", argv[0]);
+		return 1;
+	}
+	map_handle = LSQ_CreateSequence();
+	thread_ids = (pthread_t *)malloc(threads * sizeof(pthread_t));
+	args = (StressArgsT *)malloc(threads * sizeof(StressArgsT));
+	if (map_handle == LSQ_HandleInvalid || thread_ids == NULL || args == NULL)
+		return 1;
+
+	for (i = 0; i < threads; i++)
+	{
+		args[i].thread_id = i;
+		args[i].threads = threads;
+		args[i].operations = operations;
+		args[i].key_range = key_range;
+		args[i].scan_length = scan_length;
+		args[i].expected = (LSQ_BaseTypeT *)calloc(key_range / threads + 1, sizeof(LSQ_BaseTypeT));
+		args[i].errors = 0;
+		if (args[i].expected == NULL)
+			return 1;
+	}
+	for (i = 0; i < threads; i++)
+		pthread_create(&thread_ids[i], NULL, runWorker, &args[i]);
+	for (i = 0; i < threads; i++)
+	{
+		pthread_join(thread_ids[i], NULL);
+		errors += args[i].errors;
+	}
+	errors += checkContents(args, threads, key_range);
+
+	printf("threads %d, operations %lld, final size %d, errors %lld\n",
+		threads, (long long)threads * operations, LSQ_GetSize(map_handle), errors);
+	LSQ_DestroySequence(map_handle);
+	for (i = 0; i < threads; i++)
+		free(args[i].expected);
+	free(thread_ids);
+	free(args);
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,545 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "linear_sequence_assoc.h"
+#include "linear_sequence_allocator.h"
+#include "assoc_array_stats.h"
+
+/* Weak AVL tree (rank-balanced tree of Haeupler, Sen and Tarjan) with parent pointers. Every node has a rank, the *
+ * rank difference to each child is 1 or 2, missing children have rank -1 and leaves have rank 0. Insertions keep  *
+ * the tree an AVL tree; deletions make at most two rotations and O(1) amortised rank changes, and the height stays *
+ * within 2 log2(n) even after many deletions. Deleting a node with two children moves its successor node into its *
+ * place, so iterators to other elements stay valid.                                                                */
+
+#define IS_HANDLE_INVALID(handle)        ((handle) == LSQ_HandleInvalid)
+
+typedef enum
+{
+	IST_BEFORE_FIRST,
+	IST_DEREFERENCABLE,
+	IST_PAST_REAR,
+} IteratorStateT;
+
+typedef struct TreeNodeStruct
+{
+	struct TreeNodeStruct * l_child;
+	struct TreeNodeStruct * parent;
+	struct TreeNodeStruct * r_child;
+	int rank;
+	LSQ_IntegerIndexT key;
+	LSQ_BaseTypeT value;
+} TreeNodeT;
+
+typedef struct
+{
+	TreeNodeT * root;
+	int size;
+	unsigned long long rotations;
+	unsigned long long rebalance_steps;
+	const LSQ_AllocatorT * allocator;
+} WAVLTreeT;
+
+typedef struct
+{
+	WAVLTreeT * tree;
+	TreeNodeT * node;
+	IteratorStateT state;
+	const LSQ_AllocatorT * allocator;
+} IteratorT;
+
+static void treeWalkWithDestruction(WAVLTreeT * tree, TreeNodeT * root);
+static TreeNodeT * successor(TreeNodeT * node);
+static TreeNodeT * predecessor(TreeNodeT * node);
+static TreeNodeT * treeMaximum(TreeNodeT * root);
+static TreeNodeT * treeMinimum(TreeNodeT * root);
+static TreeNodeT * findNode(TreeNodeT * root, LSQ_IntegerIndexT key);
+static IteratorT * createIterator(LSQ_HandleT handle, TreeNodeT * node);
+static __inline int nodeRank(const TreeNodeT * node);
+static __inline int isLeaf(const TreeNodeT * node);
+static void replaceNode(WAVLTreeT * tree, TreeNodeT * node, TreeNodeT * substitute);
+static void leftRotate(WAVLTreeT * tree, TreeNodeT * root);
+static void rightRotate(WAVLTreeT * tree, TreeNodeT * root);
+static void fixAfterInsert(WAVLTreeT * tree, TreeNodeT * node);
+static void fixAfterDelete(WAVLTreeT * tree, TreeNodeT * node, TreeNodeT * parent);
+static __inline void changeRank(WAVLTreeT * tree, TreeNodeT * node, int delta);
+static void removeNode(WAVLTreeT * tree, TreeNodeT * node);
+static int sumDepths(const TreeNodeT * root, int depth, long long * total);
+
+static void treeWalkWithDestruction(WAVLTreeT * tree, TreeNodeT * root)
+{
+	if (root == NULL)
+		return;
+	treeWalkWithDestruction(tree, root->r_child);
+	treeWalkWithDestruction(tree, root->l_child);
+	lsqDeallocate(tree->allocator, root, sizeof(TreeNodeT));
+}
+
+static TreeNodeT * successor(TreeNodeT * node)
+{
+	TreeNodeT * parent = NULL;
+	if (node == NULL)
+		return NULL;
+	if (node->r_child != NULL)
+		return treeMinimum(node->r_child);
+	for (parent = node->parent; parent != NULL && node == parent->r_child; parent = parent->parent)
+		node = parent;
+	return parent;
+}
+
+static TreeNodeT * predecessor(TreeNodeT * node)
+{
+	TreeNodeT * parent = NULL;
+	if (node == NULL)
+		return NULL;
+	if (node->l_child != NULL)
+		return treeMaximum(node->l_child);
+	for (parent = node->parent; parent != NULL && node == parent->l_child; parent = parent->parent)
+		node = parent;
+	return parent;
+}
+
+static TreeNodeT * treeMaximum(TreeNodeT * root)
+{
+	if (root == NULL)
+		return NULL;
+	while (root->r_child != NULL)
+		root = root->r_child;
+	return root;
+}
+
+static TreeNodeT * treeMinimum(TreeNodeT * root)
+{
+	if (root == NULL)
+		return NULL;
+	while (root->l_child != NULL)
+		root = root->l_child;
+	return root;
+}
+
+static TreeNodeT * findNode(TreeNodeT * root, LSQ_IntegerIndexT key)
+{
+	while (root != NULL && root->key != key)
+		root = (key > root->key) ? root->r_child : root->l_child;
+	return root;
+}
+
+static IteratorT * createIterator(LSQ_HandleT handle, TreeNodeT * node)
+{
+	IteratorT * iterator = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return LSQ_HandleInvalid;
+	iterator = (IteratorT *)lsqAllocate(((WAVLTreeT *)handle)->allocator, sizeof(IteratorT));
+	if (iterator == NULL)
+		return LSQ_HandleInvalid;
+	iterator->allocator = ((WAVLTreeT *)handle)->allocator;
+	iterator->tree = (WAVLTreeT *)handle;
+	iterator->node = node;
+	iterator->state = node != NULL ? IST_DEREFERENCABLE : IST_PAST_REAR;
+	return iterator;
+}
+
+static __inline int nodeRank(const TreeNodeT * node)
+{
+	return node != NULL ? node->rank : -1;
+}
+
+static __inline int isLeaf(const TreeNodeT * node)
+{
+	return node->l_child == NULL && node->r_child == NULL;
+}
+
+static __inline void changeRank(WAVLTreeT * tree, TreeNodeT * node, int delta)
+{
+	node->rank += delta;
+	tree->rebalance_steps++;
+}
+
+static void replaceNode(WAVLTreeT * tree, TreeNodeT * node, TreeNodeT * substitute)
+{
+	if (substitute != NULL)
+		substitute->parent = node->parent;
+	if (node->parent == NULL)
+		tree->root = substitute;
+	else if (node->parent->l_child == node)
+		node->parent->l_child = substitute;
+	else
+		node->parent->r_child = substitute;
+}
+
+static void leftRotate(WAVLTreeT * tree, TreeNodeT * root)
+{
+	TreeNodeT * node = root->r_child;
+	root->r_child = node->l_child;
+	if (node->l_child != NULL)
+		node->l_child->parent = root;
+	replaceNode(tree, root, node);
+	node->l_child = root;
+	root->parent = node;
+	tree->rotations++;
+}
+
+static void rightRotate(WAVLTreeT * tree, TreeNodeT * root)
+{
+	TreeNodeT * node = root->l_child;
+	root->l_child = node->r_child;
+	if (node->r_child != NULL)
+		node->r_child->parent = root;
+	replaceNode(tree, root, node);
+	node->r_child = root;
+	root->parent = node;
+	tree->rotations++;
+}
+
+/* Repairs a rank difference of 0 between node and its parent, starting from the freshly inserted leaf */
+static void fixAfterInsert(WAVLTreeT * tree, TreeNodeT * node)
+{
+	TreeNodeT * parent = NULL, * sibling = NULL, * inner = NULL;
+	while ((parent = node->parent) != NULL && parent->rank == node->rank)
+	{
+		sibling = (node == parent->l_child) ? parent->r_child : parent->l_child;
+		if (parent->rank - nodeRank(sibling) == 1)
+		{
+			changeRank(tree, parent, 1);
+			node = parent;
+			continue;
+		}
+		inner = (node == parent->l_child) ? node->r_child : node->l_child;
+		if (node->rank - nodeRank(inner) == 2)
+		{
+			if (node == parent->l_child)
+				rightRotate(tree, parent);
+			else
+				leftRotate(tree, parent);
+			changeRank(tree, parent, -1);
+		}
+		else
+		{
+			if (node == parent->l_child)
+			{
+				leftRotate(tree, node);
+				rightRotate(tree, parent);
+			}
+			else
+			{
+				rightRotate(tree, node);
+				leftRotate(tree, parent);
+			}
+			changeRank(tree, inner, 1);
+			changeRank(tree, node, -1);
+			changeRank(tree, parent, -1);
+		}
+		break;
+	}
+}
+
+/* Repairs a rank difference of 3 between node, which may be NULL, and parent, or a leaf parent of rank 1 */
+static void fixAfterDelete(WAVLTreeT * tree, TreeNodeT * node, TreeNodeT * parent)
+{
+	TreeNodeT * sibling = NULL, * inner = NULL, * outer = NULL;
+	if (parent != NULL && isLeaf(parent) && parent->rank == 1)
+	{
+		changeRank(tree, parent, -1);
+		node = parent;
+		parent = node->parent;
+	}
+	while (parent != NULL && parent->rank - nodeRank(node) == 3)
+	{
+		sibling = (node == parent->l_child) ? parent->r_child : parent->l_child;
+		if (parent->rank - sibling->rank == 2)
+		{
+			changeRank(tree, parent, -1);
+			node = parent;
+			parent = node->parent;
+			continue;
+		}
+		inner = (node == parent->l_child) ? sibling->l_child : sibling->r_child;
+		outer = (node == parent->l_child) ? sibling->r_child : sibling->l_child;
+		if (sibling->rank - nodeRank(inner) == 2 && sibling->rank - nodeRank(outer) == 2)
+		{
+			changeRank(tree, parent, -1);
+			changeRank(tree, sibling, -1);
+			node = parent;
+			parent = node->parent;
+			continue;
+		}
+		if (sibling->rank - nodeRank(outer) == 1)
+		{
+			if (node == parent->l_child)
+				leftRotate(tree, parent);
+			else
+				rightRotate(tree, parent);
+			changeRank(tree, sibling, 1);
+			changeRank(tree, parent, isLeaf(parent) ? -2 : -1);
+		}
+		else
+		{
+			if (node == parent->l_child)
+			{
+				rightRotate(tree, sibling);
+				leftRotate(tree, parent);
+			}
+			else
+			{
+				leftRotate(tree, sibling);
+				rightRotate(tree, parent);
+			}
+			changeRank(tree, inner, 2);
+			changeRank(tree, sibling, -1);
+			changeRank(tree, parent, -2);
+		}
+		break;
+	}
+}
+
+static void removeNode(WAVLTreeT * tree, TreeNodeT * node)
+{
+	TreeNodeT * next = NULL, * child = NULL, * parent = NULL;
+	if (node->l_child == NULL || node->r_child == NULL)
+	{
+		child = (node->l_child != NULL) ? node->l_child : node->r_child;
+		parent = node->parent;
+		replaceNode(tree, node, child);
+	}
+	else
+	{
+		next = treeMinimum(node->r_child);
+		child = next->r_child;
+		if (next->parent == node)
+			parent = next;
+		else
+		{
+			parent = next->parent;
+			replaceNode(tree, next, child);
+			next->r_child = node->r_child;
+			next->r_child->parent = next;
+		}
+		replaceNode(tree, node, next);
+		next->l_child = node->l_child;
+		next->l_child->parent = next;
+		next->rank = node->rank;
+	}
+	lsqDeallocate(tree->allocator, node, sizeof(TreeNodeT));
+	tree->size--;
+	fixAfterDelete(tree, child, parent);
+}
+
+/* Returns the height of the subtree and adds the depths of its nodes to total */
+static int sumDepths(const TreeNodeT * root, int depth, long long * total)
+{
+	int l_height, r_height;
+	if (root == NULL)
+		return 0;
+	*total += depth;
+	l_height = sumDepths(root->l_child, depth + 1, total);
+	r_height = sumDepths(root->r_child, depth + 1, total);
+	return 1 + (l_height > r_height ? l_height : r_height);
+}
+
+extern LSQ_HandleT LSQ_CreateSequence(void)
+{
+	return LSQ_CreateSequenceWithAllocator(NULL);
+}
+
+extern LSQ_HandleT LSQ_CreateSequenceWithAllocator(const LSQ_AllocatorT * allocator)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)lsqAllocate(allocator, sizeof(WAVLTreeT));
+	if (tree == NULL)
+		return LSQ_HandleInvalid;
+	tree->allocator = allocator;
+	tree->size = 0;
+	tree->root = NULL;
+	tree->rotations = 0;
+	tree->rebalance_steps = 0;
+	return tree;
+}
+
+extern void LSQ_DestroySequence(LSQ_HandleT handle)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || lsqReleasesInBulk(tree->allocator))
+		return;
+	treeWalkWithDestruction(tree, tree->root);
+	lsqDeallocate(tree->allocator, tree, sizeof(WAVLTreeT));
+}
+
+extern LSQ_IntegerIndexT LSQ_GetSize(LSQ_HandleT handle)
+{
+	return IS_HANDLE_INVALID(handle) ? -1 : ((WAVLTreeT *)handle)->size;
+}
+
+extern int LSQ_IsIteratorDereferencable(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_DEREFERENCABLE;
+}
+
+extern int LSQ_IsIteratorPastRear(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_PAST_REAR;
+}
+
+extern int LSQ_IsIteratorBeforeFirst(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !IS_HANDLE_INVALID(iterator) && iter->state == IST_BEFORE_FIRST;
+}
+
+extern LSQ_BaseTypeT* LSQ_DereferenceIterator(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	return !LSQ_IsIteratorDereferencable(iterator) ? NULL : &iter->node->value;
+}
+
+extern LSQ_IntegerIndexT LSQ_GetIteratorKey(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	assert(LSQ_IsIteratorDereferencable(iterator));
+	return iter->node->key;
+}
+
+extern LSQ_IteratorT LSQ_GetElementByIndex(LSQ_HandleT handle, LSQ_IntegerIndexT index)
+{
+	if IS_HANDLE_INVALID(handle)
+		return LSQ_HandleInvalid;
+	return createIterator(handle, findNode(((WAVLTreeT *)handle)->root, index));
+}
+
+extern LSQ_IteratorT LSQ_GetFrontElement(LSQ_HandleT handle)
+{
+	if IS_HANDLE_INVALID(handle)
+		return LSQ_HandleInvalid;
+	return createIterator(handle, treeMinimum(((WAVLTreeT *)handle)->root));
+}
+
+extern LSQ_IteratorT LSQ_GetPastRearElement(LSQ_HandleT handle)
+{
+	if IS_HANDLE_INVALID(handle)
+		return LSQ_HandleInvalid;
+	return createIterator(handle, NULL);
+}
+
+extern void LSQ_DestroyIterator(LSQ_IteratorT iterator)
+{
+	if (IS_HANDLE_INVALID(iterator))
+		return;
+	lsqDeallocate(((IteratorT *)iterator)->allocator, iterator, sizeof(IteratorT));
+}
+
+extern void LSQ_AdvanceOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || iter->tree->size == 0 || iter->state == IST_PAST_REAR)
+		return;
+	iter->node = (iter->state == IST_BEFORE_FIRST) ? treeMinimum(iter->tree->root) : successor(iter->node);
+	iter->state = (iter->node != NULL) ? IST_DEREFERENCABLE : IST_PAST_REAR;
+}
+
+extern void LSQ_RewindOneElement(LSQ_IteratorT iterator)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if (IS_HANDLE_INVALID(iterator) || iter->tree->size == 0 || iter->state == IST_BEFORE_FIRST)
+		return;
+	iter->node = (iter->state == IST_PAST_REAR) ? treeMaximum(iter->tree->root) : predecessor(iter->node);
+	iter->state = (iter->node != NULL) ? IST_DEREFERENCABLE : IST_BEFORE_FIRST;
+}
+
+extern void LSQ_ShiftPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT shift)
+{
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	for(; shift > 0; shift--)
+		LSQ_AdvanceOneElement(iterator);
+	for(; shift < 0; shift++)
+		LSQ_RewindOneElement(iterator);
+}
+
+extern void LSQ_SetPosition(LSQ_IteratorT iterator, LSQ_IntegerIndexT pos)
+{
+	IteratorT * iter = (IteratorT *)iterator;
+	if IS_HANDLE_INVALID(iterator)
+		return;
+	iter->state = IST_BEFORE_FIRST;
+	LSQ_ShiftPosition(iterator, pos + 1);
+}
+
+extern void LSQ_InsertElement(LSQ_HandleT handle, LSQ_IntegerIndexT key, LSQ_BaseTypeT value)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)handle;
+	TreeNodeT * node = NULL, * parent = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	for (node = tree->root; node != NULL; node = (key > node->key) ? node->r_child : node->l_child)
+	{
+		if (node->key == key)
+		{
+			node->value = value;
+			return;
+		}
+		parent = node;
+	}
+	node = (TreeNodeT *)lsqAllocate(tree->allocator, sizeof(TreeNodeT));
+	if (node == NULL)
+		return;
+	node->key = key;
+	node->value = value;
+	node->l_child = NULL;
+	node->r_child = NULL;
+	node->parent = parent;
+	node->rank = 0;
+	if (parent == NULL)
+		tree->root = node;
+	else if (key > parent->key)
+		parent->r_child = node;
+	else
+		parent->l_child = node;
+	tree->size++;
+	fixAfterInsert(tree, node);
+}
+
+extern void LSQ_DeleteFrontElement(LSQ_HandleT handle)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || tree->root == NULL)
+		return;
+	removeNode(tree, treeMinimum(tree->root));
+}
+
+extern void LSQ_DeleteRearElement(LSQ_HandleT handle)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle) || tree->root == NULL)
+		return;
+	removeNode(tree, treeMaximum(tree->root));
+}
+
+extern void LSQ_DeleteElement(LSQ_HandleT handle, LSQ_IntegerIndexT key)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)handle;
+	TreeNodeT * node = NULL;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	node = findNode(tree->root, key);
+	if (node != NULL)
+		removeNode(tree, node);
+}
+
+extern void LSQ_GetTreeStats(LSQ_HandleT handle, LSQ_TreeStatsT * stats)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)handle;
+	long long total_depth = 0;
+	if (IS_HANDLE_INVALID(handle) || stats == NULL)
+		return;
+	stats->rotations = tree->rotations;
+	stats->rebalance_steps = tree->rebalance_steps;
+	stats->height = sumDepths(tree->root, 1, &total_depth);
+	stats->average_depth = (tree->size > 0) ? (double)total_depth / tree->size : 0.0;
+}
+
+extern void LSQ_ResetTreeStats(LSQ_HandleT handle)
+{
+	WAVLTreeT * tree = (WAVLTreeT *)handle;
+	if (IS_HANDLE_INVALID(handle))
+		return;
+	tree->rotations = 0;
+	tree->rebalance_steps = 0;
+}